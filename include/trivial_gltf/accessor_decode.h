@@ -0,0 +1,44 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_ACCESSOR_DECODE_H_INCLUDED
+#define TRIVIAL_GLTF_ACCESSOR_DECODE_H_INCLUDED
+
+#include <trivial_gltf/accessor_view.h>
+
+namespace trivial_gltf
+{
+enum class simd_level : uint8_t
+{
+    scalar,
+    sse2,
+    avx2
+};
+
+// Kernel set picked at startup from the cpu features, can be lowered to compare against the scalar path.
+simd_level active_simd_level() noexcept;
+void       force_simd_level(simd_level level) noexcept;
+
+// Bulk conversions over tightly packed scalars. Normalized integers are mapped onto [0, 1] or [-1, 1]
+// as required by the gltf spec, everything else is converted by value.
+void convert_to_float(component c, bool normalized, void const* src, float* dst, size_t scalars) noexcept;
+void convert_to_half(float const* src, uint16_t* dst, size_t scalars) noexcept;
+void widen_to_uint32(component c, void const* src, uint32_t* dst, size_t scalars) noexcept;
+
+// Accessor level conversions, writing count * component_count(type) values. Strided and padded data is
+// repacked block wise before it is converted, sparse substitutions are applied. Return the number of values
+// written, zero if the accessor does not resolve to buffer data or the output is too small.
+size_t decode_floats(doc const& d, accessor const& acc, std::span<float> out) noexcept;
+size_t decode_halfs(doc const& d, accessor const& acc, std::span<uint16_t> out) noexcept;
+size_t widen_indices(doc const& d, accessor const& acc, std::span<uint32_t> out) noexcept;
+
+// Expands the accessor into count tightly packed elements of its own component type, with the sparse
+// substitutions applied, e.g. for upload. Returns the number of bytes written, zero if the accessor does not
+// resolve or out is too small.
+size_t materialize_accessor(doc const& d, accessor const& acc, std::span<std::byte> out) noexcept;
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,410 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_ACCESSOR_VIEW_H_INCLUDED
+#define TRIVIAL_GLTF_ACCESSOR_VIEW_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <cstring>
+#include <compare>
+#include <iterator>
+#include <type_traits>
+
+namespace trivial_gltf
+{
+constexpr size_t component_size(component c) noexcept
+{
+    switch (c)
+    {
+        case component::byte_type:
+        case component::unsigned_byte_type: return 1;
+        case component::short_type:
+        case component::unsigned_short_type: return 2;
+        case component::unsigned_int_type:
+        case component::float_type: return 4;
+    }
+    return 0;
+}
+
+constexpr size_t column_count(attribute_type t) noexcept
+{
+    switch (t)
+    {
+        case attribute_type::mat2: return 2;
+        case attribute_type::mat3: return 3;
+        case attribute_type::mat4: return 4;
+        default: return 1;
+    }
+}
+
+constexpr size_t component_count(attribute_type t) noexcept
+{
+    switch (t)
+    {
+        case attribute_type::scalar: return 1;
+        case attribute_type::vec2: return 2;
+        case attribute_type::vec3: return 3;
+        case attribute_type::vec4:
+        case attribute_type::mat2: return 4;
+        case attribute_type::mat3: return 9;
+        case attribute_type::mat4: return 16;
+    }
+    return 0;
+}
+
+// matrix columns start 4 byte aligned, which pads byte and short matrices
+constexpr size_t column_stride(component c, attribute_type t) noexcept
+{
+    auto const rows = component_count(t) / column_count(t);
+    return (rows * component_size(c) + 3) & ~size_t{3};
+}
+
+constexpr size_t element_size(component c, attribute_type t) noexcept
+{
+    if (column_count(t) == 1) return component_count(t) * component_size(c);
+    return column_count(t) * column_stride(c, t);
+}
+
+template <typename S>
+constexpr component component_of() noexcept
+{
+    if constexpr (std::is_same_v<S, int8_t>) return component::byte_type;
+    else if constexpr (std::is_same_v<S, uint8_t>) return component::unsigned_byte_type;
+    else if constexpr (std::is_same_v<S, int16_t>) return component::short_type;
+    else if constexpr (std::is_same_v<S, uint16_t>) return component::unsigned_short_type;
+    else if constexpr (std::is_same_v<S, uint32_t>) return component::unsigned_int_type;
+    else
+    {
+        static_assert(std::is_same_v<S, float>, "not a gltf component type");
+        return component::float_type;
+    }
+}
+
+// Describes how an element type maps onto accessor component and type, and how it is read from a buffer.
+template <typename T>
+struct element_traits
+{
+    using scalar_type                         = T;
+    static constexpr attribute_type type      = attribute_type::scalar;
+    static constexpr component      comp_type = component_of<T>();
+    static T                        load(std::byte const* src) noexcept
+    {
+        T r;
+        std::memcpy(&r, src, sizeof(T));
+        return r;
+    }
+};
+
+template <glm::length_t N, typename T, glm::qualifier Q>
+struct element_traits<glm::vec<N, T, Q>>
+{
+    using scalar_type                         = T;
+    static constexpr attribute_type type      = static_cast<attribute_type>(N - 1);
+    static constexpr component      comp_type = component_of<T>();
+    static glm::vec<N, T, Q>        load(std::byte const* src) noexcept
+    {
+        glm::vec<N, T, Q> r;
+        std::memcpy(&r[0], src, N * sizeof(T));
+        return r;
+    }
+};
+
+template <glm::length_t C, typename T, glm::qualifier Q>
+struct element_traits<glm::mat<C, C, T, Q>>
+{
+    using scalar_type                         = T;
+    static constexpr attribute_type type      = static_cast<attribute_type>(C + 2);
+    static constexpr component      comp_type = component_of<T>();
+    static glm::mat<C, C, T, Q>     load(std::byte const* src) noexcept
+    {
+        glm::mat<C, C, T, Q> r;
+        for (glm::length_t c = 0; c != C; ++c) std::memcpy(&r[c][0], src + c * column_stride(comp_type, type), C * sizeof(T));
+        return r;
+    }
+};
+
+// Random access range over the elements of an accessor, honoring the stride of the buffer view.
+// Elements are read by value, so unaligned buffer contents are fine.
+template <typename T>
+class accessor_view
+{
+   public:
+    using value_type = T;
+    using traits     = element_traits<T>;
+
+    class iterator
+    {
+       public:
+        using iterator_concept  = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(std::byte const* p, size_t s) noexcept : pos{p}, stride{static_cast<difference_type>(s)} {}
+
+        T         operator*() const noexcept { return traits::load(pos); }
+        T         operator[](difference_type n) const noexcept { return traits::load(pos + n * stride); }
+        iterator& operator++() noexcept
+        {
+            pos += stride;
+            return *this;
+        }
+        iterator operator++(int) noexcept
+        {
+            auto r = *this;
+            pos += stride;
+            return r;
+        }
+        iterator& operator--() noexcept
+        {
+            pos -= stride;
+            return *this;
+        }
+        iterator operator--(int) noexcept
+        {
+            auto r = *this;
+            pos -= stride;
+            return r;
+        }
+        iterator& operator+=(difference_type n) noexcept
+        {
+            pos += n * stride;
+            return *this;
+        }
+        iterator& operator-=(difference_type n) noexcept
+        {
+            pos -= n * stride;
+            return *this;
+        }
+        friend iterator        operator+(iterator i, difference_type n) noexcept { return i += n; }
+        friend iterator        operator+(difference_type n, iterator i) noexcept { return i += n; }
+        friend iterator        operator-(iterator i, difference_type n) noexcept { return i -= n; }
+        friend difference_type operator-(iterator const& l, iterator const& r) noexcept
+        {
+            return l.stride ? (l.pos - r.pos) / l.stride : 0;
+        }
+        friend bool            operator==(iterator const& l, iterator const& r) noexcept { return l.pos == r.pos; }
+        friend auto            operator<=>(iterator const& l, iterator const& r) noexcept { return l.pos <=> r.pos; }
+
+       private:
+        std::byte const* pos{nullptr};
+        difference_type  stride{0};
+    };
+
+    accessor_view() = default;
+    accessor_view(std::byte const* data, size_t count, size_t stride) noexcept : first{data}, elements{count}, step{stride} {}
+
+    iterator         begin() const noexcept { return {first, step}; }
+    iterator         end() const noexcept { return {first + elements * step, step}; }
+    T                operator[](size_t i) const noexcept { return traits::load(first + i * step); }
+    size_t           size() const noexcept { return elements; }
+    bool             empty() const noexcept { return elements == 0; }
+    size_t           stride() const noexcept { return step; }
+    std::byte const* data() const noexcept { return first; }
+
+   private:
+    std::byte const* first{nullptr};
+    size_t           elements{0};
+    size_t           step{0};
+};
+
+// Byte range of the accessor elements and their stride, empty if the accessor does not fit into its buffer view.
+struct accessor_bytes
+{
+    std::byte const* data{nullptr};
+    size_t           count{0};
+    size_t           stride{0};
+};
+
+inline accessor_bytes resolve_accessor(doc const& d, accessor const& acc) noexcept
+{
+    auto const view = view_data(d, acc.view);
+    auto const size = element_size(acc.comp_type, acc.type);
+    if (view.empty() || size == 0 || acc.count == 0) return {};
+    auto const stride = d.buffer_views[acc.view].stride ? d.buffer_views[acc.view].stride : size;
+    if (size_t{acc.offset} + stride * (acc.count - 1) + size > view.size()) return {};
+    return {view.data() + acc.offset, acc.count, stride};
+}
+
+// Typed view onto the accessor, empty unless T matches the component and attribute type of the accessor.
+template <typename T>
+accessor_view<T> make_accessor_view(doc const& d, accessor const& acc) noexcept
+{
+    using traits = element_traits<T>;
+    if (acc.comp_type != traits::comp_type || acc.type != traits::type) return {};
+    auto const bytes = resolve_accessor(d, acc);
+    return {bytes.data, bytes.count, bytes.stride};
+}
+
+// Sparse indices and substituted values of an accessor, empty if it is dense or they do not fit their buffer views.
+struct sparse_bytes
+{
+    std::byte const* indices{nullptr};
+    std::byte const* values{nullptr};
+    size_t           count{0};
+    component        index_type{component::unsigned_int_type};
+
+    uint32_t index(size_t k) const noexcept
+    {
+        switch (index_type)
+        {
+            case component::unsigned_byte_type: return std::to_integer<uint32_t>(indices[k]);
+            case component::unsigned_short_type:
+            {
+                uint16_t i;
+                std::memcpy(&i, indices + 2 * k, sizeof i);
+                return i;
+            }
+            default:
+            {
+                uint32_t i;
+                std::memcpy(&i, indices + 4 * k, sizeof i);
+                return i;
+            }
+        }
+    }
+};
+
+inline sparse_bytes resolve_sparse(doc const& d, accessor const& acc) noexcept
+{
+    auto const& s = acc.sparse;
+    if (s.count == 0 || (s.indices_type != component::unsigned_byte_type && s.indices_type != component::unsigned_short_type &&
+                         s.indices_type != component::unsigned_int_type))
+        return {};
+    auto const indices = view_data(d, s.indices_view);
+    auto const values  = view_data(d, s.values_view);
+    if (size_t{s.indices_offset} + s.count * component_size(s.indices_type) > indices.size() ||
+        size_t{s.values_offset} + s.count * element_size(acc.comp_type, acc.type) > values.size())
+        return {};
+    return {indices.data() + s.indices_offset, values.data() + s.values_offset, s.count, s.indices_type};
+}
+
+// Elements of an accessor with its sparse substitutions applied on access, without expanding them into a dense
+// array. Random access binary searches the sparse indices, iteration walks them alongside the elements.
+template <typename T>
+class sparse_accessor_view
+{
+   public:
+    using value_type = T;
+    using traits     = element_traits<T>;
+
+    class iterator
+    {
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(sparse_accessor_view const* v, size_t i, size_t k) noexcept : view{v}, index{i}, next{k} {}
+
+        T         operator*() const noexcept { return substituted() ? view->value(next) : view->dense(index); }
+        iterator& operator++() noexcept
+        {
+            if (substituted()) ++next;
+            ++index;
+            return *this;
+        }
+        iterator operator++(int) noexcept
+        {
+            auto r = *this;
+            ++*this;
+            return r;
+        }
+        friend bool operator==(iterator const& l, iterator const& r) noexcept { return l.index == r.index; }
+
+       private:
+        bool substituted() const noexcept { return next < view->sparse.count && view->sparse.index(next) == index; }
+
+        sparse_accessor_view const* view{nullptr};
+        size_t                      index{0};
+        size_t                      next{0};  // first sparse entry at or after index
+    };
+
+    sparse_accessor_view() = default;
+    sparse_accessor_view(accessor_view<T> base, size_t count, sparse_bytes substitutes) noexcept
+        : base{base}, elements{count}, sparse{substitutes}
+    {
+    }
+
+    iterator begin() const noexcept { return {this, 0, 0}; }
+    iterator end() const noexcept { return {this, elements, sparse.count}; }
+    T        operator[](size_t i) const noexcept
+    {
+        size_t lo = 0, hi = sparse.count;
+        while (lo < hi)
+        {
+            auto const mid = lo + (hi - lo) / 2;
+            if (sparse.index(mid) < i)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo < sparse.count && sparse.index(lo) == i ? value(lo) : dense(i);
+    }
+    size_t size() const noexcept { return elements; }
+    bool   empty() const noexcept { return elements == 0; }
+
+   private:
+    // elements of an accessor without buffer view are zero
+    T dense(size_t i) const noexcept { return base.empty() ? T{} : base[i]; }
+    T value(size_t k) const noexcept { return traits::load(sparse.values + k * element_size(traits::comp_type, traits::type)); }
+
+    accessor_view<T> base;
+    size_t           elements{0};
+    sparse_bytes     sparse;
+};
+
+// Typed sparse view onto the accessor, empty unless T matches its component and attribute type and the dense
+// and sparse data resolve. Works on dense accessors too.
+template <typename T>
+sparse_accessor_view<T> make_sparse_accessor_view(doc const& d, accessor const& acc) noexcept
+{
+    using traits = element_traits<T>;
+    if (acc.comp_type != traits::comp_type || acc.type != traits::type) return {};
+    auto const base   = make_accessor_view<T>(d, acc);
+    auto const sparse = resolve_sparse(d, acc);
+    if ((base.empty() && acc.view < d.buffer_views.size()) || (acc.sparse.count && !sparse.indices)) return {};
+    return {base, acc.count, sparse};
+}
+
+namespace detail
+{
+template <typename S, typename Visitor>
+decltype(auto) visit_element_type(doc const& d, accessor const& acc, Visitor&& v)
+{
+    switch (acc.type)
+    {
+        case attribute_type::vec2: return v(make_accessor_view<glm::vec<2, S>>(d, acc));
+        case attribute_type::vec3: return v(make_accessor_view<glm::vec<3, S>>(d, acc));
+        case attribute_type::vec4: return v(make_accessor_view<glm::vec<4, S>>(d, acc));
+        case attribute_type::mat2: return v(make_accessor_view<glm::mat<2, 2, S>>(d, acc));
+        case attribute_type::mat3: return v(make_accessor_view<glm::mat<3, 3, S>>(d, acc));
+        case attribute_type::mat4: return v(make_accessor_view<glm::mat<4, 4, S>>(d, acc));
+        default: return v(make_accessor_view<S>(d, acc));
+    }
+}
+}  // namespace detail
+
+// Calls the visitor once with the accessor_view matching the component and attribute type of the accessor,
+// so that per element code is specialized for the concrete type.
+template <typename Visitor>
+decltype(auto) visit_accessor(doc const& d, accessor const& acc, Visitor&& v)
+{
+    switch (acc.comp_type)
+    {
+        case component::byte_type: return detail::visit_element_type<int8_t>(d, acc, v);
+        case component::unsigned_byte_type: return detail::visit_element_type<uint8_t>(d, acc, v);
+        case component::short_type: return detail::visit_element_type<int16_t>(d, acc, v);
+        case component::unsigned_short_type: return detail::visit_element_type<uint16_t>(d, acc, v);
+        case component::unsigned_int_type: return detail::visit_element_type<uint32_t>(d, acc, v);
+        default: return detail::visit_element_type<float>(d, acc, v);
+    }
+}
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,68 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_ANIMATION_SAMPLING_H_INCLUDED
+#define TRIVIAL_GLTF_ANIMATION_SAMPLING_H_INCLUDED
+
+#include <trivial_gltf/flat_scene.h>
+
+namespace trivial_gltf
+{
+// Keyframes of one doc animation decoded to float once, shared by all instances that play it.
+struct animation_clip
+{
+    struct track
+    {
+        int32_t            node;
+        path_type          path;
+        interpolation_type interpolation;
+        uint32_t           width;          // floats per value, 3, 4 or the number of morph targets
+        uint32_t           first_key;      // into times
+        uint32_t           key_count;
+        uint32_t           first_value;    // into values, cubic splines store in tangent, value, out tangent per key
+        uint32_t           weight_offset;  // into animation_instance::weights for weight tracks
+    };
+
+    animation_clip() = default;
+    // channels whose sampler does not resolve to float convertible accessor data are dropped
+    animation_clip(doc const& d, animation const& a);
+
+    std::vector<track> tracks;               // linear and step rotations first, those are sampled four at a time
+    size_t             batched_rotations{0};
+    std::vector<float> times;
+    std::vector<float> values;
+    float              duration{0.0f};
+    uint32_t           weight_count{0};  // morph weights written per instance
+};
+
+// One playing copy of a clip driving the local transforms of a flat_scene.
+struct animation_instance
+{
+    animation_instance(animation_clip const& clip, flat_scene& target);
+
+    animation_clip const* clip;
+    flat_scene*           target;
+    float                 time{0.0f};  // clamped to the keyframe range of each track, loop by wrapping it
+    std::vector<int32_t>  slots;       // slot in target per track, -1 when the node is not part of it
+    std::vector<uint32_t> cursors;     // last key at or before the previous sample time per track
+    std::vector<float>    weights;     // morph weights of the weight tracks, see track::weight_offset
+};
+
+enum class rotation_blend : uint8_t
+{
+    nlerp,  // normalized lerp, vectorized across tracks
+    slerp
+};
+
+// Samples every track of every instance at the instance time. Transforms are written into the target scene,
+// which marks the slots for flat_scene::update_world_transforms. Sequential playback moves the keyframe cursors
+// forward in amortized constant time, jumps fall back to a binary search. With a pool the instances are
+// sampled in parallel, so instances sharing a target scene must be sampled without one.
+void sample_animations(std::span<animation_instance> instances, thread_pool* pool = nullptr,
+                       rotation_blend blend = rotation_blend::nlerp);
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,33 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_BATCH_LOADER_H_INCLUDED
+#define TRIVIAL_GLTF_BATCH_LOADER_H_INCLUDED
+
+#include <trivial_gltf/mapped_asset.h>
+#include <trivial_gltf/thread_pool.h>
+
+namespace trivial_gltf
+{
+struct batch_entry
+{
+    doc         document;
+    parse_state state{parse_state::more_input_needed};
+};
+
+// Parses many in memory .gltf or .glb sources in parallel, entry i belongs to sources[i]. Every worker reuses
+// one parser for all of its sources. Sources are not copied, glb BIN chunks are bound in place, so the sources
+// have to outlive the docs.
+std::vector<batch_entry> parse_batch(std::span<std::span<std::byte const> const> sources, thread_pool& pool,
+                                     parse_options options = parse_options::all);
+
+// Maps and parses many files in parallel, entry i belongs to files[i]. The per file status is the state() of
+// each mapped_asset.
+std::vector<std::unique_ptr<mapped_asset>> load_batch(std::span<std::filesystem::path const> files, thread_pool& pool,
+                                                      parse_options options = parse_options::all);
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,76 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_FLAT_SCENE_H_INCLUDED
+#define TRIVIAL_GLTF_FLAT_SCENE_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <array>
+#include <span>
+#include <vector>
+
+namespace trivial_gltf
+{
+class thread_pool;
+
+// Node hierarchy of one scene flattened for per frame evaluation. Nodes are stored in depth first order, so a
+// parent always precedes its children and the subtree of a slot occupies the slots [slot, subtree_end(slot)).
+// Local transforms are kept as structure of arrays, world transforms as column major matrices.
+class flat_scene
+{
+   public:
+    flat_scene() = default;
+    // flattens d.scenes[scene], or all nodes without a parent when the doc has no such scene
+    flat_scene(doc const& d, size_t scene);
+
+    size_t size() const noexcept { return parents.size(); }
+    // slot of doc node index n, -1 if the node is not part of the scene
+    int32_t                    slot(uint32_t n) const noexcept { return n < slots.size() ? slots[n] : -1; }
+    int32_t                    parent(size_t slot) const noexcept { return parents[slot]; }
+    uint32_t                   subtree_end(size_t slot) const noexcept { return ends[slot]; }
+    uint32_t                   node(size_t slot) const noexcept { return nodes[slot]; }
+    glm::mat4 const&           world(size_t slot) const noexcept { return worlds[slot]; }
+    std::span<glm::mat4 const> world_transforms() const noexcept { return worlds; }
+
+    glm::vec3       translation(size_t slot) const noexcept;
+    glm::qua<float> rotation(size_t slot) const noexcept;
+    glm::vec3       scale(size_t slot) const noexcept;
+    // change the local transform and mark the subtree for update_world_transforms
+    void set_translation(size_t slot, glm::vec3 const& t) noexcept;
+    void set_rotation(size_t slot, glm::qua<float> const& r) noexcept;
+    void set_scale(size_t slot, glm::vec3 const& s) noexcept;
+
+    // Evaluates all world transforms. With a pool, subtrees are evaluated in parallel.
+    void compute_world_transforms(thread_pool* pool = nullptr);
+    // Evaluates only the subtrees below slots changed since the last evaluation.
+    void update_world_transforms(thread_pool* pool = nullptr);
+
+   private:
+    struct range
+    {
+        uint32_t begin, end;
+    };
+    void mark(size_t slot) noexcept;
+    void partition(range siblings, std::vector<uint32_t>& spine, std::vector<range>& tasks) const;
+    void evaluate(std::span<uint32_t const> spine, std::span<range const> tasks, thread_pool* pool);
+    void evaluate(range r) noexcept;
+
+    std::vector<int32_t>              parents;       // slot of the parent, -1 for roots
+    std::vector<uint32_t>             ends;          // end of the subtree
+    std::vector<uint32_t>             nodes;         // index into doc::nodes
+    std::vector<int32_t>              slots;         // inverse of nodes
+    std::array<std::vector<float>, 3> translations;  // [component][slot]
+    std::array<std::vector<float>, 4> rotations;     // x, y, z, w
+    std::array<std::vector<float>, 3> scales;
+    std::vector<glm::mat4>            worlds;
+    std::vector<uint8_t>              dirty;
+    std::vector<uint32_t>             changed;       // slots marked dirty
+    std::vector<uint32_t>             full_spine;
+    std::vector<range>                full_tasks;
+};
+}  // namespace trivial_gltf
+
+#endif
@@ -11,40 +11,45 @@
 #include <glm/gtx/quaternion.hpp>
 #include <vector>
 #include <string>
+#include <memory_resource>
 #include <variant>
+#include <type_traits>
 #include <utility>
 #include <functional>
 #include <span>
+#include <cstddef>
+#include <array>
+#include <memory>
 
 // TODO most of the names are not necessary for anything - consider dropping / skipping
 namespace trivial_gltf
 {
 struct node
 {
-    int32_t               mesh{-1};
-    int32_t               skin{-1};
-    int32_t               camera{-1};
-    glm::qua<float>       rotaton{};
-    glm::vec<3, float>    scale{};
-    glm::vec<3, float>    translation{};
-    std::vector<uint32_t> children;
-    std::vector<uint32_t> weights;
-    std::string           name;
+    int32_t                    mesh{-1};
+    int32_t                    skin{-1};
+    int32_t                    camera{-1};
+    glm::qua<float>            rotaton{1.0f, 0.0f, 0.0f, 0.0f};
+    glm::vec<3, float>         scale{1.0f, 1.0f, 1.0f};
+    glm::vec<3, float>         translation{};
+    std::pmr::vector<uint32_t> children;
+    std::pmr::vector<float>    weights;  // morph weights, override those of the mesh
+    std::pmr::string           name;
     // not done extensions and extras
 };
 
 struct skin
 {
-    std::string           name;
-    int32_t               skeleton;
-    int32_t               inverseBindMaterials;
-    std::vector<uint32_t> joints;
+    std::pmr::string           name;
+    int32_t                    skeleton;
+    int32_t                    inverse_bind_matrices;  // accessor
+    std::pmr::vector<uint32_t> joints;
 };
 
 struct scene
 {
-    std::string           name;
-    std::vector<uint32_t> root_nodes;
+    std::pmr::string           name;
+    std::pmr::vector<uint32_t> root_nodes;
 };
 
 enum class component : uint16_t
@@ -90,12 +95,14 @@ enum class attribute : uint8_t
     color_0,
     joints_0,
     weights_0,
-    extended_attribute  // further attributes for shaders go beyond this
+    extended_attribute  // further attributes for shaders go beyond this, see doc::extended_attributes
 };
 
 template <attribute v>
 constexpr int value = static_cast<int>(v);
 
+constexpr size_t max_extended_attributes = 255 - value<attribute::extended_attribute>;
+
 enum class attribute_flag : uint32_t
 {
     position_flag   = 1 << value<attribute::position>,
@@ -106,6 +113,7 @@ enum class attribute_flag : uint32_t
     color_0_flag    = 1 << value<attribute::color_0>,
     joints_0_flag   = 1 << value<attribute::joints_0>,
     weights_0_flag  = 1 << value<attribute::weights_0>,
+    extended_flag   = 1 << value<attribute::extended_attribute>,  // any of the extended attributes
 };
 
 enum class mode_type : uint8_t
@@ -135,21 +143,22 @@ enum class path_type : uint8_t
 };
 
 using attribute_offset = tiny_tuple::tuple<attribute, uint32_t>;
+using morph_target     = std::pmr::vector<attribute_offset>;  // displacement accessors, usually POSITION, NORMAL and TANGENT
 
 struct primitive
 {
-    std::vector<attribute_offset> attributes;
-    int32_t                       indices{-1};   // accessor
-    int32_t                       material{-1};  // index of material
-    mode_type                     mode{mode_type::triangles};
-    attribute_flag                flags;
-    // dont understand morph targets yet
+    std::pmr::vector<attribute_offset> attributes;
+    int32_t                            indices{-1};   // accessor
+    int32_t                            material{-1};  // index of material
+    mode_type                          mode{mode_type::triangles};
+    attribute_flag                     flags;
+    std::pmr::vector<morph_target>     targets;
 };
 struct mesh
 {
-    std::string            name;
-    std::vector<primitive> primitives;
-    std::vector<float>     weights;
+    std::pmr::string            name;
+    std::pmr::vector<primitive> primitives;
+    std::pmr::vector<float>     weights;
 };
 
 struct channel
@@ -168,16 +177,16 @@ struct animation_sampler
 
 struct animation
 {
-    std::string                    name;
-    std::vector<channel>           channels;
-    std::vector<animation_sampler> samplers;
+    std::pmr::string                    name;
+    std::pmr::vector<channel>           channels;
+    std::pmr::vector<animation_sampler> samplers;
 };
 
 struct texture_info
 {
-    int32_t     index;
-    int32_t     tex_coord{0};
-    std::string name;
+    int32_t          index;
+    int32_t          tex_coord{0};
+    std::pmr::string name;
 };
 
 struct normal_texture_info : texture_info
@@ -207,7 +216,7 @@ enum class alpha_mode_type
 
 struct material
 {
-    std::string            name;
+    std::pmr::string       name;
     pbr_metallic_roughness data;
     normal_texture_info    normal;
     occlusion_texture_info occlusion;
@@ -218,52 +227,108 @@ struct material
     bool                   double_sided;
 };
 
+// Elements of an accessor replaced by values stored apart, indices are strictly increasing. Both arrays are
+// tightly packed in their buffer views.
+struct sparse_accessor
+{
+    uint32_t  count{0};  // zero for dense accessors
+    uint32_t  indices_view{0};
+    uint32_t  indices_offset{0};
+    component indices_type{component::unsigned_int_type};
+    uint32_t  values_view{0};
+    uint32_t  values_offset{0};
+};
+
 struct accessor
 {
-    uint32_t           view;
-    uint32_t           offset;
-    uint32_t           count;
-    component          comp_type;
-    attribute_type     type;
-    bool               normalized;
-    std::vector<float> max;
-    std::vector<float> min;
+    uint32_t                view;  // out of range when absent, the elements are zero then
+    uint32_t                offset;
+    uint32_t                count;
+    component               comp_type;
+    attribute_type          type;
+    bool                    normalized;
+    std::pmr::vector<float> max;
+    std::pmr::vector<float> min;
+    sparse_accessor         sparse;
+
+    // not supported name, extensions, extras
+};
 
-    // not supported sparse, name, extensions, extras
+enum class meshopt_mode : uint8_t
+{
+    attributes,
+    triangles,
+    indices
+};
+
+enum class meshopt_filter : uint8_t
+{
+    none,
+    octahedral,
+    quaternion,
+    exponential
+};
+
+// EXT_meshopt_compression of a buffer view: where the compressed bytes are and how they expand into count
+// elements of stride bytes. The view itself refers to the fallback data until it is decoded.
+struct meshopt_compression
+{
+    uint32_t       buffer{0};
+    uint32_t       offset{0};
+    uint32_t       length{0};
+    uint32_t       stride{0};
+    uint32_t       count{0};  // zero for views that are not compressed
+    meshopt_mode   mode{meshopt_mode::attributes};
+    meshopt_filter filter{meshopt_filter::none};
 };
 
 struct buffer_view
 {
-    uint32_t buffer;
-    uint32_t length;
-    uint32_t offset;
-    uint32_t stride;
-    uint32_t target;
+    uint32_t            buffer;
+    uint32_t            length;
+    uint32_t            offset;
+    uint32_t            stride;
+    uint32_t            target;
+    meshopt_compression meshopt;
 };
 
 struct infile_buffer
 {
-    size_t byte_length;
+    size_t                     byte_length;
+    std::span<std::byte const> data;  // BIN chunk once bound by the glb reader
 };
 struct external_buffer
 {
-    size_t      byte_length;
-    std::string uri;
+    size_t                     byte_length;
+    std::pmr::string           uri;
+    std::span<std::byte const> data;  // contents once resolved by a loader
 };
-using buffer = std::variant<infile_buffer, external_buffer>;
+// a base64 data uri, decoded while parsing
+struct embedded_buffer
+{
+    size_t                      byte_length;
+    std::pmr::vector<std::byte> bytes;
+};
+using buffer = std::variant<infile_buffer, external_buffer, embedded_buffer>;
 
 struct infile_image
 {
-    std::string name;
-    std::string mime;
-    int32_t     buffer_view;
+    std::pmr::string name;
+    std::pmr::string mime;
+    int32_t          buffer_view;
 };
 struct external_image
 {
-    std::string name;
-    std::string uri;
+    std::pmr::string name;
+    std::pmr::string uri;
+};
+struct embedded_image
+{
+    std::pmr::string            name;
+    std::pmr::string            mime;
+    std::pmr::vector<std::byte> bytes;
 };
-using image = std::variant<infile_image, external_image>;
+using image = std::variant<infile_image, external_image, embedded_image>;
 
 struct sampler
 {
@@ -274,34 +339,110 @@ struct sampler
 };
 struct texture
 {
-    int32_t     sampler;
-    int32_t     source;
-    std::string name;
+    int32_t          sampler;
+    int32_t          source;
+    std::pmr::string name;
 };
 
 struct doc
 {
-    doc()                            = default;
-    doc(doc const&)                  = delete;
-    doc(doc&&)                       = delete;
-    doc&                     operator=(doc const&) = delete;
-    doc&                     operator=(doc&&) = delete;
-    std::vector<scene>       scenes;
-    std::vector<node>        nodes;
-    std::vector<mesh>        meshes;
-    std::vector<animation>   animations;
-    std::vector<material>    materials;
-    std::vector<accessor>    accessors;
-    std::vector<buffer_view> buffer_views;
-    std::vector<buffer>      buffers;
-    std::vector<skin>        skins;
-    std::vector<image>       images;
-    std::vector<sampler>     samplers;
-    std::vector<texture>     textures;
+    doc() : doc(std::pmr::get_default_resource()) {}
+    // all elements, names and index lists of the document are allocated from resource
+    explicit doc(std::pmr::memory_resource* resource)
+        : scenes(resource),
+          nodes(resource),
+          meshes(resource),
+          animations(resource),
+          materials(resource),
+          accessors(resource),
+          buffer_views(resource),
+          buffers(resource),
+          skins(resource),
+          images(resource),
+          samplers(resource),
+          textures(resource),
+          extended_attributes(resource)
+    {
+    }
+    doc(doc const&) = delete;
+    doc(doc&&)      = default;
+    doc& operator=(doc const&) = delete;
+    doc& operator=(doc&&) = default;
+
+    std::pmr::memory_resource* resource() const noexcept { return nodes.get_allocator().resource(); }
+    // drops all elements, the top level containers keep their capacity for the next document
+    void clear() noexcept
+    {
+        scenes.clear();
+        nodes.clear();
+        meshes.clear();
+        animations.clear();
+        materials.clear();
+        accessors.clear();
+        buffer_views.clear();
+        buffers.clear();
+        skins.clear();
+        images.clear();
+        samplers.clear();
+        textures.clear();
+        extended_attributes.clear();
+    }
+
+    std::pmr::vector<scene>       scenes;
+    std::pmr::vector<node>        nodes;
+    std::pmr::vector<mesh>        meshes;
+    std::pmr::vector<animation>   animations;
+    std::pmr::vector<material>    materials;
+    std::pmr::vector<accessor>    accessors;
+    std::pmr::vector<buffer_view> buffer_views;
+    std::pmr::vector<buffer>      buffers;
+    std::pmr::vector<skin>        skins;
+    std::pmr::vector<image>       images;
+    std::pmr::vector<sampler>     samplers;
+    std::pmr::vector<texture>     textures;
+    // names of the attributes from attribute::extended_attribute onwards, e.g. TEXCOORD_2, JOINTS_1 or _CUSTOM
+    std::pmr::vector<std::pmr::string> extended_attributes;
     /// const std::shared_ptr<cleanup_target> cleaner;
 };
 
-// who keeps the memory alive?
+// A doc backed by a monotonic arena, so that parsing large scenes does not go to the heap for every
+// element, name and child list. Everything is released at once with the arena_doc. Children, weights, joints
+// and attributes remain a pmr vector per element instead of ranges into shared pools, which keeps the
+// container interface the rest of the library uses, the arena places them next to each other instead. The
+// snapshot format stores them as pooled ranges.
+struct arena_doc
+{
+    explicit arena_doc(size_t initial_size = 64 * 1024) : arena{initial_size} {}
+    std::pmr::monotonic_buffer_resource arena;
+    doc                                 document{&arena};
+};
+
+// Bytes of a buffer or buffer view, empty while the buffer is not bound or the view exceeds the buffer.
+// The memory is owned by whoever bound it - the glb_reader or a mapped_asset - or by the doc for data uris.
+inline std::span<std::byte const> buffer_data(doc const& d, size_t buffer)
+{
+    if (buffer >= d.buffers.size()) return {};
+    return std::visit(
+        [](auto const& b) -> std::span<std::byte const>
+        {
+            if constexpr (std::is_same_v<std::decay_t<decltype(b)>, embedded_buffer>)
+                return b.bytes;
+            else
+                return b.data;
+        },
+        d.buffers[buffer]);
+}
+
+inline std::span<std::byte const> view_data(doc const& d, size_t view)
+{
+    if (view >= d.buffer_views.size()) return {};
+    auto const& v    = d.buffer_views[view];
+    auto const  data = buffer_data(d, v.buffer);
+    if (size_t{v.offset} + v.length > data.size()) return {};
+    return data.subspan(v.offset, v.length);
+}
+
+// who keeps the memory alive? -> see mapped_asset, or the glb_reader for streamed containers
 // TODO rethink the interface - there are too many cases...
 // streaming over the network.. secondary resources?
 // when to pull?
@@ -314,6 +455,147 @@ enum class parse_state
     json_complete
 };
 
-std::function<parse_state(std::span<char const> const&)> create_parser(doc& destination);
+// Sections of the document to fill, everything else is skipped by the json extractor without invoking any handler.
+enum class parse_options : uint32_t
+{
+    scenes       = 1 << 0,
+    nodes        = 1 << 1,
+    meshes       = 1 << 2,
+    animations   = 1 << 3,
+    materials    = 1 << 4,
+    skins        = 1 << 5,
+    accessors    = 1 << 6,
+    images       = 1 << 7,
+    textures     = 1 << 8,
+    samplers     = 1 << 9,
+    buffer_views = 1 << 10,
+    buffers      = 1 << 11,
+    names        = 1 << 12,  // name strings of all elements
+    geometry     = meshes | accessors | buffer_views | buffers,
+    all          = (1 << 13) - 1
+};
+
+constexpr parse_options operator|(parse_options l, parse_options r) noexcept
+{
+    return static_cast<parse_options>(static_cast<uint32_t>(l) | static_cast<uint32_t>(r));
+}
+constexpr parse_options operator&(parse_options l, parse_options r) noexcept
+{
+    return static_cast<parse_options>(static_cast<uint32_t>(l) & static_cast<uint32_t>(r));
+}
+constexpr parse_options operator~(parse_options o) noexcept
+{
+    return static_cast<parse_options>(~static_cast<uint32_t>(o)) & parse_options::all;
+}
+constexpr bool has_option(parse_options set, parse_options o) noexcept { return (set & o) == o; }
+
+// Notified as soon as an element has been completed and appended to the doc, i.e. while the remaining json
+// is still streaming in. index is the position in the respective doc vector. Buffer contents are not bound yet.
+class doc_listener
+{
+   public:
+    virtual ~doc_listener() = default;
+    virtual void on_scene(size_t, scene const&) {}
+    virtual void on_node(size_t, node const&) {}
+    virtual void on_mesh(size_t, mesh const&) {}
+    virtual void on_animation(size_t, animation const&) {}
+    virtual void on_material(size_t, material const&) {}
+    virtual void on_skin(size_t, skin const&) {}
+    virtual void on_accessor(size_t, accessor const&) {}
+    virtual void on_image(size_t, image const&) {}
+    virtual void on_texture(size_t, texture const&) {}
+    virtual void on_sampler(size_t, sampler const&) {}
+    virtual void on_buffer_view(size_t, buffer_view const&) {}
+    virtual void on_buffer(size_t, buffer const&) {}
+};
+
+// The returned parser reports json_complete once the top level object has been closed, and error on malformed json.
+std::function<parse_state(std::span<char const> const&)> create_parser(doc& destination, parse_options options = parse_options::all);
+std::function<parse_state(std::span<char const> const&)> create_parser(doc& destination, doc_listener& listener,
+                                                                       parse_options options = parse_options::all);
+
+// Concrete parser that can be reset onto another doc, so that one instance - e.g. per worker thread - loads many
+// documents in a row. A reset keeps the capacity of the scratch containers while the docs share a memory resource,
+// and the chunks are fed without a std::function call, the json extractor is still built anew on every reset.
+// The doc has to outlive the parser or the next reset.
+class parser
+{
+   public:
+    explicit parser(doc& destination, parse_options options = parse_options::all);
+    parser(doc& destination, doc_listener& listener, parse_options options = parse_options::all);
+    parser(parser&&) noexcept;
+    parser& operator=(parser&&) noexcept;
+    ~parser();
+
+    parse_state operator()(std::span<char const> const& bytes);
+    // starts over with the next json document, parsed into destination
+    void reset(doc& destination);
+    doc& destination() const noexcept;
+
+   private:
+    struct impl;
+    std::unique_ptr<impl> state;
+};
+
+// Instrumented parsers, see parse_stats.h. The overloads without a stats sink contain no instrumentation at all.
+struct parse_stats;
+std::function<parse_state(std::span<char const> const&)> create_parser(doc& destination, parse_stats& stats,
+                                                                       parse_options options = parse_options::all);
+std::function<parse_state(std::span<char const> const&)> create_parser(doc& destination, doc_listener& listener, parse_stats& stats,
+                                                                       parse_options options = parse_options::all);
+
+struct glb_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t length;
+};
+
+constexpr uint32_t glb_magic      = 0x46546C67;  // "glTF"
+constexpr uint32_t glb_json_chunk = 0x4E4F534A;  // "JSON"
+constexpr uint32_t glb_bin_chunk  = 0x004E4942;  // "BIN\0"
+
+// Streaming reader for the binary container. Bytes may arrive in chunks of any size, the JSON chunk is passed
+// on to the json parser as it arrives. The BIN chunk is collected into a single allocation sized from its chunk
+// header, and bound to the first infile_buffer once the container is complete.
+class glb_reader
+{
+   public:
+    explicit glb_reader(doc& destination, parse_options options = parse_options::all);
+    glb_reader(doc& destination, doc_listener& listener, parse_options options = parse_options::all);
+    parse_state                operator()(std::span<char const> const& bytes);
+    std::span<std::byte const> bin_chunk() const noexcept { return bin; }
+
+   private:
+    enum class stage : uint8_t
+    {
+        header,
+        chunk_header,
+        json,
+        bin,
+        skip,
+        done,
+        error
+    };
+    void                                 finish();
+    doc&                                 dest;
+    parser                               json_parser;
+    std::vector<std::byte>               bin_storage;
+    std::span<std::byte const>           bin;
+    std::array<char, sizeof(glb_header)> header_bytes;
+    uint32_t                             header_fill{0};
+    uint32_t                             total_length{0};
+    uint32_t                             consumed{0};
+    uint32_t                             chunk_remaining{0};
+    parse_state                          json_state{parse_state::more_input_needed};
+    stage                                current{stage::header};
+    bool                                 bin_seen{false};  // only the first BIN chunk counts, even when empty
+};
+
+// Parses a glb container that is already completely in memory. The BIN chunk is not copied, the first
+// infile_buffer refers into file afterwards.
+parse_state parse_glb(std::span<std::byte const> file, doc& destination, parse_options options = parse_options::all);
+// Same with a reused parser, the json chunk is parsed into json_parser.destination().
+parse_state parse_glb(std::span<std::byte const> file, parser& json_parser);
 }  // namespace trivial_gltf
 #endif
@@ -0,0 +1,100 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_IMAGE_STORE_H_INCLUDED
+#define TRIVIAL_GLTF_IMAGE_STORE_H_INCLUDED
+
+#include <trivial_gltf/resource_prefetch.h>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace trivial_gltf
+{
+// Contents of an image, pointing into a buffer of the doc or at cached file contents that hold keeps alive.
+struct image_bytes
+{
+    std::span<std::byte const>                    bytes;
+    std::shared_ptr<std::vector<std::byte> const> hold;
+};
+
+struct image_cache_stats
+{
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+    size_t   bytes{0};  // currently cached
+};
+
+// Least recently used set of loaded image files, bounded by a byte budget and shared by the image_stores of
+// any number of docs. Evicted contents stay alive as long as an image_bytes refers to them. Thread safe.
+class image_cache
+{
+   public:
+    explicit image_cache(size_t budget_bytes) : budget{budget_bytes} {}
+    image_cache(image_cache const&) = delete;
+    image_cache& operator=(image_cache const&) = delete;
+
+    image_cache_stats stats() const;
+    // drops all entries
+    void clear();
+
+   private:
+    friend class image_store;
+    struct key
+    {
+        uint64_t owner;
+        size_t   image;
+        bool     operator==(key const&) const noexcept = default;
+    };
+    struct key_hash
+    {
+        size_t operator()(key const& k) const noexcept { return std::hash<uint64_t>{}(k.owner * 0x9e3779b97f4a7c15ull ^ k.image); }
+    };
+    using contents = std::shared_ptr<std::vector<std::byte> const>;
+    using entry    = std::pair<key, contents>;
+
+    uint64_t register_owner() noexcept { return ++owners; }
+    contents find(key k);
+    // returns the already cached contents when another thread was faster
+    contents insert(key k, contents c);
+    void     evict_owner(uint64_t owner);
+
+    size_t                                                        budget;
+    std::atomic<uint64_t>                                         owners{0};
+    mutable std::mutex                                            lock;
+    std::list<entry>                                              order;  // most recently used first
+    std::unordered_map<key, std::list<entry>::iterator, key_hash> entries;
+    image_cache_stats                                             counters;
+};
+
+// Resolves the bytes of the images of a doc when first requested. Images in buffer views and decoded data
+// uris are returned in place, external images are read through the fetcher and kept in the cache. The doc
+// and fetcher have to outlive the store, its cache entries are dropped with it. get is thread safe.
+class image_store
+{
+   public:
+    image_store(doc const& d, resource_fetcher& fetcher, image_cache& cache);
+    image_store(image_store const&) = delete;
+    image_store& operator=(image_store const&) = delete;
+    ~image_store();
+
+    // empty bytes for unknown images, unbound buffers and files that cannot be read
+    image_bytes get(size_t image);
+    // the mime type of the image, empty for external images
+    std::string_view mime(size_t image) const noexcept;
+
+   private:
+    doc const&        d;
+    resource_fetcher& fetcher;
+    image_cache&      cache;
+    uint64_t          owner;
+};
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,65 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_MAPPED_ASSET_H_INCLUDED
+#define TRIVIAL_GLTF_MAPPED_ASSET_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <filesystem>
+
+namespace trivial_gltf
+{
+// Path of a gltf uri, a percent encoded reference relative to base.
+std::filesystem::path resolve_uri(std::filesystem::path const& base, std::string_view uri);
+
+// Read only memory mapping of a complete file, pages are only loaded once touched. Where there is no mmap the
+// file is read into memory instead.
+class mapped_file
+{
+   public:
+    mapped_file() = default;
+    explicit mapped_file(std::filesystem::path const& file);
+    mapped_file(mapped_file const&) = delete;
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+    ~mapped_file();
+
+    std::span<std::byte const> bytes() const noexcept { return {static_cast<std::byte const*>(address), size}; }
+    explicit                   operator bool() const noexcept { return address != nullptr; }
+
+   private:
+    void*  address{nullptr};
+    size_t size{0};
+};
+
+// Maps a .gltf or .glb file and all external .bin buffers it refers to. The buffers of the document and
+// the resolved buffer views point into the mappings, so they stay valid as long as the asset lives.
+class mapped_asset
+{
+   public:
+    explicit mapped_asset(std::filesystem::path const& file, parse_options options = parse_options::all);
+    mapped_asset(mapped_asset const&) = delete;
+    mapped_asset& operator=(mapped_asset const&) = delete;
+
+    parse_state                state() const noexcept { return result; }
+    doc const&                 document() const noexcept { return asset; }
+    std::span<std::byte const> buffer_data(size_t buffer) const noexcept { return trivial_gltf::buffer_data(asset, buffer); }
+    std::span<std::byte const> view_data(size_t view) const noexcept
+    {
+        return view < views.size() ? views[view] : std::span<std::byte const>{};
+    }
+
+   private:
+    doc                                     asset;
+    mapped_file                             main;
+    std::vector<mapped_file>                external;
+    std::vector<std::span<std::byte const>> views;
+    parse_state                             result{parse_state::error};
+};
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,68 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_MESH_OPTIMIZE_H_INCLUDED
+#define TRIVIAL_GLTF_MESH_OPTIMIZE_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <span>
+#include <vector>
+
+namespace trivial_gltf
+{
+class thread_pool;
+
+// Reorders the triangles of an indexed triangle list for a post transform vertex cache of cache_size entries,
+// with the linear time Tipsify algorithm of Sander, Nehab and Barczak. indices are below vertex_count, out
+// receives the same triangles in the new order. False when an index is out of range.
+bool optimize_vertex_cache(std::span<uint32_t const> indices, size_t vertex_count, std::span<uint32_t> out, size_t cache_size = 16);
+
+// Reorders triangles already in vertex cache order to reduce overdraw, following the Tipsify paper: the triangles
+// are cut into clusters where the cache runs empty or the miss ratio allows it, and the clusters facing away from
+// the center of the mesh are drawn first, so that they tend to occlude the others. threshold bounds the increase
+// of the miss ratio. positions holds x, y, z per vertex. False when an index is out of range.
+bool optimize_overdraw(std::span<uint32_t const> indices, std::span<float const> positions, std::span<uint32_t> out, size_t cache_size = 16,
+                       float threshold = 1.05f);
+
+// Average number of vertex shader invocations per triangle with a fifo cache of cache_size entries.
+double average_cache_miss_ratio(std::span<uint32_t const> indices, size_t cache_size = 16);
+
+// Rewrites the indexed triangle list primitives of d: the triangles are ordered for the vertex cache, then, when
+// overdraw_threshold is above zero and the primitives have vec3 positions, for overdraw, then the vertices in
+// order of first use, so that vertex fetches run mostly forward. Primitives that share their vertex
+// accessors are reordered together and keep sharing them. Indices and all vertex attributes, including morph
+// targets, are copied into storage, which is replaced, as new buffer views and accessors in a buffer appended
+// to d. The original accessors remain but are no longer referenced by the primitives. storage has to outlive
+// that use of the doc. With a pool the primitives are processed in parallel. Returns the number of primitives
+// rewritten, those with unresolvable data are left as they are.
+size_t optimize_primitives(doc& d, std::vector<std::byte>& storage, thread_pool* pool = nullptr, size_t cache_size = 16,
+                           float overdraw_threshold = 1.05f);
+
+// Outcome of the deduplication passes, bytes count tightly packed elements.
+struct dedup_report
+{
+    size_t vertices_before{0};
+    size_t vertices_after{0};
+    size_t accessors_shared{0};  // references moved to an identical accessor
+    size_t meshes_shared{0};     // references moved to an identical mesh
+    size_t bytes_saved{0};       // vertex and accessor data no longer referenced, each stored byte counted once
+};
+
+// Welds the vertices of the indexed primitives of d that are bit identical in all attributes and morph targets,
+// found through a hash of the whole vertex. Primitives that share their vertex accessors are welded together and
+// keep sharing them, the distinct vertices keep their order. As with optimize_primitives the vertices and the
+// remapped indices are copied into storage, which is replaced, in a buffer appended to d. Primitives without
+// duplicate vertices are left as they are. With a pool the primitives are processed in parallel.
+dedup_report weld_vertices(doc& d, std::vector<std::byte>& storage, thread_pool* pool = nullptr);
+
+// Moves all references of primitives, skins and animation samplers to the first of each set of accessors with
+// identical elements, bounds and layout, then those of nodes to the first of each set of meshes with identical
+// primitives. The duplicates remain in d, unreferenced. Run after weld_vertices this also joins primitives that
+// were welded into equal data. With a pool the accessor elements are hashed in parallel.
+dedup_report share_identical(doc& d, thread_pool* pool = nullptr);
+}  // namespace trivial_gltf
+
+#endif
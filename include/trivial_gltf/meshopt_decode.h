@@ -0,0 +1,38 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_MESHOPT_DECODE_H_INCLUDED
+#define TRIVIAL_GLTF_MESHOPT_DECODE_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <span>
+#include <vector>
+
+namespace trivial_gltf
+{
+class thread_pool;
+
+// Decoders of the EXT_meshopt_compression bitstreams, each expanding src into count elements of stride bytes
+// at the front of dst. Vertex strides are multiples of 4 up to 256, index strides 2 or 4. They return false
+// for malformed or truncated input, the contents of dst are unspecified then.
+bool decode_meshopt_vertices(std::span<std::byte const> src, size_t count, size_t stride, std::span<std::byte> dst) noexcept;
+bool decode_meshopt_triangles(std::span<std::byte const> src, size_t count, size_t stride, std::span<std::byte> dst) noexcept;
+bool decode_meshopt_indices(std::span<std::byte const> src, size_t count, size_t stride, std::span<std::byte> dst) noexcept;
+
+// Reconstructs filtered vertex data in place, after decode_meshopt_vertices. False if the stride does not fit the filter.
+bool apply_meshopt_filter(meshopt_filter filter, std::span<std::byte> data, size_t count, size_t stride) noexcept;
+
+// Decodes with the mode and filter of c, src being the c.length compressed bytes.
+bool decode_meshopt(meshopt_compression const& c, std::span<std::byte const> src, std::span<std::byte> dst) noexcept;
+
+// Decodes every compressed buffer view into storage, which is replaced, appends a buffer bound to it and points
+// the views at their decoded bytes, so that accessors read them like any other data. storage has to outlive
+// that use of the doc. With a pool the views are decoded in parallel. Views whose compressed data is not bound
+// or does not decode keep referring to their fallback, their number is returned.
+size_t decode_meshopt_views(doc& d, std::vector<std::byte>& storage, thread_pool* pool = nullptr);
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,48 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_MORPH_H_INCLUDED
+#define TRIVIAL_GLTF_MORPH_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <span>
+#include <vector>
+
+namespace trivial_gltf
+{
+// Displacements of one attribute over all morph targets of a primitive, decoded once. A target that moves
+// only a few vertices keeps just those, together with their vertex indices. Sparse accessors without buffer
+// view are taken over as they are, without expanding them.
+struct morph_deltas
+{
+    struct target
+    {
+        uint32_t first_delta;  // into deltas, in vec3 units
+        uint32_t count;        // displaced vertices, vertex_count for dense targets
+        uint32_t first_index;  // into indices
+        bool     sparse;
+    };
+
+    morph_deltas() = default;
+    // attr is position, normal or tangent, targets lacking it or with data that does not decode displace nothing
+    morph_deltas(doc const& d, primitive const& p, attribute attr);
+
+    uint32_t              vertex_count{0};
+    std::vector<target>   targets;
+    std::vector<float>    deltas;
+    std::vector<uint32_t> indices;
+};
+
+// Writes base + the sum of weights[i] * displacement of target i to out, both packed vec3 of vertex_count
+// entries, out may be base. Targets with zero weight are skipped, sparse targets only touch their vertices.
+void apply_morph_targets(morph_deltas const& m, std::span<float const> weights, std::span<float const> base,
+                         std::span<float> out) noexcept;
+
+// weights in effect for a node, those of the node when present, otherwise the defaults of its mesh
+std::span<float const> morph_weights(doc const& d, node const& n) noexcept;
+}  // namespace trivial_gltf
+
+#endif
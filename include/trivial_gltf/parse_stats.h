@@ -0,0 +1,77 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_PARSE_STATS_H_INCLUDED
+#define TRIVIAL_GLTF_PARSE_STATS_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <chrono>
+
+namespace trivial_gltf
+{
+// Top level members of a gltf document, in the order of the parse_options bits. Everything else - asset,
+// scene, extensions.. - is accounted as other.
+enum class doc_section : uint8_t
+{
+    scenes,
+    nodes,
+    meshes,
+    animations,
+    materials,
+    skins,
+    accessors,
+    images,
+    textures,
+    samplers,
+    buffer_views,
+    buffers,
+    other,
+    count
+};
+constexpr size_t doc_section_count = static_cast<size_t>(doc_section::count);
+char const*      section_name(doc_section s) noexcept;
+
+struct section_stats
+{
+    std::chrono::nanoseconds time{0};  // spent parsing while this section was open
+    uint64_t                 elements{0};
+};
+
+// Figures collected by a parser created with a parse_stats sink, updated after every input chunk.
+struct parse_stats
+{
+    uint64_t                                     bytes_consumed{0};
+    uint64_t                                     chunks{0};
+    std::array<section_stats, doc_section_count> sections{};
+    uint64_t                                     allocations{0};      // into the doc, needs a doc on a counting_resource
+    uint64_t                                     allocated_bytes{0};  // into the doc, needs a doc on a counting_resource
+    uint64_t                                     largest_string{0};   // in bytes, before unescaping
+    uint64_t                                     largest_array{0};    // in elements
+
+    section_stats const& operator[](doc_section s) const noexcept { return sections[static_cast<size_t>(s)]; }
+};
+
+// Forwards to an upstream resource and counts the allocations, e.g. doc d{&counter}.
+class counting_resource : public std::pmr::memory_resource
+{
+   public:
+    explicit counting_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept : upstream{upstream} {}
+
+    uint64_t allocations() const noexcept { return count; }
+    uint64_t allocated_bytes() const noexcept { return bytes; }
+
+   private:
+    void* do_allocate(size_t size, size_t alignment) override;
+    void  do_deallocate(void* p, size_t size, size_t alignment) override;
+    bool  do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+    std::pmr::memory_resource* upstream;
+    uint64_t                   count{0};
+    uint64_t                   bytes{0};
+};
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,88 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_RESOURCE_PREFETCH_H_INCLUDED
+#define TRIVIAL_GLTF_RESOURCE_PREFETCH_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trivial_gltf
+{
+// Source of the resources that buffers and images refer to by uri.
+class resource_fetcher
+{
+   public:
+    virtual ~resource_fetcher() = default;
+    // Called from the prefetch threads, concurrently for different uris. False if the resource is not available.
+    virtual bool fetch(std::string_view uri, std::vector<std::byte>& contents) = 0;
+};
+
+// Reads uris as percent encoded paths relative to base, e.g. the directory of the .gltf file.
+class file_fetcher : public resource_fetcher
+{
+   public:
+    explicit file_fetcher(std::filesystem::path base) : base{std::move(base)} {}
+    bool fetch(std::string_view uri, std::vector<std::byte>& contents) override;
+
+   private:
+    std::filesystem::path base;
+};
+
+// Loads external resources while the json is still being parsed. Passed to the parser as its doc_listener,
+// it queues a background fetch for every buffer and image with an external uri as soon as that element is
+// complete, the same uri is fetched once. Data uris are left alone.
+class resource_prefetcher : public doc_listener
+{
+   public:
+    explicit resource_prefetcher(resource_fetcher& fetcher, size_t threads = 4);
+    resource_prefetcher(resource_prefetcher const&) = delete;
+    resource_prefetcher& operator=(resource_prefetcher const&) = delete;
+    // finishes the running fetches, queued ones are dropped
+    ~resource_prefetcher() override;
+
+    void on_buffer(size_t index, buffer const& b) override;
+    void on_image(size_t index, image const& i) override;
+
+    // blocks until all queued fetches are done
+    void wait();
+    // Waits and binds the fetched contents to the external buffers of d, so they stay valid as long as the
+    // prefetcher lives. Returns the number of buffers that failed to load or are shorter than their byteLength.
+    size_t bind(doc& d);
+    // contents of an external image once wait returned, empty when it failed to load
+    std::span<std::byte const> image_data(size_t image) const noexcept;
+
+   private:
+    struct resource
+    {
+        std::string            uri;
+        std::vector<std::byte> contents;
+        bool                   loaded{false};
+    };
+    resource* request(std::string_view uri);
+    void      worker_loop();
+
+    resource_fetcher&        fetcher;
+    std::deque<resource>     resources;  // stable addresses for the workers
+    std::deque<resource*>    queue;
+    std::vector<resource*>   buffer_resources;  // per buffer index, null without fetch
+    std::vector<resource*>   image_resources;
+    std::vector<std::thread> threads;
+    mutable std::mutex       control;
+    std::condition_variable  wake;
+    std::condition_variable  finished;
+    size_t                   pending{0};  // queued or running fetches
+    bool                     stopping{false};
+};
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,52 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_SKINNING_H_INCLUDED
+#define TRIVIAL_GLTF_SKINNING_H_INCLUDED
+
+#include <trivial_gltf/flat_scene.h>
+
+namespace trivial_gltf
+{
+// Joints and inverse bind matrices of a doc skin, decoded once and shared by all instances of it.
+struct skin_bind
+{
+    skin_bind() = default;
+    // falls back to identity inverse binds when the skin has none or they do not decode
+    skin_bind(doc const& d, skin const& s);
+
+    std::vector<uint32_t>  joints;
+    std::vector<glm::mat4> inverse_bind_matrices;
+};
+
+// A skin posed by the world transforms of one flat_scene.
+struct skin_instance
+{
+    skin_instance(skin_bind const& bind, flat_scene const& scene);
+
+    skin_bind const*     bind;
+    flat_scene const*    scene;
+    std::vector<int32_t> slots;              // per joint, -1 for joints outside of the scene
+    size_t               palette_offset{0};  // first joint matrix in the palette, see layout_palettes
+};
+
+// Places the palettes of the instances back to back and returns the number of joint matrices needed.
+size_t layout_palettes(std::span<skin_instance> instances) noexcept;
+
+// Writes world transform * inverse bind matrix of every joint of every instance to its palette range, joints
+// outside of the scene get their inverse bind matrix. The palette is a tightly packed array of column major
+// matrices, ready for upload. With a pool the instances are processed in parallel.
+void build_skin_palettes(std::span<skin_instance const> instances, std::span<glm::mat4> palette, thread_pool* pool = nullptr);
+
+// Linear blend skinning of a primitive on the cpu, e.g. for bounds or physics without a gpu. joint_matrices
+// is the palette range of the instance. Writes the skinned POSITION values and, if normals is not empty, the
+// renormalized NORMAL values as packed vec3. Returns the vertex count, zero if the primitive lacks POSITION,
+// JOINTS_0 or WEIGHTS_0 or an output is too small.
+size_t skin_vertices(doc const& d, primitive const& p, std::span<glm::mat4 const> joint_matrices, std::span<float> positions,
+                     std::span<float> normals = {});
+}  // namespace trivial_gltf
+
+#endif
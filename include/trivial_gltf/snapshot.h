@@ -0,0 +1,329 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_SNAPSHOT_H_INCLUDED
+#define TRIVIAL_GLTF_SNAPSHOT_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <string_view>
+
+// Flat binary image of a parsed doc. All arrays are stored as sections of plain records, variable sized
+// parts (names, children, weights, min/max ...) as offset/count ranges into shared pools, so that the image
+// is relocatable and can be used in place from a memory mapping without any allocation per element.
+namespace trivial_gltf
+{
+constexpr uint32_t snapshot_version = 7;
+
+enum class snapshot_section : uint32_t
+{
+    scenes,
+    nodes,
+    meshes,
+    primitives,
+    attributes,
+    animations,
+    channels,
+    animation_samplers,
+    materials,
+    accessors,
+    buffer_views,
+    buffers,
+    skins,
+    images,
+    samplers,
+    textures,
+    attribute_names,  // names of the extended attributes
+    morph_targets,    // attribute ranges of the primitive targets
+    indices,          // uint32_t pool
+    floats,           // float pool
+    chars,            // string pool
+    payload,          // embedded buffer contents and decoded data uris, each 16 byte aligned within the image
+    count
+};
+constexpr size_t snapshot_section_count = static_cast<size_t>(snapshot_section::count);
+
+struct snapshot_range
+{
+    uint32_t offset;
+    uint32_t count;
+};
+
+struct snapshot_header
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t size;
+    struct
+    {
+        uint64_t offset;
+        uint64_t count;
+    } sections[snapshot_section_count];
+};
+
+namespace snapshot_record
+{
+struct scene
+{
+    snapshot_range name;
+    snapshot_range root_nodes;
+};
+struct node
+{
+    int32_t        mesh, skin, camera;
+    float          rotation[4];  // x y z w
+    float          scale[3];
+    float          translation[3];
+    snapshot_range children;
+    snapshot_range weights;  // floats
+    snapshot_range name;
+};
+struct mesh
+{
+    snapshot_range name;
+    snapshot_range primitives;
+    snapshot_range weights;
+};
+struct primitive
+{
+    snapshot_range attributes;
+    int32_t        indices;
+    int32_t        material;
+    uint32_t       mode;
+    uint32_t       flags;
+    snapshot_range targets;  // into morph_targets
+};
+struct attribute
+{
+    uint32_t semantic;
+    uint32_t accessor;
+};
+struct animation
+{
+    snapshot_range name;
+    snapshot_range channels;
+    snapshot_range samplers;
+};
+struct channel
+{
+    int32_t  sampler_id;
+    int32_t  node_id;
+    uint32_t path;
+};
+struct animation_sampler
+{
+    int32_t  input;
+    int32_t  output;
+    uint32_t interpolation;
+};
+struct texture_info
+{
+    int32_t        index;
+    int32_t        tex_coord;
+    snapshot_range name;
+    float          value;  // scale or strength
+};
+struct material
+{
+    snapshot_range name;
+    float          base_color_factor[4];
+    texture_info   base_color_texture;
+    float          metallic_factor;
+    float          roughness_factor;
+    texture_info   metallic_roughness_texture;
+    texture_info   normal;
+    texture_info   occlusion;
+    texture_info   emissive;
+    float          emissive_factor[3];
+    uint32_t       alpha_mode;
+    float          alpha_cut_off;
+    uint32_t       double_sided;
+};
+struct accessor
+{
+    uint32_t       view;
+    uint32_t       offset;
+    uint32_t       count;
+    uint16_t       comp_type;
+    uint8_t        type;
+    uint8_t        normalized;
+    snapshot_range max;
+    snapshot_range min;
+    uint32_t       sparse_count;
+    uint32_t       sparse_indices_view, sparse_indices_offset, sparse_indices_type;
+    uint32_t       sparse_values_view, sparse_values_offset;
+};
+struct buffer_view
+{
+    uint32_t buffer, length, offset, stride, target;
+    uint32_t meshopt_buffer, meshopt_offset, meshopt_length, meshopt_stride, meshopt_count;
+    uint8_t  meshopt_mode, meshopt_filter;
+    uint16_t reserved;
+};
+struct buffer
+{
+    uint64_t       byte_length;
+    uint64_t       payload_offset;  // into the payload section
+    uint64_t       payload_size;    // zero when the contents were not embedded
+    snapshot_range uri;             // empty for the glb BIN chunk
+    uint32_t       external;        // 1 for uri references, 2 for decoded data uris
+    uint32_t       reserved;
+};
+struct skin
+{
+    snapshot_range name;
+    int32_t        skeleton;
+    int32_t        inverse_bind_matrices;
+    snapshot_range joints;
+};
+struct image
+{
+    uint32_t       external;        // 1 for uri references, 2 for decoded data uris
+    int32_t        buffer_view;
+    snapshot_range name;
+    snapshot_range uri_or_mime;
+    uint64_t       payload_offset;  // contents of decoded data uris
+    uint64_t       payload_size;
+};
+struct sampler
+{
+    int32_t min_filter, mag_filter, wrap_s, wrap_t;
+};
+struct texture
+{
+    int32_t        sampler;
+    int32_t        source;
+    snapshot_range name;
+};
+}  // namespace snapshot_record
+
+// Serializes the doc, with embed_buffers the bound buffer contents are copied into the payload section.
+std::vector<std::byte> write_snapshot(doc const& source, bool embed_buffers);
+
+// Validating, non owning view onto a snapshot image, e.g. the bytes of a mapped_file.
+class snapshot_view
+{
+   public:
+    snapshot_view() = default;
+    explicit snapshot_view(std::span<std::byte const> image) noexcept;
+
+    bool valid() const noexcept { return header != nullptr; }
+
+    template <typename Record>
+    std::span<Record const> records(snapshot_section s) const noexcept
+    {
+        if (!header) return {};
+        auto const& sec = header->sections[static_cast<size_t>(s)];
+        return {reinterpret_cast<Record const*>(bytes.data() + sec.offset), static_cast<size_t>(sec.count)};
+    }
+
+    std::span<snapshot_record::scene const> scenes() const noexcept
+    {
+        return records<snapshot_record::scene>(snapshot_section::scenes);
+    }
+    std::span<snapshot_record::node const> nodes() const noexcept
+    {
+        return records<snapshot_record::node>(snapshot_section::nodes);
+    }
+    std::span<snapshot_record::mesh const> meshes() const noexcept
+    {
+        return records<snapshot_record::mesh>(snapshot_section::meshes);
+    }
+    std::span<snapshot_record::animation const> animations() const noexcept
+    {
+        return records<snapshot_record::animation>(snapshot_section::animations);
+    }
+    std::span<snapshot_record::material const> materials() const noexcept
+    {
+        return records<snapshot_record::material>(snapshot_section::materials);
+    }
+    std::span<snapshot_record::accessor const> accessors() const noexcept
+    {
+        return records<snapshot_record::accessor>(snapshot_section::accessors);
+    }
+    std::span<snapshot_record::buffer_view const> buffer_views() const noexcept
+    {
+        return records<snapshot_record::buffer_view>(snapshot_section::buffer_views);
+    }
+    std::span<snapshot_record::buffer const> buffers() const noexcept
+    {
+        return records<snapshot_record::buffer>(snapshot_section::buffers);
+    }
+    std::span<snapshot_record::skin const> skins() const noexcept
+    {
+        return records<snapshot_record::skin>(snapshot_section::skins);
+    }
+    std::span<snapshot_record::image const> images() const noexcept
+    {
+        return records<snapshot_record::image>(snapshot_section::images);
+    }
+    std::span<snapshot_record::sampler const> samplers() const noexcept
+    {
+        return records<snapshot_record::sampler>(snapshot_section::samplers);
+    }
+    std::span<snapshot_record::texture const> textures() const noexcept
+    {
+        return records<snapshot_record::texture>(snapshot_section::textures);
+    }
+    std::span<snapshot_range const> attribute_names() const noexcept { return records<snapshot_range>(snapshot_section::attribute_names); }
+
+    // pool lookups, empty when the range lies outside of the pool
+    std::span<snapshot_record::primitive const> primitives(snapshot_range r) const noexcept
+    {
+        return pool<snapshot_record::primitive>(snapshot_section::primitives, r);
+    }
+    std::span<snapshot_record::attribute const> attributes(snapshot_range r) const noexcept
+    {
+        return pool<snapshot_record::attribute>(snapshot_section::attributes, r);
+    }
+    std::span<snapshot_range const> morph_targets(snapshot_range r) const noexcept
+    {
+        return pool<snapshot_range>(snapshot_section::morph_targets, r);
+    }
+    std::span<snapshot_record::channel const> channels(snapshot_range r) const noexcept
+    {
+        return pool<snapshot_record::channel>(snapshot_section::channels, r);
+    }
+    std::span<snapshot_record::animation_sampler const> animation_samplers(snapshot_range r) const noexcept
+    {
+        return pool<snapshot_record::animation_sampler>(snapshot_section::animation_samplers, r);
+    }
+    std::span<uint32_t const> indices(snapshot_range r) const noexcept { return pool<uint32_t>(snapshot_section::indices, r); }
+    std::span<float const>    floats(snapshot_range r) const noexcept { return pool<float>(snapshot_section::floats, r); }
+    std::string_view          string(snapshot_range r) const noexcept
+    {
+        auto chars = pool<char>(snapshot_section::chars, r);
+        return {chars.data(), chars.size()};
+    }
+    std::span<std::byte const> payload(snapshot_record::buffer const& b) const noexcept
+    {
+        return payload(b.payload_offset, b.payload_size);
+    }
+    std::span<std::byte const> payload(snapshot_record::image const& i) const noexcept
+    {
+        return payload(i.payload_offset, i.payload_size);
+    }
+    std::span<std::byte const> payload(uint64_t offset, uint64_t size) const noexcept;
+
+   private:
+    template <typename Record>
+    std::span<Record const> pool(snapshot_section s, snapshot_range r) const noexcept
+    {
+        auto all = records<Record>(s);
+        if (size_t{r.offset} + r.count > all.size()) return {};
+        return all.subspan(r.offset, r.count);
+    }
+
+    std::span<std::byte const> bytes;
+    snapshot_header const*     header{nullptr};
+};
+
+// Rebuilds a doc from the snapshot. Embedded buffer contents are bound as spans into the snapshot image,
+// so the image has to outlive the doc. Decoded data uris are copied into the doc.
+parse_state load_snapshot(snapshot_view const& snapshot, doc& destination);
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,71 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_THREAD_POOL_H_INCLUDED
+#define TRIVIAL_GLTF_THREAD_POOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace trivial_gltf
+{
+// Fixed set of workers for data parallel loops. Every worker owns a range of the loop indices and works on it
+// front to back, a worker that runs dry steals the upper half of the largest remaining range of another worker.
+// The calling thread takes part as worker 0, so a pool of size one runs everything inline.
+class thread_pool
+{
+   public:
+    explicit thread_pool(size_t workers = std::thread::hardware_concurrency());
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+    ~thread_pool();
+
+    size_t size() const noexcept { return queue_count; }
+
+    // Calls body(index, worker) for every index in [0, count) and blocks until all calls returned. worker is
+    // in [0, size()) and unique among the concurrently running calls, so it can select per worker scratch state.
+    // When a call throws the indices not yet started are dropped, and the first exception is rethrown on the
+    // calling thread after all running calls returned. Must not be called from within a body.
+    void for_each(size_t count, std::function<void(size_t index, size_t worker)> const& body);
+
+   private:
+    struct alignas(64) range_queue
+    {
+        std::mutex lock;
+        size_t     begin{0};
+        size_t     end{0};
+    };
+    bool pop(size_t worker, size_t& index) noexcept;
+    bool steal(size_t worker) noexcept;
+    void cancel(std::exception_ptr error) noexcept;
+    void run(size_t worker) noexcept;
+    void worker_loop(size_t worker);
+
+    size_t                                     queue_count;
+    std::unique_ptr<range_queue[]>             queues;
+    std::vector<std::thread>                   threads;
+    std::function<void(size_t, size_t)> const* job{nullptr};
+    std::mutex                                 control;
+    std::condition_variable                    wake;
+    std::condition_variable                    finished;
+    std::exception_ptr                         failure;  // first exception thrown by the current job
+    std::atomic<bool>                          cancelled{false};
+    uint64_t                                   generation{0};
+    size_t                                     active{0};
+    bool                                       stopping{false};
+};
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,47 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_TOPOLOGY_H_INCLUDED
+#define TRIVIAL_GLTF_TOPOLOGY_H_INCLUDED
+
+#include <trivial_gltf/gltf_parse.h>
+#include <span>
+#include <vector>
+
+namespace trivial_gltf
+{
+class thread_pool;
+
+// mode of the list that the primitives of mode m are expanded to: points, lines or triangles
+constexpr mode_type list_mode(mode_type m) noexcept
+{
+    switch (m)
+    {
+        case mode_type::line_loop:
+        case mode_type::line_strip: return mode_type::lines;
+        case mode_type::triangles_strip:
+        case mode_type::triangle_fan: return mode_type::triangles;
+        default: return m;
+    }
+}
+
+// Appends the list of list_mode(m) that draws the same points, lines or triangles as indices with mode m,
+// including winding. Degenerate strip triangles, which only join strips, are dropped.
+void expand_to_list(mode_type m, std::span<uint32_t const> indices, std::vector<uint32_t>& out);
+
+// Narrows indices below 65536 to 16 bit.
+void narrow_to_uint16(std::span<uint32_t const> indices, uint16_t* out) noexcept;
+
+// Turns every primitive into an indexed point, line or triangle list. Strips, fans and loops are expanded,
+// non indexed primitives get indices and indices go to 16 bit whenever the largest one is below the restart
+// value 0xffff, 32 bit otherwise. The index data of all primitives is packed into arena, which is replaced, and bound as one
+// buffer appended to d, ready for a single upload. arena has to outlive that use of the doc. With a pool the
+// primitives are converted in parallel. Returns the number of primitives rewritten, those whose indices or
+// vertex count do not resolve are left as they are.
+size_t normalize_topology(doc& d, std::vector<std::byte>& arena, thread_pool* pool = nullptr);
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,554 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include "simd.h"
+#include <trivial_gltf/accessor_decode.h>
+#include <algorithm>
+#include <atomic>
+
+namespace trivial_gltf
+{
+namespace
+{
+constexpr float normalize_scale(component c) noexcept
+{
+    switch (c)
+    {
+        case component::byte_type: return 1.0f / 127.0f;
+        case component::unsigned_byte_type: return 1.0f / 255.0f;
+        case component::short_type: return 1.0f / 32767.0f;
+        case component::unsigned_short_type: return 1.0f / 65535.0f;
+        default: return 1.0f;
+    }
+}
+
+template <typename S>
+void to_float_scalar(std::byte const* src, float* dst, size_t n, float scale, bool clamp) noexcept
+{
+    for (size_t i = 0; i != n; ++i)
+    {
+        S v;
+        std::memcpy(&v, src + i * sizeof(S), sizeof(S));
+        float f = static_cast<float>(v) * scale;
+        dst[i]  = clamp ? std::max(f, -1.0f) : f;
+    }
+}
+
+void to_float_scalar(component c, float scale, bool clamp, std::byte const* src, float* dst, size_t n) noexcept
+{
+    switch (c)
+    {
+        case component::byte_type: to_float_scalar<int8_t>(src, dst, n, scale, clamp); break;
+        case component::unsigned_byte_type: to_float_scalar<uint8_t>(src, dst, n, scale, clamp); break;
+        case component::short_type: to_float_scalar<int16_t>(src, dst, n, scale, clamp); break;
+        case component::unsigned_short_type: to_float_scalar<uint16_t>(src, dst, n, scale, clamp); break;
+        case component::unsigned_int_type: to_float_scalar<uint32_t>(src, dst, n, scale, clamp); break;
+        case component::float_type: std::memcpy(dst, src, n * sizeof(float)); break;
+    }
+}
+
+// round to nearest even, NaN becomes a quiet NaN - same as the vectorized variant below
+uint16_t float_to_half(float value) noexcept
+{
+    uint32_t f;
+    std::memcpy(&f, &value, 4);
+    uint32_t const sign = f & 0x80000000u;
+    f ^= sign;
+    uint32_t o;
+    if (f >= (127u + 16u) << 23)
+        o = f > (255u << 23) ? 0x7e00 : 0x7c00;
+    else if (f < (113u << 23))
+    {
+        uint32_t const magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+        float          mf, ff;
+        std::memcpy(&mf, &magic, 4);
+        std::memcpy(&ff, &f, 4);
+        ff += mf;
+        std::memcpy(&f, &ff, 4);
+        o = f - magic;
+    }
+    else
+    {
+        uint32_t const mant_odd = (f >> 13) & 1;
+        f += (uint32_t(15 - 127) << 23) + 0xfff;
+        f += mant_odd;
+        o = f >> 13;
+    }
+    return static_cast<uint16_t>(o | (sign >> 16));
+}
+
+void to_half_scalar(float const* src, uint16_t* dst, size_t n) noexcept
+{
+    for (size_t i = 0; i != n; ++i) dst[i] = float_to_half(src[i]);
+}
+
+template <typename S>
+void widen_scalar(std::byte const* src, uint32_t* dst, size_t n) noexcept
+{
+    for (size_t i = 0; i != n; ++i)
+    {
+        S v;
+        std::memcpy(&v, src + i * sizeof(S), sizeof(S));
+        dst[i] = v;
+    }
+}
+
+void widen_scalar(component c, std::byte const* src, uint32_t* dst, size_t n) noexcept
+{
+    switch (c)
+    {
+        case component::unsigned_byte_type: widen_scalar<uint8_t>(src, dst, n); break;
+        case component::unsigned_short_type: widen_scalar<uint16_t>(src, dst, n); break;
+        case component::unsigned_int_type: std::memcpy(dst, src, n * sizeof(uint32_t)); break;
+        default: break;
+    }
+}
+
+#if TRIVIAL_GLTF_X86_SIMD
+template <bool Clamp>
+inline void store_sse2(__m128i v, __m128 scale, float* dst) noexcept
+{
+    auto f = _mm_mul_ps(_mm_cvtepi32_ps(v), scale);
+    if constexpr (Clamp) f = _mm_max_ps(f, _mm_set1_ps(-1.0f));
+    _mm_storeu_ps(dst, f);
+}
+
+inline __m128 unsigned_to_float_sse2(__m128i v) noexcept
+{
+    auto const hi = _mm_cvtepi32_ps(_mm_srli_epi32(v, 16));
+    auto const lo = _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0xffff)));
+    return _mm_add_ps(_mm_mul_ps(hi, _mm_set1_ps(65536.0f)), lo);
+}
+
+template <bool Clamp>
+void to_float_sse2(component c, float scale_value, std::byte const* src, float* dst, size_t n) noexcept
+{
+    auto const scale = _mm_set1_ps(scale_value);
+    auto const zero  = _mm_setzero_si128();
+    size_t     i     = 0;
+    switch (c)
+    {
+        case component::byte_type:
+            for (; i + 16 <= n; i += 16)
+            {
+                auto const v  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+                auto const lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+                auto const hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+                store_sse2<Clamp>(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16), scale, dst + i);
+                store_sse2<Clamp>(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16), scale, dst + i + 4);
+                store_sse2<Clamp>(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16), scale, dst + i + 8);
+                store_sse2<Clamp>(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16), scale, dst + i + 12);
+            }
+            to_float_scalar<int8_t>(src + i, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::unsigned_byte_type:
+            for (; i + 16 <= n; i += 16)
+            {
+                auto const v  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+                auto const lo = _mm_unpacklo_epi8(v, zero);
+                auto const hi = _mm_unpackhi_epi8(v, zero);
+                store_sse2<Clamp>(_mm_unpacklo_epi16(lo, zero), scale, dst + i);
+                store_sse2<Clamp>(_mm_unpackhi_epi16(lo, zero), scale, dst + i + 4);
+                store_sse2<Clamp>(_mm_unpacklo_epi16(hi, zero), scale, dst + i + 8);
+                store_sse2<Clamp>(_mm_unpackhi_epi16(hi, zero), scale, dst + i + 12);
+            }
+            to_float_scalar<uint8_t>(src + i, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::short_type:
+            for (; i + 8 <= n; i += 8)
+            {
+                auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * 2));
+                store_sse2<Clamp>(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), scale, dst + i);
+                store_sse2<Clamp>(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), scale, dst + i + 4);
+            }
+            to_float_scalar<int16_t>(src + i * 2, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::unsigned_short_type:
+            for (; i + 8 <= n; i += 8)
+            {
+                auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * 2));
+                store_sse2<Clamp>(_mm_unpacklo_epi16(v, zero), scale, dst + i);
+                store_sse2<Clamp>(_mm_unpackhi_epi16(v, zero), scale, dst + i + 4);
+            }
+            to_float_scalar<uint16_t>(src + i * 2, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::unsigned_int_type:
+            for (; i + 4 <= n; i += 4)
+            {
+                auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * 4));
+                _mm_storeu_ps(dst + i, _mm_mul_ps(unsigned_to_float_sse2(v), scale));
+            }
+            to_float_scalar<uint32_t>(src + i * 4, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::float_type: std::memcpy(dst, src, n * sizeof(float)); break;
+    }
+}
+
+void to_float_sse2(component c, float scale, bool clamp, std::byte const* src, float* dst, size_t n) noexcept
+{
+    if (clamp)
+        to_float_sse2<true>(c, scale, src, dst, n);
+    else
+        to_float_sse2<false>(c, scale, src, dst, n);
+}
+
+void to_half_sse2(float const* src, uint16_t* dst, size_t n) noexcept
+{
+    auto const sign_mask     = _mm_set1_epi32(0x80000000u);
+    auto const f16max        = _mm_set1_epi32((127 + 16) << 23);
+    auto const nan_bit       = _mm_set1_epi32(0x200);
+    auto const infinity      = _mm_set1_epi32(0x7c00);
+    auto const min_normal    = _mm_set1_epi32(113 << 23);
+    auto const subnorm_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    auto const normal_bias   = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+    size_t     i             = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i packed[2];
+        for (int h = 0; h != 2; ++h)
+        {
+            auto const f          = _mm_loadu_ps(src + i + h * 4);
+            auto const just_sign  = _mm_and_ps(_mm_castsi128_ps(sign_mask), f);
+            auto const absf       = _mm_xor_ps(f, just_sign);
+            auto const absf_int   = _mm_castps_si128(absf);
+            auto const is_nan     = _mm_castps_si128(_mm_cmpunord_ps(absf, absf));
+            auto const is_regular = _mm_cmpgt_epi32(f16max, absf_int);
+            auto const inf_or_nan = _mm_or_si128(_mm_and_si128(is_nan, nan_bit), infinity);
+            auto const is_sub     = _mm_cmpgt_epi32(min_normal, absf_int);
+            auto const subnormal  = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(subnorm_magic))), subnorm_magic);
+            auto const mant_odd   = _mm_srai_epi32(_mm_slli_epi32(absf_int, 31 - 13), 31);
+            auto const normal     = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absf_int, normal_bias), mant_odd), 13);
+            auto const nonspecial = _mm_or_si128(_mm_and_si128(subnormal, is_sub), _mm_andnot_si128(is_sub, normal));
+            auto const joined     = _mm_or_si128(_mm_and_si128(nonspecial, is_regular), _mm_andnot_si128(is_regular, inf_or_nan));
+            auto const result     = _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(just_sign), 16));
+            // sign extend the low half so that the saturating pack keeps all bits
+            packed[h] = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(packed[0], packed[1]));
+    }
+    to_half_scalar(src + i, dst + i, n - i);
+}
+
+void widen_sse2(component c, std::byte const* src, uint32_t* dst, size_t n) noexcept
+{
+    auto const zero = _mm_setzero_si128();
+    size_t     i    = 0;
+    auto       out  = [&](size_t o, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + o), v); };
+    switch (c)
+    {
+        case component::unsigned_byte_type:
+            for (; i + 16 <= n; i += 16)
+            {
+                auto const v  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+                auto const lo = _mm_unpacklo_epi8(v, zero);
+                auto const hi = _mm_unpackhi_epi8(v, zero);
+                out(i, _mm_unpacklo_epi16(lo, zero));
+                out(i + 4, _mm_unpackhi_epi16(lo, zero));
+                out(i + 8, _mm_unpacklo_epi16(hi, zero));
+                out(i + 12, _mm_unpackhi_epi16(hi, zero));
+            }
+            widen_scalar<uint8_t>(src + i, dst + i, n - i);
+            break;
+        case component::unsigned_short_type:
+            for (; i + 8 <= n; i += 8)
+            {
+                auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * 2));
+                out(i, _mm_unpacklo_epi16(v, zero));
+                out(i + 4, _mm_unpackhi_epi16(v, zero));
+            }
+            widen_scalar<uint16_t>(src + i * 2, dst + i, n - i);
+            break;
+        default: widen_scalar(c, src, dst, n); break;
+    }
+}
+
+template <bool Clamp>
+__attribute__((target("avx2"))) inline void store_avx2(__m256i v, __m256 scale, float* dst) noexcept
+{
+    auto f = _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale);
+    if constexpr (Clamp) f = _mm256_max_ps(f, _mm256_set1_ps(-1.0f));
+    _mm256_storeu_ps(dst, f);
+}
+
+template <bool Clamp>
+__attribute__((target("avx2"))) void to_float_avx2(component c, float scale_value, std::byte const* src, float* dst, size_t n) noexcept
+{
+    auto const scale = _mm256_set1_ps(scale_value);
+    size_t     i     = 0;
+    switch (c)
+    {
+        case component::byte_type:
+            for (; i + 8 <= n; i += 8)
+                store_avx2<Clamp>(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + i))), scale, dst + i);
+            to_float_scalar<int8_t>(src + i, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::unsigned_byte_type:
+            for (; i + 8 <= n; i += 8)
+                store_avx2<Clamp>(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + i))), scale, dst + i);
+            to_float_scalar<uint8_t>(src + i, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::short_type:
+            for (; i + 8 <= n; i += 8)
+                store_avx2<Clamp>(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * 2))), scale, dst + i);
+            to_float_scalar<int16_t>(src + i * 2, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::unsigned_short_type:
+            for (; i + 8 <= n; i += 8)
+                store_avx2<Clamp>(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * 2))), scale, dst + i);
+            to_float_scalar<uint16_t>(src + i * 2, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::unsigned_int_type:
+            for (; i + 8 <= n; i += 8)
+            {
+                auto const v  = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i * 4));
+                auto const hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(v, 16));
+                auto const lo = _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xffff)));
+                _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(hi, _mm256_set1_ps(65536.0f)), lo), scale));
+            }
+            to_float_scalar<uint32_t>(src + i * 4, dst + i, n - i, scale_value, Clamp);
+            break;
+        case component::float_type: std::memcpy(dst, src, n * sizeof(float)); break;
+    }
+}
+
+void to_float_avx2(component c, float scale, bool clamp, std::byte const* src, float* dst, size_t n) noexcept
+{
+    if (clamp)
+        to_float_avx2<true>(c, scale, src, dst, n);
+    else
+        to_float_avx2<false>(c, scale, src, dst, n);
+}
+
+__attribute__((target("avx2,f16c"))) void to_half_avx2(float const* src, uint16_t* dst, size_t n) noexcept
+{
+    // vcvtps2ph keeps NaN payloads, the other levels write the plain quiet NaN
+    auto const sign  = _mm256_set1_ps(-0.0f);
+    auto const quiet = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fc00000));
+    size_t     i     = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        auto       v   = _mm256_loadu_ps(src + i);
+        auto const nan = _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+        v              = _mm256_blendv_ps(v, _mm256_or_ps(_mm256_and_ps(v, sign), quiet), nan);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+    to_half_scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) void widen_avx2(component c, std::byte const* src, uint32_t* dst, size_t n) noexcept
+{
+    size_t i = 0;
+    switch (c)
+    {
+        case component::unsigned_byte_type:
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                                    _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + i))));
+            widen_scalar<uint8_t>(src + i, dst + i, n - i);
+            break;
+        case component::unsigned_short_type:
+            for (; i + 8 <= n; i += 8)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                                    _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * 2))));
+            widen_scalar<uint16_t>(src + i * 2, dst + i, n - i);
+            break;
+        default: widen_scalar(c, src, dst, n); break;
+    }
+}
+#endif
+
+struct kernel_set
+{
+    void (*to_float)(component, float, bool, std::byte const*, float*, size_t) noexcept;
+    void (*to_half)(float const*, uint16_t*, size_t) noexcept;
+    void (*widen)(component, std::byte const*, uint32_t*, size_t) noexcept;
+};
+
+constexpr kernel_set kernels[] = {
+    {&to_float_scalar, &to_half_scalar, &widen_scalar},
+#if TRIVIAL_GLTF_X86_SIMD
+    {&to_float_sse2, &to_half_sse2, &widen_sse2},
+    {&to_float_avx2, &to_half_avx2, &widen_avx2},
+#endif
+};
+
+simd_level detect_simd_level() noexcept
+{
+#if TRIVIAL_GLTF_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) return simd_level::avx2;
+    if (__builtin_cpu_supports("sse2")) return simd_level::sse2;
+#endif
+    return simd_level::scalar;
+}
+
+std::atomic<simd_level> current_level{detect_simd_level()};
+
+bool detect_ssse3() noexcept
+{
+#if TRIVIAL_GLTF_X86_SIMD
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+#else
+    return false;
+#endif
+}
+
+bool const ssse3_supported = detect_ssse3();
+
+kernel_set const& active() noexcept { return kernels[static_cast<size_t>(current_level.load(std::memory_order_relaxed))]; }
+
+// Calls convert on tightly packed scalars, repacking strided or padded elements through a small staging block.
+template <typename Out, typename Convert>
+size_t decode_blocks(doc const& d, accessor const& acc, std::span<Out> out, Convert&& convert) noexcept
+{
+    auto const bytes  = resolve_accessor(d, acc);
+    auto const comps  = component_count(acc.type);
+    auto const csize  = component_size(acc.comp_type);
+    auto const packed = comps * csize;
+    auto const total  = bytes.count * comps;
+    if (!bytes.data || out.size() < total) return 0;
+    if (bytes.stride == packed && element_size(acc.comp_type, acc.type) == packed)
+    {
+        convert(bytes.data, out.data(), total);
+        return total;
+    }
+
+    std::byte    staging[4096];
+    auto const   columns    = column_count(acc.type);
+    auto const   column     = packed / columns;
+    auto const   col_stride = column_stride(acc.comp_type, acc.type);
+    size_t const per_block  = sizeof(staging) / packed;
+    for (size_t first = 0; first < bytes.count; first += per_block)
+    {
+        auto const n = std::min(per_block, bytes.count - first);
+        for (size_t e = 0; e != n; ++e)
+        {
+            auto const* src = bytes.data + (first + e) * bytes.stride;
+            for (size_t c = 0; c != columns; ++c) std::memcpy(staging + e * packed + c * column, src + c * col_stride, column);
+        }
+        convert(staging, out.data() + first * comps, n * comps);
+    }
+    return total;
+}
+
+// Decodes the dense part, or zero for accessors without buffer view, then converts the substituted elements.
+template <typename Out, typename Convert>
+size_t decode_accessor(doc const& d, accessor const& acc, std::span<Out> out, Convert&& convert) noexcept
+{
+    if (acc.sparse.count == 0) return decode_blocks(d, acc, out, convert);
+    auto const comps  = component_count(acc.type);
+    auto const total  = acc.count * comps;
+    auto const sparse = resolve_sparse(d, acc);
+    if (!sparse.indices || out.size() < total || comps == 0) return 0;
+    if (acc.view < d.buffer_views.size())
+    {
+        if (decode_blocks(d, acc, out, convert) != total) return 0;
+    }
+    else
+        std::fill(out.begin(), out.begin() + total, Out{});
+
+    std::byte  staging[64];  // one element, at most a mat4 of floats
+    auto const size     = element_size(acc.comp_type, acc.type);
+    auto const columns  = column_count(acc.type);
+    auto const column   = comps / columns * component_size(acc.comp_type);
+    auto const col_step = column_stride(acc.comp_type, acc.type);
+    for (size_t k = 0; k != sparse.count; ++k)
+    {
+        auto const index = sparse.index(k);
+        if (index >= acc.count) return 0;
+        auto const* src = sparse.values + k * size;
+        for (size_t c = 0; c != columns; ++c) std::memcpy(staging + c * column, src + c * col_step, column);
+        convert(staging, out.data() + index * comps, comps);
+    }
+    return total;
+}
+}  // namespace
+
+simd_level active_simd_level() noexcept { return current_level.load(std::memory_order_relaxed); }
+
+bool has_ssse3() noexcept { return ssse3_supported && active_simd_level() != simd_level::scalar; }
+
+void force_simd_level(simd_level level) noexcept { current_level.store(std::min(level, detect_simd_level()), std::memory_order_relaxed); }
+
+void convert_to_float(component c, bool normalized, void const* src, float* dst, size_t scalars) noexcept
+{
+    auto const scale = normalized ? normalize_scale(c) : 1.0f;
+    auto const clamp = normalized && (c == component::byte_type || c == component::short_type);
+    active().to_float(c, scale, clamp, static_cast<std::byte const*>(src), dst, scalars);
+}
+
+void convert_to_half(float const* src, uint16_t* dst, size_t scalars) noexcept { active().to_half(src, dst, scalars); }
+
+void widen_to_uint32(component c, void const* src, uint32_t* dst, size_t scalars) noexcept
+{
+    active().widen(c, static_cast<std::byte const*>(src), dst, scalars);
+}
+
+size_t decode_floats(doc const& d, accessor const& acc, std::span<float> out) noexcept
+{
+    return decode_accessor(d, acc, out,
+                           [&acc](std::byte const* src, float* dst, size_t n)
+                           { convert_to_float(acc.comp_type, acc.normalized, src, dst, n); });
+}
+
+size_t decode_halfs(doc const& d, accessor const& acc, std::span<uint16_t> out) noexcept
+{
+    return decode_accessor(d, acc, out,
+                           [&acc](std::byte const* src, uint16_t* dst, size_t n)
+                           {
+                               float        block[1024];
+                               size_t const csize = component_size(acc.comp_type);
+                               for (size_t i = 0; i < n; i += std::size(block))
+                               {
+                                   auto const m = std::min(std::size(block), n - i);
+                                   convert_to_float(acc.comp_type, acc.normalized, src + i * csize, block, m);
+                                   convert_to_half(block, dst + i, m);
+                               }
+                           });
+}
+
+size_t widen_indices(doc const& d, accessor const& acc, std::span<uint32_t> out) noexcept
+{
+    if (acc.type != attribute_type::scalar || acc.comp_type == component::byte_type || acc.comp_type == component::short_type ||
+        acc.comp_type == component::float_type)
+        return 0;
+    return decode_accessor(d, acc, out,
+                           [&acc](std::byte const* src, uint32_t* dst, size_t n) { widen_to_uint32(acc.comp_type, src, dst, n); });
+}
+
+size_t materialize_accessor(doc const& d, accessor const& acc, std::span<std::byte> out) noexcept
+{
+    auto const size   = element_size(acc.comp_type, acc.type);
+    auto const total  = acc.count * size;
+    auto const dense  = resolve_accessor(d, acc);
+    auto const sparse = resolve_sparse(d, acc);
+    if (size == 0 || out.size() < total || (acc.view < d.buffer_views.size() && !dense.data) || (acc.sparse.count && !sparse.indices))
+        return 0;
+
+    auto const copy_run = [&](size_t first, size_t last)
+    {
+        if (!dense.data)
+            std::memset(out.data() + first * size, 0, (last - first) * size);
+        else if (dense.stride == size)
+            std::memcpy(out.data() + first * size, dense.data + first * size, (last - first) * size);
+        else
+            for (auto e = first; e != last; ++e) std::memcpy(out.data() + e * size, dense.data + e * dense.stride, size);
+    };
+    // the sparse indices are strictly increasing, so the runs between them are copied in one pass
+    size_t next = 0;
+    for (size_t k = 0; k != sparse.count; ++k)
+    {
+        auto const index = sparse.index(k);
+        if (index < next || index >= acc.count) return 0;
+        copy_run(next, index);
+        std::memcpy(out.data() + index * size, sparse.values + k * size, size);
+        next = index + 1;
+    }
+    copy_run(next, acc.count);
+    return total;
+}
+}  // namespace trivial_gltf
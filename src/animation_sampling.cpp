@@ -0,0 +1,283 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include "simd.h"
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/animation_sampling.h>
+#include <trivial_gltf/thread_pool.h>
+#include <algorithm>
+#include <cmath>
+
+namespace trivial_gltf
+{
+namespace
+{
+using track = animation_clip::track;
+
+bool batched(track const& t) noexcept { return t.path == path_type::rotattion && t.interpolation != interpolation_type::cubic_spline; }
+
+struct key_position
+{
+    uint32_t key, next;
+    float    u;         // position between key and next in [0, 1]
+    float    interval;  // time between key and next
+};
+
+// Finds the keys around t, cursor holds the last key at or before t and is kept for the next lookup.
+key_position locate(float const* times, uint32_t count, float t, uint32_t& cursor) noexcept
+{
+    if (count < 2 || !(t > times[0]))
+    {
+        cursor = 0;
+        return {0, 0, 0.0f, 0.0f};
+    }
+    uint32_t const last = count - 1;
+    if (t >= times[last])
+    {
+        cursor = last;
+        return {last, last, 0.0f, 0.0f};
+    }
+    uint32_t k = std::min(cursor, last - 1);
+    if (times[k] > t)
+        k = static_cast<uint32_t>(std::upper_bound(times, times + k, t) - times) - 1;
+    else
+        // playback moves a few keys forward at most, larger jumps are searched
+        for (int steps = 0; times[k + 1] <= t; ++k)
+            if (++steps > 4)
+            {
+                k = static_cast<uint32_t>(std::upper_bound(times + k + 1, times + last, t) - times) - 1;
+                break;
+            }
+    cursor              = k;
+    auto const interval = times[k + 1] - times[k];
+    return {k, k + 1, interval > 0.0f ? (t - times[k]) / interval : 0.0f, interval};
+}
+
+void normalize(float* q) noexcept
+{
+    auto const len = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    if (len > 0.0f)
+        for (int i = 0; i != 4; ++i) q[i] /= len;
+}
+
+void blend_rotation(float const* a, float const* b, float u, float* out, rotation_blend blend) noexcept
+{
+    float dot  = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    float sign = 1.0f;
+    if (dot < 0.0f)
+    {
+        // shortest path
+        dot  = -dot;
+        sign = -1.0f;
+    }
+    float wa = 1.0f - u, wb = u;
+    if (blend == rotation_blend::slerp && dot < 0.9995f)
+    {
+        auto const theta = std::acos(dot);
+        auto const s     = std::sin(theta);
+        wa               = std::sin(wa * theta) / s;
+        wb               = std::sin(wb * theta) / s;
+    }
+    for (int i = 0; i != 4; ++i) out[i] = wa * a[i] + sign * wb * b[i];
+    normalize(out);
+}
+
+void sample_track(animation_clip const& clip, track const& tr, key_position p, float* out, rotation_blend blend) noexcept
+{
+    auto const  w = tr.width;
+    auto const* v = clip.values.data() + tr.first_value;
+    switch (tr.interpolation)
+    {
+        case interpolation_type::step: std::copy(v + p.key * w, v + p.key * w + w, out); break;
+        case interpolation_type::linear:
+        {
+            auto const* a = v + p.key * w;
+            auto const* b = v + p.next * w;
+            if (tr.path == path_type::rotattion)
+                blend_rotation(a, b, p.u, out, blend);
+            else
+                for (uint32_t i = 0; i != w; ++i) out[i] = a[i] + (b[i] - a[i]) * p.u;
+            break;
+        }
+        case interpolation_type::cubic_spline:
+        {
+            // hermite spline over value and out tangent of key, in tangent and value of next
+            auto const* a   = v + 3 * p.key * w;
+            auto const* b   = v + 3 * p.next * w;
+            auto const  u   = p.u, u2 = u * u, u3 = u2 * u;
+            auto const  h00 = 2 * u3 - 3 * u2 + 1, h10 = (u3 - 2 * u2 + u) * p.interval;
+            auto const  h01 = -2 * u3 + 3 * u2, h11 = (u3 - u2) * p.interval;
+            for (uint32_t i = 0; i != w; ++i) out[i] = h00 * a[w + i] + h10 * a[2 * w + i] + h01 * b[w + i] + h11 * b[i];
+            if (tr.path == path_type::rotattion) normalize(out);
+            break;
+        }
+    }
+}
+
+void apply(animation_instance& inst, track const& tr, int32_t slot, float const* v) noexcept
+{
+    switch (tr.path)
+    {
+        case path_type::translation: inst.target->set_translation(slot, glm::vec3(v[0], v[1], v[2])); break;
+        case path_type::rotattion: inst.target->set_rotation(slot, glm::qua<float>(v[3], v[0], v[1], v[2])); break;
+        case path_type::scale: inst.target->set_scale(slot, glm::vec3(v[0], v[1], v[2])); break;
+        case path_type::weights: break;  // sampled in place
+    }
+}
+
+// Four linear or step rotation tracks at once, a[lane] and b[lane] point to the surrounding keys.
+void nlerp4(float const* const* a, float const* const* b, float const* u, float (*out)[4]) noexcept
+{
+#if TRIVIAL_GLTF_X86_SIMD
+    __m128 qa[4], qb[4];
+    for (int c = 0; c != 4; ++c)
+    {
+        qa[c] = _mm_setr_ps(a[0][c], a[1][c], a[2][c], a[3][c]);
+        qb[c] = _mm_setr_ps(b[0][c], b[1][c], b[2][c], b[3][c]);
+    }
+    auto const dot  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qa[0], qb[0]), _mm_mul_ps(qa[1], qb[1])),
+                                 _mm_add_ps(_mm_mul_ps(qa[2], qb[2]), _mm_mul_ps(qa[3], qb[3])));
+    auto const flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+    auto const t    = _mm_loadu_ps(u);
+    __m128     r[4];
+    for (int c = 0; c != 4; ++c) r[c] = _mm_add_ps(qa[c], _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(qb[c], flip), qa[c]), t));
+    auto const len = _mm_sqrt_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[0], r[0]), _mm_mul_ps(r[1], r[1])), _mm_add_ps(_mm_mul_ps(r[2], r[2]), _mm_mul_ps(r[3], r[3]))));
+    auto const inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(len, _mm_set1_ps(1e-30f)));
+    for (int c = 0; c != 4; ++c) r[c] = _mm_mul_ps(r[c], inv);
+    _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+    for (int lane = 0; lane != 4; ++lane) _mm_storeu_ps(out[lane], r[lane]);
+#else
+    for (int lane = 0; lane != 4; ++lane) blend_rotation(a[lane], b[lane], u[lane], out[lane], rotation_blend::nlerp);
+#endif
+}
+
+void sample(animation_instance& inst, rotation_blend blend) noexcept
+{
+    auto const& clip = *inst.clip;
+    auto const  t    = inst.time;
+    auto const  at   = [&](size_t i)
+    {
+        auto const& tr = clip.tracks[i];
+        return locate(clip.times.data() + tr.first_key, tr.key_count, t, inst.cursors[i]);
+    };
+
+    size_t i = 0;
+    if (blend == rotation_blend::nlerp)
+        for (; i < clip.batched_rotations; i += 4)
+        {
+            float const* a[4];
+            float const* b[4];
+            float        u[4];
+            float        out[4][4];
+            size_t const lanes = std::min<size_t>(4, clip.batched_rotations - i);
+            for (size_t lane = 0; lane != 4; ++lane)
+            {
+                // unused lanes repeat the first track
+                auto const  j  = lane < lanes ? i + lane : i;
+                auto const& tr = clip.tracks[j];
+                auto const  p  = at(j);
+                auto const* v  = clip.values.data() + tr.first_value;
+                a[lane]        = v + 4 * p.key;
+                b[lane]        = v + 4 * p.next;
+                u[lane]        = tr.interpolation == interpolation_type::step ? 0.0f : p.u;
+            }
+            nlerp4(a, b, u, out);
+            for (size_t lane = 0; lane != lanes; ++lane)
+                if (inst.slots[i + lane] >= 0) apply(inst, clip.tracks[i + lane], inst.slots[i + lane], out[lane]);
+        }
+
+    for (; i != clip.tracks.size(); ++i)
+    {
+        auto const& tr = clip.tracks[i];
+        if (tr.path == path_type::weights)
+        {
+            sample_track(clip, tr, at(i), inst.weights.data() + tr.weight_offset, blend);
+            continue;
+        }
+        if (inst.slots[i] < 0) continue;
+        float out[4];
+        sample_track(clip, tr, at(i), out, blend);
+        apply(inst, tr, inst.slots[i], out);
+    }
+}
+}  // namespace
+
+animation_clip::animation_clip(doc const& d, animation const& a)
+{
+    std::vector<track>                         unbatched;
+    std::vector<std::pair<int32_t, uint32_t>> inputs;  // samplers commonly share one time accessor
+    auto const valid = [&](int32_t index) { return index >= 0 && static_cast<size_t>(index) < d.accessors.size(); };
+
+    for (auto const& ch : a.channels)
+    {
+        if (ch.sampler_id < 0 || static_cast<size_t>(ch.sampler_id) >= a.samplers.size()) continue;
+        auto const& s = a.samplers[ch.sampler_id];
+        if (!valid(s.input) || !valid(s.output) || d.accessors[s.input].count == 0) continue;
+        auto const& in  = d.accessors[s.input];
+        auto const& out = d.accessors[s.output];
+
+        track tr{ch.node_id, ch.path, s.interpolation, 0, 0, in.count, static_cast<uint32_t>(values.size()), 0};
+        auto  known = std::find_if(inputs.begin(), inputs.end(), [&](auto const& e) { return e.first == s.input; });
+        if (known != inputs.end())
+            tr.first_key = known->second;
+        else
+        {
+            tr.first_key = static_cast<uint32_t>(times.size());
+            times.resize(times.size() + in.count);
+            if (decode_floats(d, in, std::span(times).subspan(tr.first_key)) != in.count)
+            {
+                times.resize(tr.first_key);
+                continue;
+            }
+            inputs.emplace_back(s.input, tr.first_key);
+        }
+
+        size_t const per_key = tr.interpolation == interpolation_type::cubic_spline ? 3 : 1;
+        size_t const count   = out.count * component_count(out.type);
+        switch (tr.path)
+        {
+            case path_type::rotattion: tr.width = 4; break;
+            case path_type::weights: tr.width = static_cast<uint32_t>(count / (per_key * in.count)); break;
+            default: tr.width = 3; break;
+        }
+        values.resize(tr.first_value + count);
+        if (tr.width == 0 || count < per_key * in.count * tr.width ||
+            decode_floats(d, out, std::span(values).subspan(tr.first_value)) != count)
+        {
+            values.resize(tr.first_value);
+            continue;
+        }
+        if (tr.path == path_type::weights)
+        {
+            tr.weight_offset = weight_count;
+            weight_count += tr.width;
+        }
+        duration = std::max(duration, times[tr.first_key + in.count - 1]);
+        (batched(tr) ? tracks : unbatched).push_back(tr);
+    }
+    batched_rotations = tracks.size();
+    tracks.insert(tracks.end(), unbatched.begin(), unbatched.end());
+}
+
+animation_instance::animation_instance(animation_clip const& source, flat_scene& scene)
+    : clip{&source}, target{&scene}, slots(source.tracks.size()), cursors(source.tracks.size(), 0), weights(source.weight_count, 0.0f)
+{
+    for (size_t i = 0; i != slots.size(); ++i)
+    {
+        auto const node = source.tracks[i].node;
+        slots[i]        = node < 0 ? -1 : scene.slot(static_cast<uint32_t>(node));
+    }
+}
+
+void sample_animations(std::span<animation_instance> instances, thread_pool* pool, rotation_blend blend)
+{
+    if (pool && pool->size() > 1 && instances.size() > 1)
+        pool->for_each(instances.size(), [&](size_t i, size_t) { sample(instances[i], blend); });
+    else
+        for (auto& instance : instances) sample(instance, blend);
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,139 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include "base64_decode.h"
+#include "simd.h"
+#include <trivial_gltf/accessor_decode.h>
+#include <algorithm>
+#include <array>
+
+namespace trivial_gltf
+{
+namespace
+{
+constexpr int8_t skip    = -1;
+constexpr int8_t padding = -2;
+
+constexpr auto sextets = []
+{
+    std::array<int8_t, 256> table{};
+    table.fill(skip);
+    for (int i = 0; i != 26; ++i)
+    {
+        table['A' + i] = static_cast<int8_t>(i);
+        table['a' + i] = static_cast<int8_t>(26 + i);
+    }
+    for (int i = 0; i != 10; ++i) table['0' + i] = static_cast<int8_t>(52 + i);
+    table['+'] = 62;
+    table['/'] = 63;
+    table['='] = padding;
+    return table;
+}();
+
+// value of a hex digit, above 15 for other characters
+uint32_t hex_digit(uint8_t c) noexcept
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') return (c | 0x20) - 'a' + 10;
+    return 0x100;
+}
+
+#if TRIVIAL_GLTF_X86_SIMD
+// Blocks of 16 characters to 12 bytes, with the nibble lookups of Wojciech Mula. Stops at the first block holding
+// anything but the 64 alphabet characters, or when out_end leaves no room for storing all 16 bytes.
+__attribute__((target("ssse3"))) void decode_blocks_ssse3(char const*& first, char const* last, std::byte*& out,
+                                                          std::byte const* out_end) noexcept
+{
+    auto const lut_lo   = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    auto const lut_hi   = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    auto const lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    auto const nibble   = _mm_set1_epi8(0x2f);
+    auto const pack     = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    for (; last - first >= 16 && out_end - out >= 16; first += 16, out += 12)
+    {
+        auto const text = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        auto const hi   = _mm_and_si128(_mm_srli_epi32(text, 4), nibble);
+        auto const lo   = _mm_and_si128(text, nibble);
+        // the lookups share a class bit for every character outside of the alphabet
+        auto const valid = _mm_cmpeq_epi8(_mm_and_si128(_mm_shuffle_epi8(lut_lo, lo), _mm_shuffle_epi8(lut_hi, hi)), _mm_setzero_si128());
+        if (_mm_movemask_epi8(valid) != 0xffff) return;
+
+        auto const roll   = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(text, nibble), hi));
+        auto const values = _mm_add_epi8(text, roll);
+        // sextets to 24 bit groups, byte swapped into place
+        auto const pairs  = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        auto const groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(groups, pack));
+    }
+}
+#endif
+}  // namespace
+
+char const* base64_decoder::decode(char const* first, char const* last, std::byte*& out, std::byte* out_end) noexcept
+{
+#if TRIVIAL_GLTF_X86_SIMD
+    bool const simd = has_ssse3();
+#endif
+    while (first != last && !done)
+    {
+#if TRIVIAL_GLTF_X86_SIMD
+        if (simd && pending == 0 && !escaped && hex_digits == 0) decode_blocks_ssse3(first, last, out, out_end);
+#endif
+        // the next characters one by one, up to where the blocks may continue
+        for (auto const stop = first + std::min<ptrdiff_t>(16, last - first); first != stop; ++first)
+        {
+            auto c = static_cast<uint8_t>(*first);
+            if (hex_digits != 0)
+            {
+                // a \uXXXX escape stands for one character, which may be in the alphabet
+                code = code << 4 | hex_digit(c);
+                if (--hex_digits != 0 || code > 0x7f) continue;
+                c = static_cast<uint8_t>(code);
+            }
+            else if (escaped)
+            {
+                // the text may still be json escaped, where only \/ and \uXXXX can stand for an alphabet character
+                escaped = false;
+                if (c == 'u')
+                {
+                    hex_digits = 4;
+                    code       = 0;
+                }
+                if (c != '/') continue;
+            }
+            else if (c == '\\')
+            {
+                escaped = true;
+                continue;
+            }
+            auto const v = sextets[c];
+            if (v == skip) continue;
+            if (v == padding)
+            {
+                done = true;
+                break;
+            }
+            if (pending == 3 && out_end - out < 3) return first;
+            bits = bits << 6 | static_cast<uint32_t>(v);
+            if (++pending != 4) continue;
+            out[0]  = static_cast<std::byte>(bits >> 16);
+            out[1]  = static_cast<std::byte>(bits >> 8);
+            out[2]  = static_cast<std::byte>(bits);
+            out    += 3;
+            bits    = pending = 0;
+        }
+    }
+    // whatever follows the padding is ignored
+    return done ? last : first;
+}
+
+void base64_decoder::finish(std::byte*& out) noexcept
+{
+    if (pending >= 2) *out++ = static_cast<std::byte>(bits >> (6 * pending - 8));
+    if (pending == 3) *out++ = static_cast<std::byte>(bits >> 2);
+    bits = pending = 0;
+}
+}  // namespace trivial_gltf
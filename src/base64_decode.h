@@ -0,0 +1,46 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_BASE64_DECODE_H_INCLUDED
+#define TRIVIAL_GLTF_BASE64_DECODE_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+namespace trivial_gltf
+{
+// Base64 decoder that is fed the text in arbitrary fragments, as they arrive from the json string events.
+// Characters outside of the alphabet are skipped. When the text still holds json escape sequences, \/ and \uXXXX
+// are read as the character they stand for and the others are skipped. The first '=' ends the data. Runs of 16
+// alphabet characters are decoded with SSSE3.
+class base64_decoder
+{
+   public:
+    // Decodes [first, last) to out, until the text is used up or out_end leaves no room for the next bytes.
+    // Returns the first character not consumed, out is advanced past the written bytes.
+    char const* decode(char const* first, char const* last, std::byte*& out, std::byte* out_end) noexcept;
+    // Bytes still held by an incomplete last quantum, written by finish.
+    size_t pending_bytes() const noexcept { return pending * 6 / 8; }
+    // Writes the pending bytes to out, which needs room for pending_bytes().
+    void finish(std::byte*& out) noexcept;
+    void reset() noexcept
+    {
+        bits = pending = code = 0;
+        hex_digits         = 0;
+        done = escaped = false;
+    }
+
+   private:
+    uint32_t bits{0};
+    uint32_t pending{0};      // sextets in bits
+    uint32_t code{0};         // of a \uXXXX escape
+    uint8_t  hex_digits{0};   // of a \uXXXX escape still to come
+    bool     escaped{false};  // after a backslash
+    bool     done{false};
+};
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,44 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/batch_loader.h>
+#include <cstring>
+#include <optional>
+
+namespace trivial_gltf
+{
+std::vector<batch_entry> parse_batch(std::span<std::span<std::byte const> const> sources, thread_pool& pool, parse_options options)
+{
+    std::vector<batch_entry>           result(sources.size());
+    std::vector<std::optional<parser>> parsers(pool.size());
+    pool.for_each(sources.size(),
+                  [&](size_t i, size_t worker)
+                  {
+                      auto const bytes = sources[i];
+                      auto&      entry = result[i];
+                      auto&      json  = parsers[worker];
+                      if (json)
+                          json->reset(entry.document);
+                      else
+                          json.emplace(entry.document, options);
+
+                      if (bytes.size() >= 4 && std::memcmp(bytes.data(), "glTF", 4) == 0)
+                          entry.state = parse_glb(bytes, *json);
+                      else
+                          entry.state = (*json)(std::span<char const>(reinterpret_cast<char const*>(bytes.data()), bytes.size()));
+                      if (entry.state != parse_state::json_complete) entry.state = parse_state::error;
+                  });
+    return result;
+}
+
+std::vector<std::unique_ptr<mapped_asset>> load_batch(std::span<std::filesystem::path const> files, thread_pool& pool,
+                                                      parse_options options)
+{
+    std::vector<std::unique_ptr<mapped_asset>> result(files.size());
+    pool.for_each(files.size(), [&](size_t i, size_t) { result[i] = std::make_unique<mapped_asset>(files[i], options); });
+    return result;
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,252 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/flat_scene.h>
+#include <trivial_gltf/thread_pool.h>
+#include <algorithm>
+#include <utility>
+#include "matrix_simd.h"
+
+namespace trivial_gltf
+{
+namespace
+{
+// subtrees up to this many slots are evaluated as one task
+constexpr uint32_t task_grain = 2048;
+
+// writes the column major matrix of translation * rotation * scale
+inline void local_matrix(float const* t, float const* r, float const* s, float* m) noexcept
+{
+    float const x = r[0], y = r[1], z = r[2], w = r[3];
+    m[0]  = (1.0f - 2.0f * (y * y + z * z)) * s[0];
+    m[1]  = 2.0f * (x * y + w * z) * s[0];
+    m[2]  = 2.0f * (x * z - w * y) * s[0];
+    m[3]  = 0.0f;
+    m[4]  = 2.0f * (x * y - w * z) * s[1];
+    m[5]  = (1.0f - 2.0f * (x * x + z * z)) * s[1];
+    m[6]  = 2.0f * (y * z + w * x) * s[1];
+    m[7]  = 0.0f;
+    m[8]  = 2.0f * (x * z + w * y) * s[2];
+    m[9]  = 2.0f * (y * z - w * x) * s[2];
+    m[10] = (1.0f - 2.0f * (x * x + y * y)) * s[2];
+    m[11] = 0.0f;
+    m[12] = t[0];
+    m[13] = t[1];
+    m[14] = t[2];
+    m[15] = 1.0f;
+}
+
+#if TRIVIAL_GLTF_X86_SIMD
+// four consecutive slots at once, the structure of arrays layout feeds the lanes directly
+inline void local_matrices_sse(float const* const* t, float const* const* r, float const* const* s, size_t i, float* m0, float* m1,
+                               float* m2, float* m3) noexcept
+{
+    auto const one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+    auto const x = _mm_loadu_ps(r[0] + i), y = _mm_loadu_ps(r[1] + i), z = _mm_loadu_ps(r[2] + i), w = _mm_loadu_ps(r[3] + i);
+    auto const sx = _mm_loadu_ps(s[0] + i), sy = _mm_loadu_ps(s[1] + i), sz = _mm_loadu_ps(s[2] + i);
+    auto const xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    auto const xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    auto const wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+    __m128 c[4][4] = {
+        {_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx), _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+         _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx), _mm_setzero_ps()},
+        {_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy), _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+         _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy), _mm_setzero_ps()},
+        {_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz), _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+         _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz), _mm_setzero_ps()},
+        {_mm_loadu_ps(t[0] + i), _mm_loadu_ps(t[1] + i), _mm_loadu_ps(t[2] + i), one},
+    };
+    for (int col = 0; col != 4; ++col)
+    {
+        // lanes hold slots, transpose to one column per slot
+        _MM_TRANSPOSE4_PS(c[col][0], c[col][1], c[col][2], c[col][3]);
+        _mm_storeu_ps(m0 + 4 * col, c[col][0]);
+        _mm_storeu_ps(m1 + 4 * col, c[col][1]);
+        _mm_storeu_ps(m2 + 4 * col, c[col][2]);
+        _mm_storeu_ps(m3 + 4 * col, c[col][3]);
+    }
+}
+#endif
+}  // namespace
+
+flat_scene::flat_scene(doc const& d, size_t scene) : slots(d.nodes.size(), -1)
+{
+    std::vector<std::pair<uint32_t, int32_t>> stack;  // node and slot of its parent
+    if (scene < d.scenes.size())
+    {
+        auto const& roots = d.scenes[scene].root_nodes;
+        for (auto it = roots.rbegin(); it != roots.rend(); ++it) stack.emplace_back(*it, -1);
+    }
+    else
+    {
+        std::vector<uint8_t> has_parent(d.nodes.size(), 0);
+        for (auto const& n : d.nodes)
+            for (auto c : n.children)
+                if (c < has_parent.size()) has_parent[c] = 1;
+        for (size_t i = d.nodes.size(); i-- > 0;)
+            if (!has_parent[i]) stack.emplace_back(static_cast<uint32_t>(i), -1);
+    }
+
+    while (!stack.empty())
+    {
+        auto const [n, parent] = stack.back();
+        stack.pop_back();
+        // dangling index, or a node reachable twice in a malformed hierarchy
+        if (n >= d.nodes.size() || slots[n] != -1) continue;
+        auto const  s   = static_cast<int32_t>(parents.size());
+        auto const& src = d.nodes[n];
+        slots[n]        = s;
+        parents.push_back(parent);
+        nodes.push_back(n);
+        for (int i = 0; i != 3; ++i)
+        {
+            translations[i].push_back(src.translation[i]);
+            scales[i].push_back(src.scale[i]);
+        }
+        for (int i = 0; i != 4; ++i) rotations[i].push_back(src.rotaton[i]);
+        for (auto it = src.children.rbegin(); it != src.children.rend(); ++it) stack.emplace_back(*it, s);
+    }
+
+    auto const count = static_cast<uint32_t>(parents.size());
+    ends.resize(count);
+    for (uint32_t i = count; i-- > 0;)
+    {
+        ends[i] = std::max(ends[i], i + 1);
+        if (parents[i] >= 0) ends[parents[i]] = std::max(ends[parents[i]], ends[i]);
+    }
+    worlds.resize(count);
+    dirty.assign(count, 0);
+    changed.reserve(count);  // every slot is recorded at most once, so marking never allocates
+    partition({0, count}, full_spine, full_tasks);
+    compute_world_transforms();
+}
+
+glm::vec3 flat_scene::translation(size_t slot) const noexcept
+{
+    return glm::vec3(translations[0][slot], translations[1][slot], translations[2][slot]);
+}
+
+glm::qua<float> flat_scene::rotation(size_t slot) const noexcept
+{
+    return glm::qua<float>(rotations[3][slot], rotations[0][slot], rotations[1][slot], rotations[2][slot]);
+}
+
+glm::vec3 flat_scene::scale(size_t slot) const noexcept { return glm::vec3(scales[0][slot], scales[1][slot], scales[2][slot]); }
+
+void flat_scene::set_translation(size_t slot, glm::vec3 const& t) noexcept
+{
+    for (int i = 0; i != 3; ++i) translations[i][slot] = t[i];
+    mark(slot);
+}
+
+void flat_scene::set_rotation(size_t slot, glm::qua<float> const& r) noexcept
+{
+    for (int i = 0; i != 4; ++i) rotations[i][slot] = r[i];
+    mark(slot);
+}
+
+void flat_scene::set_scale(size_t slot, glm::vec3 const& s) noexcept
+{
+    for (int i = 0; i != 3; ++i) scales[i][slot] = s[i];
+    mark(slot);
+}
+
+void flat_scene::mark(size_t slot) noexcept
+{
+    if (dirty[slot]) return;
+    dirty[slot] = 1;
+    changed.push_back(static_cast<uint32_t>(slot));
+}
+
+void flat_scene::compute_world_transforms(thread_pool* pool)
+{
+    evaluate(full_spine, full_tasks, pool);
+    for (auto s : changed) dirty[s] = 0;
+    changed.clear();
+}
+
+void flat_scene::update_world_transforms(thread_pool* pool)
+{
+    if (changed.empty()) return;
+    // in depth first order a changed slot inside the subtree of an earlier one is covered by it
+    std::sort(changed.begin(), changed.end());
+    std::vector<uint32_t> spine;
+    std::vector<range>    tasks;
+    uint32_t              covered = 0;
+    for (auto s : changed)
+    {
+        dirty[s] = 0;
+        if (s < covered) continue;
+        partition({s, ends[s]}, spine, tasks);
+        covered = ends[s];
+    }
+    changed.clear();
+    evaluate(spine, tasks, pool);
+}
+
+// Splits a run of sibling subtrees into tasks of at most task_grain slots. Subtrees above that size are split
+// below their root, those roots become the spine that is evaluated before the tasks.
+void flat_scene::partition(range siblings, std::vector<uint32_t>& spine, std::vector<range>& tasks) const
+{
+    std::vector<range> pending{siblings};
+    while (!pending.empty())
+    {
+        auto const r = pending.back();
+        pending.pop_back();
+        auto run = r.begin;  // start of the current run of small subtrees
+        for (auto c = r.begin; c != r.end; c = ends[c])
+        {
+            if (ends[c] - c <= task_grain)
+            {
+                if (ends[c] - run > task_grain)
+                {
+                    tasks.push_back({run, c});
+                    run = c;
+                }
+                continue;
+            }
+            if (run != c) tasks.push_back({run, c});
+            spine.push_back(c);
+            pending.push_back({c + 1, ends[c]});
+            run = ends[c];
+        }
+        if (run != r.end) tasks.push_back({run, r.end});
+    }
+}
+
+void flat_scene::evaluate(std::span<uint32_t const> spine, std::span<range const> tasks, thread_pool* pool)
+{
+    for (auto s : spine) evaluate(range{s, s + 1});
+    if (pool && pool->size() > 1 && tasks.size() > 1)
+        pool->for_each(tasks.size(), [&](size_t i, size_t) { evaluate(tasks[i]); });
+    else
+        for (auto r : tasks) evaluate(r);
+}
+
+// The parent of r.begin is outside of r and already evaluated, every other parent precedes its children in r.
+void flat_scene::evaluate(range r) noexcept
+{
+    float const* const t[] = {translations[0].data(), translations[1].data(), translations[2].data()};
+    float const* const q[] = {rotations[0].data(), rotations[1].data(), rotations[2].data(), rotations[3].data()};
+    float const* const s[] = {scales[0].data(), scales[1].data(), scales[2].data()};
+    auto const         m   = [this](size_t i) { return &worlds[i][0][0]; };
+
+    size_t i = r.begin;
+#if TRIVIAL_GLTF_X86_SIMD
+    for (; i + 4 <= r.end; i += 4) local_matrices_sse(t, q, s, i, m(i), m(i + 1), m(i + 2), m(i + 3));
+#endif
+    for (; i != r.end; ++i)
+    {
+        float const tv[] = {t[0][i], t[1][i], t[2][i]};
+        float const qv[] = {q[0][i], q[1][i], q[2][i], q[3][i]};
+        float const sv[] = {s[0][i], s[1][i], s[2][i]};
+        local_matrix(tv, qv, sv, m(i));
+    }
+    for (i = r.begin; i != r.end; ++i)
+        if (parents[i] >= 0) multiply_mat4(m(parents[i]), m(i), m(i));
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,172 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/gltf_parse.h>
+#include <algorithm>
+#include <cstring>
+
+namespace trivial_gltf
+{
+namespace
+{
+constexpr uint32_t chunk_header_size = 8;
+
+void bind_bin_chunk(doc& dest, std::span<std::byte const> bin)
+{
+    if (dest.buffers.empty()) return;
+    if (auto* first = std::get_if<infile_buffer>(&dest.buffers.front())) first->data = bin.first(std::min(bin.size(), first->byte_length));
+}
+}  // namespace
+
+glb_reader::glb_reader(doc& destination, parse_options options) : dest{destination}, json_parser{destination, options} {}
+
+glb_reader::glb_reader(doc& destination, doc_listener& listener, parse_options options)
+    : dest{destination}, json_parser{destination, listener, options}
+{
+}
+
+parse_state glb_reader::operator()(std::span<char const> const& bytes)
+{
+    auto input = bytes;
+    while (!input.empty() && current != stage::done && current != stage::error)
+    {
+        switch (current)
+        {
+            case stage::header:
+            case stage::chunk_header:
+            {
+                uint32_t const wanted = current == stage::header ? sizeof(glb_header) : chunk_header_size;
+                auto const     n      = std::min<size_t>(wanted - header_fill, input.size());
+                std::memcpy(header_bytes.data() + header_fill, input.data(), n);
+                header_fill += n;
+                consumed += n;
+                input = input.subspan(n);
+                if (header_fill != wanted) break;
+                header_fill = 0;
+
+                if (current == stage::header)
+                {
+                    glb_header h;
+                    std::memcpy(&h, header_bytes.data(), sizeof(h));
+                    if (h.magic != glb_magic || h.version != 2 || h.length < sizeof(glb_header))
+                    {
+                        current = stage::error;
+                        break;
+                    }
+                    total_length = h.length;
+                    current      = stage::chunk_header;
+                }
+                else
+                {
+                    uint32_t chunk_length, chunk_type;
+                    std::memcpy(&chunk_length, header_bytes.data(), 4);
+                    std::memcpy(&chunk_type, header_bytes.data() + 4, 4);
+                    if (chunk_length > total_length - consumed)
+                    {
+                        current = stage::error;
+                        break;
+                    }
+                    chunk_remaining = chunk_length;
+                    if (chunk_type == glb_json_chunk)
+                        current = stage::json;
+                    else if (chunk_type == glb_bin_chunk && !bin_seen)
+                    {
+                        bin_seen = true;
+                        bin_storage.reserve(chunk_length);
+                        current = stage::bin;
+                    }
+                    else
+                        current = stage::skip;
+                    // an empty chunk has no bytes that would move on to the next header
+                    if (chunk_length == 0) current = stage::chunk_header;
+                }
+                break;
+            }
+            case stage::json:
+            case stage::bin:
+            case stage::skip:
+            {
+                auto const n     = std::min<size_t>(chunk_remaining, input.size());
+                auto const chunk = input.first(n);
+                if (current == stage::json)
+                {
+                    json_state = json_parser(chunk);
+                    if (json_state == parse_state::error) current = stage::error;
+                }
+                else if (current == stage::bin)
+                {
+                    auto const* b = reinterpret_cast<std::byte const*>(chunk.data());
+                    bin_storage.insert(bin_storage.end(), b, b + n);
+                }
+                chunk_remaining -= n;
+                consumed += n;
+                input = input.subspan(n);
+                if (chunk_remaining == 0 && current != stage::error) current = stage::chunk_header;
+                break;
+            }
+            default: break;
+        }
+        if (current == stage::chunk_header && consumed == total_length && header_fill == 0) finish();
+    }
+    switch (current)
+    {
+        case stage::done: return parse_state::json_complete;
+        case stage::error: return parse_state::error;
+        default: return parse_state::more_input_needed;
+    }
+}
+
+void glb_reader::finish()
+{
+    if (json_state != parse_state::json_complete)
+    {
+        current = stage::error;
+        return;
+    }
+    bin = bin_storage;
+    bind_bin_chunk(dest, bin);
+    current = stage::done;
+}
+
+parse_state parse_glb(std::span<std::byte const> file, doc& destination, parse_options options)
+{
+    parser json_parser(destination, options);
+    return parse_glb(file, json_parser);
+}
+
+parse_state parse_glb(std::span<std::byte const> file, parser& json_parser)
+{
+    glb_header h;
+    if (file.size() < sizeof(h)) return parse_state::error;
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (h.magic != glb_magic || h.version != 2 || h.length > file.size()) return parse_state::error;
+
+    auto                       result = parse_state::more_input_needed;
+    std::span<std::byte const> bin;
+    bool                       bin_seen = false;
+    for (size_t pos = sizeof(h); pos + chunk_header_size <= h.length;)
+    {
+        uint32_t chunk_length, chunk_type;
+        std::memcpy(&chunk_length, file.data() + pos, 4);
+        std::memcpy(&chunk_type, file.data() + pos + 4, 4);
+        pos += chunk_header_size;
+        if (chunk_length > h.length - pos) return parse_state::error;
+        auto chunk = file.subspan(pos, chunk_length);
+        if (chunk_type == glb_json_chunk)
+            result = json_parser(std::span<char const>(reinterpret_cast<char const*>(chunk.data()), chunk.size()));
+        else if (chunk_type == glb_bin_chunk && !bin_seen)
+        {
+            bin_seen = true;
+            bin      = chunk;
+        }
+        if (result == parse_state::error) return result;
+        pos += chunk_length;
+    }
+    if (result != parse_state::json_complete) return parse_state::error;
+    bind_bin_chunk(json_parser.destination(), bin);
+    return result;
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,108 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/image_store.h>
+
+namespace trivial_gltf
+{
+image_cache_stats image_cache::stats() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return counters;
+}
+
+void image_cache::clear()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    counters.evictions += entries.size();
+    counters.bytes      = 0;
+    entries.clear();
+    order.clear();
+}
+
+image_cache::contents image_cache::find(key k)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto const                  it = entries.find(k);
+    if (it == entries.end())
+    {
+        ++counters.misses;
+        return {};
+    }
+    ++counters.hits;
+    order.splice(order.begin(), order, it->second);
+    return it->second->second;
+}
+
+image_cache::contents image_cache::insert(key k, contents c)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (auto const it = entries.find(k); it != entries.end()) return it->second->second;
+    order.emplace_front(k, c);
+    entries.emplace(k, order.begin());
+    counters.bytes += c->size();
+    // the new entry goes last, when it exceeds the budget on its own it is only held by the caller
+    while (counters.bytes > budget && !order.empty())
+    {
+        counters.bytes -= order.back().second->size();
+        entries.erase(order.back().first);
+        order.pop_back();
+        ++counters.evictions;
+    }
+    return c;
+}
+
+void image_cache::evict_owner(uint64_t owner)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto it = order.begin(); it != order.end();)
+    {
+        if (it->first.owner != owner)
+        {
+            ++it;
+            continue;
+        }
+        counters.bytes -= it->second->size();
+        entries.erase(it->first);
+        it = order.erase(it);
+    }
+}
+
+image_store::image_store(doc const& d, resource_fetcher& fetcher, image_cache& cache)
+    : d{d}, fetcher{fetcher}, cache{cache}, owner{cache.register_owner()}
+{
+}
+
+image_store::~image_store() { cache.evict_owner(owner); }
+
+image_bytes image_store::get(size_t image)
+{
+    if (image >= d.images.size()) return {};
+    auto const& i = d.images[image];
+    if (auto const* in = std::get_if<infile_image>(&i)) return {view_data(d, static_cast<size_t>(in->buffer_view)), nullptr};
+    if (auto const* em = std::get_if<embedded_image>(&i)) return {em->bytes, nullptr};
+
+    auto const& uri = std::get<external_image>(i).uri;
+    if (uri.starts_with("data:")) return {};
+    image_cache::key const k{owner, image};
+    auto                   c = cache.find(k);
+    if (!c)
+    {
+        auto loaded = std::make_shared<std::vector<std::byte>>();
+        if (!fetcher.fetch(uri, *loaded)) return {};
+        c = cache.insert(k, std::move(loaded));
+    }
+    return {*c, c};
+}
+
+std::string_view image_store::mime(size_t image) const noexcept
+{
+    if (image >= d.images.size()) return {};
+    if (auto const* in = std::get_if<infile_image>(&d.images[image])) return in->mime;
+    if (auto const* em = std::get_if<embedded_image>(&d.images[image])) return em->mime;
+    return {};
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,97 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_KEYWORD_MATCHER_H_INCLUDED
+#define TRIVIAL_GLTF_KEYWORD_MATCHER_H_INCLUDED
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace trivial_gltf
+{
+// Prefix tree over a fixed set of keywords, built at compile time. Matching is a walk over the tree one
+// character at a time, so the whole match state is a single node index that can be kept across string
+// fragments of a streamed value.
+template <size_t Nodes>
+class keyword_trie
+{
+   public:
+    using state_type = uint16_t;
+
+    static constexpr state_type root     = 0;
+    static constexpr state_type dead     = 0xFFFF;
+    static constexpr int16_t    no_match = -1;
+
+    template <size_t N>
+    constexpr explicit keyword_trie(char const* const (&words)[N])
+    {
+        static_assert(Nodes < dead, "too many keywords");
+        for (size_t i = 0; i != N; ++i) insert(words[i], static_cast<int16_t>(i));
+    }
+
+    constexpr state_type step(state_type state, char c) const noexcept
+    {
+        if (state == dead) return dead;
+        for (auto n = nodes[state].child; n != root; n = nodes[n].sibling)
+            if (nodes[n].c == c) return n;
+        return dead;
+    }
+
+    constexpr state_type feed(state_type state, std::string_view fragment) const noexcept
+    {
+        for (auto c : fragment)
+            if ((state = step(state, c)) == dead) break;
+        return state;
+    }
+
+    // index of the keyword ending in state or no_match
+    constexpr int16_t value(state_type state) const noexcept { return state == dead ? no_match : nodes[state].value; }
+
+    constexpr int16_t find(std::string_view word) const noexcept { return value(feed(root, word)); }
+
+   private:
+    struct node
+    {
+        char       c{0};
+        state_type child{root};
+        state_type sibling{root};
+        int16_t    value{no_match};
+    };
+
+    constexpr void insert(std::string_view word, int16_t value)
+    {
+        state_type n = root;
+        for (auto c : word)
+        {
+            auto next = step(n, c);
+            if (next == dead)
+            {
+                next                = used++;
+                nodes[next].c       = c;
+                nodes[next].sibling = nodes[n].child;
+                nodes[n].child      = next;
+            }
+            n = next;
+        }
+        nodes[n].value = value;
+    }
+
+    std::array<node, Nodes> nodes{};
+    state_type              used{1};
+};
+
+// upper bound of the number of nodes needed for the keywords
+template <size_t N>
+constexpr size_t trie_size(char const* const (&words)[N])
+{
+    size_t size = 1;
+    for (auto w : words) size += std::string_view(w).size();
+    return size;
+}
+}  // namespace trivial_gltf
+
+#endif
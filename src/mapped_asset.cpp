@@ -0,0 +1,145 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/mapped_asset.h>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TRIVIAL_GLTF_POSIX_FILES 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <memory>
+#endif
+
+namespace trivial_gltf
+{
+namespace
+{
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void release(void* address, [[maybe_unused]] size_t size) noexcept
+{
+    if (!address) return;
+#if TRIVIAL_GLTF_POSIX_FILES
+    ::munmap(address, size);
+#else
+    delete[] static_cast<std::byte*>(address);
+#endif
+}
+}  // namespace
+
+std::filesystem::path resolve_uri(std::filesystem::path const& base, std::string_view uri)
+{
+    std::string decoded;
+    decoded.reserve(uri.size());
+    for (size_t i = 0; i < uri.size(); ++i)
+    {
+        if (uri[i] == '%' && i + 2 < uri.size() && hex_value(uri[i + 1]) >= 0 && hex_value(uri[i + 2]) >= 0)
+        {
+            decoded.push_back(static_cast<char>(hex_value(uri[i + 1]) * 16 + hex_value(uri[i + 2])));
+            i += 2;
+        }
+        else
+            decoded.push_back(uri[i]);
+    }
+    return base / decoded;
+}
+
+mapped_file::mapped_file(std::filesystem::path const& file)
+{
+#if TRIVIAL_GLTF_POSIX_FILES
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void* mem = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem != MAP_FAILED)
+        {
+            address = mem;
+            size    = static_cast<size_t>(st.st_size);
+        }
+    }
+    ::close(fd);
+#else
+    // without mmap the file is read at once
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    auto const    end = in ? static_cast<std::streamoff>(in.tellg()) : std::streamoff{0};
+    if (end <= 0 || !in.seekg(0)) return;
+    auto contents = std::make_unique<std::byte[]>(static_cast<size_t>(end));
+    if (!in.read(reinterpret_cast<char*>(contents.get()), end)) return;
+    address = contents.release();
+    size    = static_cast<size_t>(end);
+#endif
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : address{std::exchange(other.address, nullptr)}, size{std::exchange(other.size, 0)}
+{
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other)
+    {
+        release(address, size);
+        address = std::exchange(other.address, nullptr);
+        size    = std::exchange(other.size, 0);
+    }
+    return *this;
+}
+
+mapped_file::~mapped_file() { release(address, size); }
+
+mapped_asset::mapped_asset(std::filesystem::path const& file, parse_options options) : main{file}
+{
+    if (!main) return;
+    auto const bytes = main.bytes();
+    if (bytes.size() >= 4 && std::memcmp(bytes.data(), "glTF", 4) == 0)
+        result = parse_glb(bytes, asset, options);
+    else
+        result = create_parser(asset, options)(std::span<char const>(reinterpret_cast<char const*>(bytes.data()), bytes.size()));
+    if (result != parse_state::json_complete)
+    {
+        result = parse_state::error;
+        return;
+    }
+
+    auto const base = file.parent_path();
+    for (auto& b : asset.buffers)
+    {
+        auto* ext = std::get_if<external_buffer>(&b);
+        if (!ext || ext->uri.starts_with("data:")) continue;
+        auto& mapping = external.emplace_back(resolve_uri(base, ext->uri));
+        if (!mapping || mapping.bytes().size() < ext->byte_length)
+        {
+            result = parse_state::error;
+            return;
+        }
+        ext->data = mapping.bytes().first(ext->byte_length);
+    }
+
+    views.reserve(asset.buffer_views.size());
+    for (size_t i = 0; i != asset.buffer_views.size(); ++i)
+    {
+        auto const& desc = asset.buffer_views[i];
+        auto        view = trivial_gltf::view_data(asset, i);
+        // views into buffers that nobody bound (data uris that are not base64) stay empty
+        if (view.size() != desc.length && !trivial_gltf::buffer_data(asset, desc.buffer).empty()) result = parse_state::error;
+        views.push_back(view);
+    }
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,39 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_MATRIX_SIMD_H_INCLUDED
+#define TRIVIAL_GLTF_MATRIX_SIMD_H_INCLUDED
+
+#include "simd.h"
+#include <algorithm>
+
+namespace trivial_gltf
+{
+// out = a * b over column major 4x4 float matrices, out may alias either operand
+inline void multiply_mat4(float const* a, float const* b, float* out) noexcept
+{
+#if TRIVIAL_GLTF_X86_SIMD
+    auto const a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+    __m128     r[4];
+    for (int col = 0; col != 4; ++col)
+    {
+        auto const* c = b + 4 * col;
+        r[col]        = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(c[0])), _mm_mul_ps(a1, _mm_set1_ps(c[1]))),
+                                   _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(c[2])), _mm_mul_ps(a3, _mm_set1_ps(c[3]))));
+    }
+    for (int col = 0; col != 4; ++col) _mm_storeu_ps(out + 4 * col, r[col]);
+#else
+    float r[16];
+    for (int col = 0; col != 4; ++col)
+        for (int row = 0; row != 4; ++row)
+            r[4 * col + row] =
+                a[row] * b[4 * col] + a[4 + row] * b[4 * col + 1] + a[8 + row] * b[4 * col + 2] + a[12 + row] * b[4 * col + 3];
+    std::copy(r, r + 16, out);
+#endif
+}
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,872 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include "simd.h"
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/mesh_optimize.h>
+#include <trivial_gltf/thread_pool.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <unordered_map>
+
+namespace trivial_gltf
+{
+namespace
+{
+constexpr uint32_t array_buffer         = 34962;
+constexpr uint32_t element_array_buffer = 34963;
+constexpr uint32_t unassigned           = ~0u;
+
+struct tipsify_scratch
+{
+    std::vector<uint32_t> offsets;     // into triangles, per vertex
+    std::vector<uint32_t> triangles;   // adjacent triangles of every vertex
+    std::vector<uint32_t> live;        // adjacent triangles not yet emitted
+    std::vector<uint32_t> cache_time;  // time stamp of entering the cache
+    std::vector<uint32_t> dead_end;    // recently emitted vertices
+    std::vector<uint32_t> candidates;  // vertices of the last fan
+    std::vector<uint8_t>  emitted;
+};
+
+// Emits the triangles as fans around a current vertex. The next vertex is picked among those of the last fan,
+// preferring the one that entered the cache longest ago that still stays in the cache while its own fan is
+// emitted, or from the dead end stack of recent vertices when none has triangles left.
+bool tipsify(std::span<uint32_t const> indices, size_t vertex_count, size_t cache_size, uint32_t* out, tipsify_scratch& s)
+{
+    auto const triangle_count = indices.size() / 3;
+    s.offsets.assign(vertex_count + 1, 0);
+    for (size_t i = 0; i != triangle_count * 3; ++i)
+    {
+        if (indices[i] >= vertex_count) return false;
+        ++s.offsets[indices[i] + 1];
+    }
+    s.live.assign(vertex_count, 0);
+    for (size_t v = 0; v != vertex_count; ++v)
+    {
+        s.live[v]          = s.offsets[v + 1];
+        s.offsets[v + 1]  += s.offsets[v];
+    }
+    s.triangles.resize(triangle_count * 3);
+    s.cache_time.assign(s.offsets.begin(), s.offsets.end() - 1);  // fill cursors first
+    for (size_t i = 0; i != triangle_count * 3; ++i) s.triangles[s.cache_time[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    s.cache_time.assign(vertex_count, 0);
+    s.emitted.assign(triangle_count, 0);
+    s.dead_end.clear();
+
+    auto   time    = static_cast<uint32_t>(cache_size + 1);
+    size_t cursor  = 0;
+    auto   fanning = triangle_count ? indices[0] : unassigned;
+    while (fanning != unassigned)
+    {
+        s.candidates.clear();
+        for (auto k = s.offsets[fanning]; k != s.offsets[fanning + 1]; ++k)
+        {
+            auto const t = s.triangles[k];
+            if (s.emitted[t]) continue;
+            s.emitted[t] = 1;
+            for (size_t j = 0; j != 3; ++j)
+            {
+                auto const v = indices[3 * t + j];
+                *out++       = v;
+                s.dead_end.push_back(v);
+                s.candidates.push_back(v);
+                --s.live[v];
+                if (time - s.cache_time[v] > cache_size) s.cache_time[v] = time++;
+            }
+        }
+
+        fanning      = unassigned;
+        int64_t best = -1;
+        for (auto v : s.candidates)
+        {
+            if (s.live[v] == 0) continue;
+            int64_t priority = 0;
+            if (time - s.cache_time[v] + 2 * s.live[v] <= cache_size) priority = time - s.cache_time[v];
+            if (priority > best)
+            {
+                best    = priority;
+                fanning = v;
+            }
+        }
+        while (fanning == unassigned && !s.dead_end.empty())
+        {
+            if (s.live[s.dead_end.back()] > 0) fanning = s.dead_end.back();
+            s.dead_end.pop_back();
+        }
+        for (; fanning == unassigned && cursor != vertex_count; ++cursor)
+            if (s.live[cursor] > 0) fanning = static_cast<uint32_t>(cursor);
+    }
+    return true;
+}
+
+struct overdraw_scratch
+{
+    std::vector<uint64_t> loaded;    // miss count when a vertex entered the cache
+    std::vector<uint32_t> clusters;  // first triangle of every cluster
+    std::vector<float>    keys;      // per cluster
+    std::vector<uint32_t> order;     // of the clusters
+};
+
+// fifo cache as in average_cache_miss_ratio, returns the misses of a triangle
+uint32_t cache_misses(uint32_t const* triangle, size_t cache_size, uint64_t& misses, std::vector<uint64_t>& loaded) noexcept
+{
+    uint32_t result = 0;
+    for (size_t j = 0; j != 3; ++j)
+    {
+        auto const v = triangle[j];
+        if (loaded[v] != 0 && misses + 1 - loaded[v] <= cache_size) continue;
+        loaded[v] = ++misses;
+        ++result;
+    }
+    return result;
+}
+
+// Splits the triangles, in vertex cache order, into clusters and emits the clusters facing away from the center of
+// the mesh first. A cluster begins where the cache runs empty, at a triangle with three misses, and is then split
+// wherever the miss ratio since its last split gets below threshold times that of the whole cluster. The splits
+// are measured from an empty cache, so that sorting the clusters keeps the miss ratio about within the threshold.
+void cluster_by_depth(std::span<uint32_t const> indices, float const* positions, size_t vertex_count, size_t cache_size, float threshold,
+                      uint32_t* out, overdraw_scratch& s)
+{
+    auto const triangle_count = indices.size() / 3;
+    auto const flush          = cache_size + 1;  // misses that push every vertex out of the cache
+    uint64_t   misses         = 0;
+    s.loaded.assign(vertex_count, 0);
+    s.clusters.clear();
+    for (size_t t = 0; t != triangle_count; ++t)
+        if (cache_misses(&indices[3 * t], cache_size, misses, s.loaded) == 3 || t == 0) s.clusters.push_back(static_cast<uint32_t>(t));
+
+    auto const hard = s.clusters.size();
+    for (size_t c = 0; c != hard; ++c)
+    {
+        auto const begin    = s.clusters[c];
+        auto const end      = c + 1 != hard ? s.clusters[c + 1] : static_cast<uint32_t>(triangle_count);
+        uint64_t   expected = 0;
+        misses += flush;
+        for (auto t = begin; t != end; ++t) expected += cache_misses(&indices[3 * t], cache_size, misses, s.loaded);
+        auto const limit = threshold * static_cast<float>(expected) / static_cast<float>(end - begin);
+
+        auto const first   = s.clusters.size();
+        uint64_t   running = 0;
+        uint32_t   faces   = 0;
+        misses += flush;
+        for (auto t = begin; t != end; ++t)
+        {
+            running += cache_misses(&indices[3 * t], cache_size, misses, s.loaded);
+            if (static_cast<float>(running) > limit * static_cast<float>(++faces)) continue;
+            s.clusters.push_back(t + 1);
+            misses  += flush;
+            running  = 0;
+            faces    = 0;
+        }
+        // no split at the end, and a tail above the limit joins the cluster before it
+        if (s.clusters.size() != first && (s.clusters.back() == end || faces != 0)) s.clusters.pop_back();
+    }
+    // the splits of every hard cluster were appended behind the hard ones
+    std::sort(s.clusters.begin(), s.clusters.end());
+    s.clusters.push_back(static_cast<uint32_t>(triangle_count));
+
+    // area weighted centers and normals, cross products are twice the area
+    auto const vertex = [positions](uint32_t v) { return positions + 3 * size_t{v}; };
+    auto const weigh  = [&](uint32_t t, float* center, float* normal)
+    {
+        auto const* a = vertex(indices[3 * t]);
+        auto const* b = vertex(indices[3 * t + 1]);
+        auto const* c = vertex(indices[3 * t + 2]);
+        float const e[] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float const f[] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float const n[] = {e[1] * f[2] - e[2] * f[1], e[2] * f[0] - e[0] * f[2], e[0] * f[1] - e[1] * f[0]};
+        auto const  w   = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (size_t k = 0; k != 3; ++k)
+        {
+            center[k] += w * (a[k] + b[k] + c[k]) / 3.0f;
+            normal[k] += n[k];
+        }
+        return w;
+    };
+    float mesh_center[3] = {0, 0, 0}, mesh_normal[3] = {0, 0, 0}, mesh_area = 0;
+    for (size_t t = 0; t != triangle_count; ++t) mesh_area += weigh(static_cast<uint32_t>(t), mesh_center, mesh_normal);
+    for (auto& x : mesh_center) x = mesh_area > 0 ? x / mesh_area : 0.0f;
+
+    auto const cluster_count = s.clusters.size() - 1;
+    s.keys.assign(cluster_count, 0.0f);
+    for (size_t c = 0; c != cluster_count; ++c)
+    {
+        float center[3] = {0, 0, 0}, normal[3] = {0, 0, 0}, area = 0;
+        for (auto t = s.clusters[c]; t != s.clusters[c + 1]; ++t) area += weigh(t, center, normal);
+        auto const length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area <= 0 || length <= 0) continue;
+        for (size_t k = 0; k != 3; ++k) s.keys[c] += (center[k] / area - mesh_center[k]) * normal[k] / length;
+    }
+    s.order.resize(cluster_count);
+    std::iota(s.order.begin(), s.order.end(), 0u);
+    std::stable_sort(s.order.begin(), s.order.end(), [&s](uint32_t a, uint32_t b) { return s.keys[a] > s.keys[b]; });
+    auto* const first = out;
+    for (auto c : s.order) out = std::copy(&indices[3 * s.clusters[c]], &indices[3 * s.clusters[c + 1]], out);
+
+    // A cluster that reused vertices of the one before it in cache order misses them when moved elsewhere, which the
+    // splits above do not account for. Where that takes the result beyond the threshold the cache order is kept.
+    auto const total = [&](uint32_t const* triangles)
+    {
+        uint64_t result = 0;
+        misses          = 0;
+        s.loaded.assign(vertex_count, 0);
+        for (size_t t = 0; t != triangle_count; ++t) result += cache_misses(triangles + 3 * t, cache_size, misses, s.loaded);
+        return result;
+    };
+    if (static_cast<double>(total(first)) > static_cast<double>(threshold) * static_cast<double>(total(indices.data())))
+        std::copy(indices.begin(), indices.end(), first);
+}
+
+// primitives that share all of their vertex accessors, reordered together
+struct vertex_group
+{
+    std::vector<std::pair<size_t, size_t>> primitives;  // mesh and primitive
+    std::vector<uint32_t>                  accessors;   // distinct vertex accessors, attributes and targets
+    size_t                                 vertex_count{0};
+    std::vector<size_t>                    index_offsets;   // into storage, per primitive
+    std::vector<component>                 index_types;     // per primitive
+    std::vector<size_t>                    vertex_offsets;  // into storage, per accessor
+    std::vector<uint32_t>                  remap;           // old to welded vertex
+    std::vector<uint32_t>                  distinct;        // first old vertex of every welded vertex
+    bool                                   done{false};
+};
+
+struct worker_scratch
+{
+    tipsify_scratch        fans;
+    overdraw_scratch       depth;
+    std::vector<uint32_t>  indices;
+    std::vector<uint32_t>  optimized;
+    std::vector<uint32_t>  clustered;
+    std::vector<float>     positions;
+    std::vector<uint32_t>  remap;  // old to new vertex
+    std::vector<std::byte> elements;
+    std::vector<std::byte> rows;   // all attributes of a vertex side by side
+    std::vector<uint32_t>  table;  // open addressed, distinct vertices by row hash
+};
+
+size_t vertex_stride(accessor const& acc) noexcept { return (element_size(acc.comp_type, acc.type) + 3) & ~size_t{3}; }
+size_t align(size_t offset) noexcept { return (offset + 15) & ~size_t{15}; }
+
+// Vertices of a primitive may get higher numbers within the group than they had before. The largest value of a
+// component type is the primitive restart value, which gltf does not allow as an index.
+component index_type(component original, size_t vertex_count) noexcept
+{
+    if (vertex_count >= 65536) return component::unsigned_int_type;
+    if (vertex_count >= 256 && original == component::unsigned_byte_type) return component::unsigned_short_type;
+    return original;
+}
+
+// the vertex count, zero if the primitive is not indexed over consistent accessors, or no triangle list when required
+size_t eligible_vertex_count(doc const& d, primitive const& p, bool triangles_only) noexcept
+{
+    if ((triangles_only && p.mode != mode_type::triangles) || p.indices < 0 || static_cast<size_t>(p.indices) >= d.accessors.size() ||
+        p.attributes.empty())
+        return 0;
+    auto const& indices = d.accessors[p.indices];
+    if (indices.type != attribute_type::scalar || indices.count == 0 || (triangles_only && indices.count % 3 != 0) ||
+        (indices.comp_type != component::unsigned_byte_type && indices.comp_type != component::unsigned_short_type &&
+         indices.comp_type != component::unsigned_int_type))
+        return 0;
+
+    auto const first = tiny_tuple::get<1>(p.attributes.front());
+    if (first >= d.accessors.size()) return 0;
+    size_t const count = d.accessors[first].count;
+    auto const   valid = [&](std::pmr::vector<attribute_offset> const& attributes)
+    {
+        return std::all_of(attributes.begin(), attributes.end(),
+                           [&](attribute_offset const& a)
+                           {
+                               auto const index = tiny_tuple::get<1>(a);
+                               return index < d.accessors.size() && d.accessors[index].count == count &&
+                                      element_size(d.accessors[index].comp_type, d.accessors[index].type) != 0;
+                           });
+    };
+    if (!valid(p.attributes) || !std::all_of(p.targets.begin(), p.targets.end(), valid)) return 0;
+    return count;
+}
+
+void write_indices(std::span<uint32_t const> indices, component c, std::byte* out) noexcept
+{
+    for (size_t i = 0; i != indices.size(); ++i)
+    {
+        if (c == component::unsigned_byte_type)
+            out[i] = static_cast<std::byte>(indices[i]);
+        else if (c == component::unsigned_short_type)
+        {
+            auto const v = static_cast<uint16_t>(indices[i]);
+            std::memcpy(out + 2 * i, &v, 2);
+        }
+        else
+            std::memcpy(out + 4 * i, &indices[i], 4);
+    }
+}
+
+// the positions of the group as x, y, z per vertex, none when there is no usable position attribute
+bool decode_positions(doc const& d, vertex_group const& g, worker_scratch& s) noexcept
+{
+    auto const& p = d.meshes[g.primitives.front().first].primitives[g.primitives.front().second];
+    for (auto const& a : p.attributes)
+    {
+        if (tiny_tuple::get<0>(a) != attribute::position) continue;
+        auto const& acc = d.accessors[tiny_tuple::get<1>(a)];
+        s.positions.resize(g.vertex_count * 3);
+        return acc.type == attribute_type::vec3 && decode_floats(d, acc, s.positions) == s.positions.size();
+    }
+    return false;
+}
+
+bool optimize_group(doc const& d, vertex_group const& g, size_t cache_size, float overdraw_threshold, std::byte* storage, worker_scratch& s)
+{
+    auto const n     = g.vertex_count;
+    auto const depth = overdraw_threshold > 0 && decode_positions(d, g, s);
+    s.remap.assign(n, unassigned);
+    uint32_t next = 0;
+    for (size_t i = 0; i != g.primitives.size(); ++i)
+    {
+        auto const& p   = d.meshes[g.primitives[i].first].primitives[g.primitives[i].second];
+        auto const& acc = d.accessors[p.indices];
+        s.indices.resize(acc.count);
+        s.optimized.resize(acc.count);
+        if (widen_indices(d, acc, s.indices) != acc.count || !tipsify(s.indices, n, cache_size, s.optimized.data(), s.fans)) return false;
+        if (depth)
+        {
+            s.clustered.resize(acc.count);
+            cluster_by_depth(s.optimized, s.positions.data(), n, cache_size, overdraw_threshold, s.clustered.data(), s.depth);
+            s.optimized.swap(s.clustered);
+        }
+        // vertices are numbered by first use, continuing across the primitives of the group
+        for (auto& v : s.optimized)
+        {
+            if (s.remap[v] == unassigned) s.remap[v] = next++;
+            v = s.remap[v];
+        }
+        write_indices(s.optimized, g.index_types[i], storage + g.index_offsets[i]);
+    }
+    // unreferenced vertices are kept behind the others
+    for (auto& r : s.remap)
+        if (r == unassigned) r = next++;
+
+    for (size_t k = 0; k != g.accessors.size(); ++k)
+    {
+        auto const& acc    = d.accessors[g.accessors[k]];
+        auto const  size   = element_size(acc.comp_type, acc.type);
+        auto const  stride = vertex_stride(acc);
+        s.elements.resize(n * size);
+        if (materialize_accessor(d, acc, s.elements) != n * size) return false;
+        auto* out = storage + g.vertex_offsets[k];
+        for (size_t v = 0; v != n; ++v) std::memcpy(out + s.remap[v] * stride, s.elements.data() + v * size, size);
+    }
+    return true;
+}
+
+// primitives grouped by their vertex accessors, in order of first appearance
+std::vector<vertex_group> collect_groups(doc const& d, bool triangles_only)
+{
+    std::vector<vertex_group>               groups;
+    std::map<std::vector<uint32_t>, size_t> by_accessors;
+    std::vector<uint32_t>                   key;
+    for (size_t m = 0; m != d.meshes.size(); ++m)
+        for (size_t i = 0; i != d.meshes[m].primitives.size(); ++i)
+        {
+            auto const& p     = d.meshes[m].primitives[i];
+            auto const  count = eligible_vertex_count(d, p, triangles_only);
+            if (count == 0) continue;
+            key.clear();
+            auto const add_key = [&key](std::pmr::vector<attribute_offset> const& attributes)
+            {
+                for (auto const& a : attributes)
+                {
+                    key.push_back(static_cast<uint32_t>(tiny_tuple::get<0>(a)));
+                    key.push_back(tiny_tuple::get<1>(a));
+                }
+                key.push_back(unassigned);
+            };
+            add_key(p.attributes);
+            for (auto const& t : p.targets) add_key(t);
+
+            auto [it, created] = by_accessors.try_emplace(key, groups.size());
+            if (created)
+            {
+                auto& g        = groups.emplace_back();
+                g.vertex_count = count;
+                auto const add = [&g](std::pmr::vector<attribute_offset> const& attributes)
+                {
+                    for (auto const& a : attributes)
+                        if (std::find(g.accessors.begin(), g.accessors.end(), tiny_tuple::get<1>(a)) == g.accessors.end())
+                            g.accessors.push_back(tiny_tuple::get<1>(a));
+                };
+                add(p.attributes);
+                for (auto const& t : p.targets) add(t);
+            }
+            groups[it->second].primitives.emplace_back(m, i);
+        }
+    return groups;
+}
+
+// a copy of the source accessor over a new view of length bytes into buffer
+uint32_t append_accessor(doc& d, uint32_t source, uint32_t buffer, size_t offset, size_t length, size_t stride, uint32_t target,
+                         size_t count, bool bounds)
+{
+    d.buffer_views.emplace_back(buffer, static_cast<uint32_t>(length), static_cast<uint32_t>(offset), static_cast<uint32_t>(stride), target,
+                                meshopt_compression{});
+    auto* const resource = d.resource();
+    auto const& old      = d.accessors[source];
+    auto const  view     = static_cast<uint32_t>(d.buffer_views.size() - 1);
+    accessor    copy{view, 0, static_cast<uint32_t>(count), old.comp_type, old.type, old.normalized, std::pmr::vector<float>(resource),
+                  std::pmr::vector<float>(resource), sparse_accessor{}};
+    if (bounds)
+    {
+        copy.max.assign(old.max.begin(), old.max.end());
+        copy.min.assign(old.min.begin(), old.min.end());
+    }
+    d.accessors.push_back(std::move(copy));
+    return static_cast<uint32_t>(d.accessors.size() - 1);
+}
+
+// Binds the primitives of a processed group to new accessors over its vertex_count vertices and indices in buffer.
+// The vertices keep their set of values, so the bounds of the attributes still hold.
+void rebind_group(doc& d, vertex_group const& g, uint32_t buffer, size_t vertex_count)
+{
+    std::vector<uint32_t> replaced(g.accessors.size());
+    for (size_t k = 0; k != g.accessors.size(); ++k)
+    {
+        auto const stride = vertex_stride(d.accessors[g.accessors[k]]);
+        auto const offset = g.vertex_offsets[k];
+        auto const length = vertex_count * stride;
+        replaced[k]       = append_accessor(d, g.accessors[k], buffer, offset, length, stride, array_buffer, vertex_count, true);
+    }
+    auto const rebind = [&](std::pmr::vector<attribute_offset>& attributes)
+    {
+        for (auto& a : attributes)
+        {
+            auto const k = std::find(g.accessors.begin(), g.accessors.end(), tiny_tuple::get<1>(a)) - g.accessors.begin();
+            a            = attribute_offset(tiny_tuple::get<0>(a), replaced[k]);
+        }
+    };
+    for (size_t i = 0; i != g.primitives.size(); ++i)
+    {
+        auto& p = d.meshes[g.primitives[i].first].primitives[g.primitives[i].second];
+        rebind(p.attributes);
+        for (auto& t : p.targets) rebind(t);
+        // the renumbered indices have other bounds
+        auto const source = static_cast<uint32_t>(p.indices);
+        auto const count  = d.accessors[source].count;
+        auto const length = count * component_size(g.index_types[i]);
+        auto const index  = append_accessor(d, source, buffer, g.index_offsets[i], length, 0, element_array_buffer, count, false);
+        d.accessors[index].comp_type = g.index_types[i];
+        p.indices                    = static_cast<int32_t>(index);
+    }
+}
+
+uint64_t mix(uint64_t h, uint64_t v) noexcept
+{
+    h = (h ^ v) * 0xff51afd7ed558ccdull;
+    return h ^ (h >> 29);
+}
+
+uint64_t hash_bytes(std::byte const* data, size_t size) noexcept
+{
+    uint64_t h = mix(0x9e3779b97f4a7c15ull, size);
+    size_t   i = 0;
+    for (uint64_t word; i + 8 <= size; i += 8)
+    {
+        std::memcpy(&word, data + i, 8);
+        h = mix(h, word);
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + i, size - i);
+    return mix(h, tail);
+}
+
+bool same_bytes(std::byte const* a, std::byte const* b, size_t size) noexcept
+{
+    size_t i = 0;
+#if TRIVIAL_GLTF_X86_SIMD
+    for (; i + 16 <= size; i += 16)
+    {
+        auto const l = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+        auto const r = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(l, r)) != 0xffff) return false;
+    }
+#endif
+    return std::memcmp(a + i, b + i, size - i) == 0;
+}
+
+// Numbers the distinct vertices of the group in order of first occurrence, comparing the bytes of all attributes
+// and targets of a vertex at once. Renumbered vertices never get a higher number. False without duplicates.
+bool weld_group(doc const& d, vertex_group& g, worker_scratch& s)
+{
+    auto const n   = g.vertex_count;
+    size_t     row = 0;
+    for (auto a : g.accessors) row += vertex_stride(d.accessors[a]);
+    s.rows.assign(n * row, std::byte{0});
+    size_t column = 0;
+    for (auto a : g.accessors)
+    {
+        auto const& acc  = d.accessors[a];
+        auto const  size = element_size(acc.comp_type, acc.type);
+        s.elements.resize(n * size);
+        if (materialize_accessor(d, acc, s.elements) != n * size) return false;
+        for (size_t v = 0; v != n; ++v) std::memcpy(s.rows.data() + v * row + column, s.elements.data() + v * size, size);
+        column += vertex_stride(acc);
+    }
+
+    size_t capacity = 16;
+    while (capacity < 2 * n) capacity *= 2;
+    s.table.assign(capacity, unassigned);
+    g.remap.resize(n);
+    g.distinct.clear();
+    for (size_t v = 0; v != n; ++v)
+    {
+        auto const* vertex = s.rows.data() + v * row;
+        for (auto slot = hash_bytes(vertex, row) & (capacity - 1);; slot = (slot + 1) & (capacity - 1))
+        {
+            auto const w = s.table[slot];
+            if (w == unassigned)
+            {
+                s.table[slot] = g.remap[v] = static_cast<uint32_t>(g.distinct.size());
+                g.distinct.push_back(static_cast<uint32_t>(v));
+                break;
+            }
+            if (same_bytes(vertex, s.rows.data() + size_t{g.distinct[w]} * row, row))
+            {
+                g.remap[v] = w;
+                break;
+            }
+        }
+    }
+    return g.distinct.size() < n;
+}
+
+bool write_welded(doc const& d, vertex_group const& g, std::byte* storage, worker_scratch& s)
+{
+    for (size_t i = 0; i != g.primitives.size(); ++i)
+    {
+        auto const& acc = d.accessors[d.meshes[g.primitives[i].first].primitives[g.primitives[i].second].indices];
+        s.indices.resize(acc.count);
+        if (widen_indices(d, acc, s.indices) != acc.count) return false;
+        for (auto& v : s.indices) v = g.remap[v];
+        write_indices(s.indices, g.index_types[i], storage + g.index_offsets[i]);
+    }
+    for (size_t k = 0; k != g.accessors.size(); ++k)
+    {
+        auto const& acc    = d.accessors[g.accessors[k]];
+        auto const  size   = element_size(acc.comp_type, acc.type);
+        auto const  stride = vertex_stride(acc);
+        s.elements.resize(g.vertex_count * size);
+        if (materialize_accessor(d, acc, s.elements) != g.vertex_count * size) return false;
+        auto* out = storage + g.vertex_offsets[k];
+        for (size_t v = 0; v != g.distinct.size(); ++v)
+            std::memcpy(out + v * stride, s.elements.data() + size_t{g.distinct[v]} * size, size);
+    }
+    return true;
+}
+
+uint32_t view_target(doc const& d, accessor const& acc) noexcept
+{
+    return acc.view < d.buffer_views.size() ? d.buffer_views[acc.view].target : 0;
+}
+
+bool same_layout(doc const& d, accessor const& a, accessor const& b) noexcept
+{
+    return a.count == b.count && a.comp_type == b.comp_type && a.type == b.type && a.normalized == b.normalized &&
+           std::equal(a.max.begin(), a.max.end(), b.max.begin(), b.max.end()) &&
+           std::equal(a.min.begin(), a.min.end(), b.min.begin(), b.min.end()) && view_target(d, a) == view_target(d, b);
+}
+
+// whether a and b read the same bytes of a buffer, moving references from one to the other then saves no memory
+bool same_storage(doc const& d, accessor const& a, accessor const& b) noexcept
+{
+    if (a.sparse.count || b.sparse.count || a.view >= d.buffer_views.size() || b.view >= d.buffer_views.size()) return false;
+    if (a.view == b.view) return a.offset == b.offset;
+    auto const& l = d.buffer_views[a.view];
+    auto const& r = d.buffer_views[b.view];
+    // compressed views are decoded each on their own
+    return l.meshopt.count == 0 && r.meshopt.count == 0 && l.buffer == r.buffer && l.stride == r.stride &&
+           uint64_t{l.offset} + a.offset == uint64_t{r.offset} + b.offset;
+}
+
+bool same_attributes(std::pmr::vector<attribute_offset> const& a, std::pmr::vector<attribute_offset> const& b) noexcept
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](attribute_offset const& l, attribute_offset const& r)
+                      { return tiny_tuple::get<0>(l) == tiny_tuple::get<0>(r) && tiny_tuple::get<1>(l) == tiny_tuple::get<1>(r); });
+}
+
+bool same_mesh(mesh const& a, mesh const& b) noexcept
+{
+    auto const same_primitive = [](primitive const& l, primitive const& r)
+    {
+        return l.indices == r.indices && l.material == r.material && l.mode == r.mode && l.flags == r.flags &&
+               same_attributes(l.attributes, r.attributes) &&
+               std::equal(l.targets.begin(), l.targets.end(), r.targets.begin(), r.targets.end(), same_attributes);
+    };
+    return std::equal(a.primitives.begin(), a.primitives.end(), b.primitives.begin(), b.primitives.end(), same_primitive) &&
+           std::equal(a.weights.begin(), a.weights.end(), b.weights.begin(), b.weights.end());
+}
+
+uint64_t mesh_hash(mesh const& m) noexcept
+{
+    uint64_t   h   = mix(0, m.primitives.size());
+    auto const add = [&h](std::pmr::vector<attribute_offset> const& attributes)
+    {
+        for (auto const& a : attributes) h = mix(h, static_cast<uint64_t>(tiny_tuple::get<0>(a)) << 32 | tiny_tuple::get<1>(a));
+    };
+    for (auto const& p : m.primitives)
+    {
+        h = mix(h, static_cast<uint32_t>(p.indices));
+        h = mix(h, static_cast<uint64_t>(p.mode) << 32 | static_cast<uint32_t>(p.material));
+        add(p.attributes);
+        for (auto const& t : p.targets) add(t);
+    }
+    return h;
+}
+}  // namespace
+
+bool optimize_vertex_cache(std::span<uint32_t const> indices, size_t vertex_count, std::span<uint32_t> out, size_t cache_size)
+{
+    if (out.size() < indices.size() / 3 * 3) return false;
+    tipsify_scratch s;
+    return tipsify(indices, vertex_count, cache_size, out.data(), s);
+}
+
+bool optimize_overdraw(std::span<uint32_t const> indices, std::span<float const> positions, std::span<uint32_t> out, size_t cache_size,
+                       float threshold)
+{
+    auto const vertex_count = positions.size() / 3;
+    auto const count        = indices.size() / 3 * 3;
+    if (out.size() < count || std::any_of(indices.begin(), indices.begin() + count, [=](uint32_t v) { return v >= vertex_count; }))
+        return false;
+    overdraw_scratch s;
+    cluster_by_depth(indices.first(count), positions.data(), vertex_count, cache_size, threshold, out.data(), s);
+    return true;
+}
+
+double average_cache_miss_ratio(std::span<uint32_t const> indices, size_t cache_size)
+{
+    if (indices.size() < 3) return 0.0;
+    // a vertex is cached while fewer than cache_size misses happened since it was loaded
+    std::vector<uint64_t> loaded(*std::max_element(indices.begin(), indices.end()) + size_t{1}, 0);
+    uint64_t              misses = 0;
+    for (auto v : indices)
+    {
+        if (loaded[v] != 0 && misses + 1 - loaded[v] <= cache_size) continue;
+        loaded[v] = ++misses;
+    }
+    return static_cast<double>(misses) / static_cast<double>(indices.size() / 3);
+}
+
+size_t optimize_primitives(doc& d, std::vector<std::byte>& storage, thread_pool* pool, size_t cache_size, float overdraw_threshold)
+{
+    auto groups = collect_groups(d, true);
+    if (groups.empty()) return 0;
+
+    size_t total = 0;
+    for (auto& g : groups)
+    {
+        for (auto [m, i] : g.primitives)
+        {
+            auto const& acc = d.accessors[d.meshes[m].primitives[i].indices];
+            g.index_types.push_back(index_type(acc.comp_type, g.vertex_count));
+            g.index_offsets.push_back(total);
+            total = align(total + acc.count * component_size(g.index_types.back()));
+        }
+        for (auto a : g.accessors)
+        {
+            g.vertex_offsets.push_back(total);
+            total = align(total + g.vertex_count * vertex_stride(d.accessors[a]));
+        }
+    }
+    storage.assign(total, std::byte{0});
+
+    std::vector<worker_scratch> scratch(pool ? pool->size() : 1);
+    auto const                  optimize = [&](size_t i, size_t worker)
+    { groups[i].done = optimize_group(d, groups[i], cache_size, overdraw_threshold, storage.data(), scratch[worker]); };
+    if (pool && pool->size() > 1 && groups.size() > 1)
+        pool->for_each(groups.size(), optimize);
+    else
+        for (size_t i = 0; i != groups.size(); ++i) optimize(i, 0);
+
+    auto const buffer = static_cast<uint32_t>(d.buffers.size());
+    d.buffers.emplace_back(infile_buffer{storage.size(), std::span<std::byte const>(storage)});
+    size_t rewritten = 0;
+    for (auto const& g : groups)
+    {
+        if (!g.done) continue;
+        rebind_group(d, g, buffer, g.vertex_count);
+        rewritten += g.primitives.size();
+    }
+    return rewritten;
+}
+
+dedup_report weld_vertices(doc& d, std::vector<std::byte>& storage, thread_pool* pool)
+{
+    dedup_report report;
+    auto         groups = collect_groups(d, false);
+    if (groups.empty()) return report;
+
+    std::vector<worker_scratch> scratch(pool ? pool->size() : 1);
+    auto const                  parallel = pool && pool->size() > 1 && groups.size() > 1;
+    auto const                  run      = [&](auto const& f)
+    {
+        if (parallel)
+            pool->for_each(groups.size(), f);
+        else
+            for (size_t i = 0; i != groups.size(); ++i) f(i, 0);
+    };
+    run([&](size_t i, size_t worker) { groups[i].done = weld_group(d, groups[i], scratch[worker]); });
+
+    size_t total = 0;
+    for (auto& g : groups)
+    {
+        if (!g.done) continue;
+        for (auto [m, i] : g.primitives)
+        {
+            auto const& acc = d.accessors[d.meshes[m].primitives[i].indices];
+            g.index_types.push_back(index_type(acc.comp_type, g.distinct.size()));
+            g.index_offsets.push_back(total);
+            total = align(total + acc.count * component_size(g.index_types.back()));
+        }
+        for (auto a : g.accessors)
+        {
+            g.vertex_offsets.push_back(total);
+            total = align(total + g.distinct.size() * vertex_stride(d.accessors[a]));
+        }
+    }
+    storage.assign(total, std::byte{0});
+    run(
+        [&](size_t i, size_t worker)
+        {
+            if (groups[i].done) groups[i].done = write_welded(d, groups[i], storage.data(), scratch[worker]);
+        });
+
+    auto const buffer = static_cast<uint32_t>(d.buffers.size());
+    if (total) d.buffers.emplace_back(infile_buffer{storage.size(), std::span<std::byte const>(storage)});
+    for (auto const& g : groups)
+    {
+        auto const welded = g.done ? g.distinct.size() : g.vertex_count;
+        report.vertices_before += g.vertex_count;
+        report.vertices_after  += welded;
+        if (!g.done) continue;
+        size_t vertex_size = 0;
+        for (auto a : g.accessors) vertex_size += element_size(d.accessors[a].comp_type, d.accessors[a].type);
+        report.bytes_saved += (g.vertex_count - welded) * vertex_size;
+        rebind_group(d, g, buffer, welded);
+    }
+    return report;
+}
+
+dedup_report share_identical(doc& d, thread_pool* pool)
+{
+    dedup_report report;
+    auto const   count = d.accessors.size();
+    // accessors without resolvable elements are not shared
+    std::vector<uint64_t>               hashes(count, 0);
+    std::vector<uint8_t>                resolved(count, 0);
+    std::vector<std::vector<std::byte>> scratch(pool ? pool->size() : 1);
+    auto const                          hash = [&](size_t i, size_t worker)
+    {
+        auto const& acc  = d.accessors[i];
+        auto const  size = acc.count * element_size(acc.comp_type, acc.type);
+        auto&       out  = scratch[worker];
+        out.resize(size);
+        if (size == 0 || materialize_accessor(d, acc, out) != size) return;
+        hashes[i]   = hash_bytes(out.data(), size);
+        resolved[i] = 1;
+    };
+    if (pool && pool->size() > 1 && count > 1)
+        pool->for_each(count, hash);
+    else
+        for (size_t i = 0; i != count; ++i) hash(i, 0);
+
+    std::vector<uint32_t> replacement(count);
+    std::iota(replacement.begin(), replacement.end(), 0u);
+    std::unordered_map<uint64_t, std::vector<uint32_t>> representatives;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> merged;  // duplicates over distinct storage, per representative
+    std::vector<std::byte>                              elements, candidate;
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (!resolved[i]) continue;
+        auto const& acc        = d.accessors[i];
+        auto&       candidates = representatives[hashes[i]];
+        if (!candidates.empty())
+        {
+            auto const size = acc.count * element_size(acc.comp_type, acc.type);
+            elements.resize(size);
+            candidate.resize(size);
+            materialize_accessor(d, acc, elements);
+            for (auto c : candidates)
+            {
+                if (!same_layout(d, d.accessors[c], acc) || materialize_accessor(d, d.accessors[c], candidate) != size ||
+                    !same_bytes(candidate.data(), elements.data(), size))
+                    continue;
+                replacement[i] = c;
+                ++report.accessors_shared;
+                // only storage that no other reference remains on is saved
+                auto&      storages = merged[c];
+                auto const stored   = [&](uint32_t k) { return same_storage(d, d.accessors[k], acc); };
+                if (!stored(c) && std::none_of(storages.begin(), storages.end(), stored))
+                {
+                    report.bytes_saved += size;
+                    storages.push_back(static_cast<uint32_t>(i));
+                }
+                break;
+            }
+        }
+        if (replacement[i] == i) candidates.push_back(static_cast<uint32_t>(i));
+    }
+
+    auto const rewire = [&](int32_t& index)
+    {
+        if (index >= 0 && static_cast<size_t>(index) < count) index = static_cast<int32_t>(replacement[index]);
+    };
+    auto const rewire_attributes = [&](std::pmr::vector<attribute_offset>& attributes)
+    {
+        for (auto& a : attributes)
+            if (tiny_tuple::get<1>(a) < count) a = attribute_offset(tiny_tuple::get<0>(a), replacement[tiny_tuple::get<1>(a)]);
+    };
+    for (auto& m : d.meshes)
+        for (auto& p : m.primitives)
+        {
+            rewire(p.indices);
+            rewire_attributes(p.attributes);
+            for (auto& t : p.targets) rewire_attributes(t);
+        }
+    for (auto& s : d.skins) rewire(s.inverse_bind_matrices);
+    for (auto& a : d.animations)
+        for (auto& s : a.samplers)
+        {
+            rewire(s.input);
+            rewire(s.output);
+        }
+
+    // meshes over the same accessors
+    std::vector<int32_t> mesh_replacement(d.meshes.size());
+    std::iota(mesh_replacement.begin(), mesh_replacement.end(), 0);
+    std::unordered_map<uint64_t, std::vector<uint32_t>> mesh_representatives;
+    for (size_t i = 0; i != d.meshes.size(); ++i)
+    {
+        auto& candidates = mesh_representatives[mesh_hash(d.meshes[i])];
+        auto const same =
+            std::find_if(candidates.begin(), candidates.end(), [&](uint32_t c) { return same_mesh(d.meshes[c], d.meshes[i]); });
+        if (same == candidates.end())
+            candidates.push_back(static_cast<uint32_t>(i));
+        else
+        {
+            mesh_replacement[i] = static_cast<int32_t>(*same);
+            ++report.meshes_shared;
+        }
+    }
+    for (auto& n : d.nodes)
+        if (n.mesh >= 0 && static_cast<size_t>(n.mesh) < d.meshes.size()) n.mesh = mesh_replacement[n.mesh];
+    return report;
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,642 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include "simd.h"
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/meshopt_decode.h>
+#include <trivial_gltf/thread_pool.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace trivial_gltf
+{
+namespace
+{
+constexpr uint8_t vertex_header   = 0xa0;
+constexpr uint8_t index_header    = 0xe0;
+constexpr uint8_t sequence_header = 0xd0;
+
+// The vertex codec splits the vertices into blocks that fit into 8 KiB. Within a block every byte of the vertex
+// is a stream of zigzag deltas to the previous vertex, packed in groups of 16 with 0, 2, 4 or 8 bits each. The
+// stream ends with a tail holding the first vertex, so a group never reads past the end.
+constexpr size_t group_size         = 16;
+constexpr size_t group_decode_limit = 24;  // the most bytes a group reads
+constexpr size_t block_bytes        = 8192;
+constexpr size_t block_max_vertices = 256;
+constexpr size_t tail_min           = 32;
+
+size_t vertex_block_size(size_t stride) noexcept { return std::min((block_bytes / stride) & ~(group_size - 1), block_max_vertices); }
+
+uint8_t unzigzag(uint8_t v) noexcept { return static_cast<uint8_t>((v >> 1) ^ -(v & 1)); }
+
+template <typename T>
+T load(uint8_t const* p) noexcept
+{
+    T v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+template <typename T>
+void store(uint8_t* p, T v) noexcept
+{
+    std::memcpy(p, &v, sizeof v);
+}
+
+// 2 and 4 bit values are packed high bits first, the largest value escapes to a full byte behind the packed ones
+uint8_t const* decode_group(uint8_t const* data, uint8_t* out, int bits_log2) noexcept
+{
+    switch (bits_log2)
+    {
+        case 0: std::fill(out, out + group_size, uint8_t{0}); return data;
+        case 3: std::memcpy(out, data, group_size); return data + group_size;
+        default:
+        {
+            int const   bits   = bits_log2 == 1 ? 2 : 4;
+            int const   escape = (1 << bits) - 1;
+            auto const* extra  = data + 2 * bits;
+            for (size_t i = 0; i != group_size; ++i)
+            {
+                int const v = (data[i * bits / 8] >> (8 - bits - static_cast<int>(i * bits % 8))) & escape;
+                out[i]      = v == escape ? *extra++ : static_cast<uint8_t>(v);
+            }
+            return extra;
+        }
+    }
+}
+
+#if TRIVIAL_GLTF_X86_SIMD
+// shuffle that gathers the escaped bytes of 8 values from the bytes behind the packed ones, 0x80 yields zero
+struct escape_shuffles
+{
+    uint8_t mask[256][8];
+    uint8_t count[256];
+};
+
+constexpr escape_shuffles make_escape_shuffles() noexcept
+{
+    escape_shuffles r{};
+    for (int m = 0; m != 256; ++m)
+    {
+        uint8_t next = 0;
+        for (int i = 0; i != 8; ++i) r.mask[m][i] = (m >> i) & 1 ? next++ : 0x80;
+        r.count[m] = next;
+    }
+    return r;
+}
+
+constexpr escape_shuffles shuffles = make_escape_shuffles();
+
+__attribute__((target("ssse3"))) uint8_t const* decode_group_ssse3(uint8_t const* data, uint8_t* out, int bits_log2) noexcept
+{
+    auto* const dst = reinterpret_cast<__m128i*>(out);
+    switch (bits_log2)
+    {
+        case 0: _mm_storeu_si128(dst, _mm_setzero_si128()); return data;
+        case 3: _mm_storeu_si128(dst, _mm_loadu_si128(reinterpret_cast<__m128i const*>(data))); return data + group_size;
+        default:
+        {
+            // spread the packed values to one per byte, shifting 16 bit lanes keeps them in order
+            size_t  packed;
+            __m128i values;
+            if (bits_log2 == 1)
+            {
+                auto const sel2  = _mm_cvtsi32_si128(load<int32_t>(data));
+                auto const sel22 = _mm_unpacklo_epi8(_mm_srli_epi16(sel2, 4), sel2);
+                values           = _mm_and_si128(_mm_unpacklo_epi8(_mm_srli_epi16(sel22, 2), sel22), _mm_set1_epi8(3));
+                packed           = 4;
+            }
+            else
+            {
+                auto const sel4 = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(data));
+                values          = _mm_and_si128(_mm_unpacklo_epi8(_mm_srli_epi16(sel4, 4), sel4), _mm_set1_epi8(15));
+                packed          = 8;
+            }
+            auto const escaped = _mm_cmpeq_epi8(values, _mm_set1_epi8(bits_log2 == 1 ? 3 : 15));
+            auto const mask    = _mm_movemask_epi8(escaped);
+            auto const low     = mask & 0xff;
+            auto const high    = mask >> 8;
+            // the escaped bytes of the upper half follow those of the lower half
+            auto const lower   = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(shuffles.mask[low]));
+            auto const upper   = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(shuffles.mask[high]));
+            auto const shuffle = _mm_unpacklo_epi64(lower, _mm_add_epi8(upper, _mm_set1_epi8(char(shuffles.count[low]))));
+            auto const rest    = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + packed));
+            _mm_storeu_si128(dst, _mm_or_si128(_mm_shuffle_epi8(rest, shuffle), _mm_andnot_si128(escaped, values)));
+            return data + packed + shuffles.count[low] + shuffles.count[high];
+        }
+    }
+}
+
+// zigzag decode and prefix sum of 16 deltas, continuing from the last value of previous
+__attribute__((target("ssse3"))) inline __m128i accumulate_ssse3(uint8_t const* deltas, __m128i& previous) noexcept
+{
+    auto const d    = _mm_loadu_si128(reinterpret_cast<__m128i const*>(deltas));
+    auto const sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(d, _mm_set1_epi8(1)));
+    auto       v    = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(d, 1), _mm_set1_epi8(0x7f)), sign);
+    v               = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+    v               = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+    v               = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+    v               = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+    v               = _mm_add_epi8(v, previous);
+    previous        = _mm_shuffle_epi8(v, _mm_set1_epi8(15));
+    return v;
+}
+
+// deltas holds the streams of all bytes of the block one after another, four bytes of 16 vertices are
+// accumulated and transposed at a time, so that every vertex gets a single 32 bit store per four bytes
+__attribute__((target("ssse3"))) void accumulate_block_ssse3(uint8_t const* deltas, size_t aligned, size_t n, uint8_t const* last,
+                                                             uint8_t* out, size_t stride) noexcept
+{
+    alignas(16) uint32_t lanes[group_size];
+    for (size_t k = 0; k != stride; k += 4)
+    {
+        __m128i previous[4];
+        for (size_t j = 0; j != 4; ++j) previous[j] = _mm_set1_epi8(char(last[k + j]));
+        for (size_t i = 0; i < n; i += group_size)
+        {
+            auto const c0 = accumulate_ssse3(deltas + k * aligned + i, previous[0]);
+            auto const c1 = accumulate_ssse3(deltas + (k + 1) * aligned + i, previous[1]);
+            auto const c2 = accumulate_ssse3(deltas + (k + 2) * aligned + i, previous[2]);
+            auto const c3 = accumulate_ssse3(deltas + (k + 3) * aligned + i, previous[3]);
+            auto const t0 = _mm_unpacklo_epi8(c0, c1);
+            auto const t1 = _mm_unpackhi_epi8(c0, c1);
+            auto const t2 = _mm_unpacklo_epi8(c2, c3);
+            auto const t3 = _mm_unpackhi_epi8(c2, c3);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_unpacklo_epi16(t0, t2));
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 4), _mm_unpackhi_epi16(t0, t2));
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 8), _mm_unpacklo_epi16(t1, t3));
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 12), _mm_unpackhi_epi16(t1, t3));
+            auto const count = std::min(group_size, n - i);
+            for (size_t v = 0; v != count; ++v) store(out + (i + v) * stride + k, lanes[v]);
+        }
+    }
+}
+#endif
+
+void accumulate_deltas(uint8_t const* deltas, size_t n, uint8_t last, uint8_t* out, size_t stride) noexcept
+{
+    for (size_t i = 0; i != n; ++i) out[i * stride] = last = static_cast<uint8_t>(last + unzigzag(deltas[i]));
+}
+
+// one byte stream of size values, preceded by 2 bits per group selecting its width
+uint8_t const* decode_bytes(uint8_t const* data, uint8_t const* end, uint8_t* out, size_t size, bool simd) noexcept
+{
+    size_t const header_size = (size / group_size + 3) / 4;
+    if (static_cast<size_t>(end - data) < header_size) return nullptr;
+    auto const* header = data;
+    data += header_size;
+    for (size_t i = 0; i != size; i += group_size)
+    {
+        if (static_cast<size_t>(end - data) < group_decode_limit) return nullptr;
+        size_t const group     = i / group_size;
+        int const    bits_log2 = (header[group / 4] >> (group % 4 * 2)) & 3;
+#if TRIVIAL_GLTF_X86_SIMD
+        data = simd ? decode_group_ssse3(data, out + i, bits_log2) : decode_group(data, out + i, bits_log2);
+#else
+        data = decode_group(data, out + i, bits_log2);
+#endif
+    }
+    return data;
+}
+
+uint8_t const* decode_vertex_block(uint8_t const* data, uint8_t const* end, uint8_t* out, size_t n, size_t stride, uint8_t* last,
+                                   bool simd) noexcept
+{
+    alignas(16) uint8_t deltas[block_bytes];
+    size_t const        aligned = (n + group_size - 1) & ~(group_size - 1);
+    for (size_t k = 0; k != stride; ++k)
+    {
+        data = decode_bytes(data, end, deltas + k * aligned, aligned, simd);
+        if (!data) return nullptr;
+    }
+#if TRIVIAL_GLTF_X86_SIMD
+    if (simd)
+        accumulate_block_ssse3(deltas, aligned, n, last, out, stride);
+    else
+#endif
+        for (size_t k = 0; k != stride; ++k) accumulate_deltas(deltas + k * aligned, n, last[k], out + k, stride);
+    std::memcpy(last, out + (n - 1) * stride, stride);
+    return data;
+}
+
+uint32_t decode_vbyte(uint8_t const*& data) noexcept
+{
+    uint8_t const lead = *data++;
+    if (lead < 128) return lead;
+    uint32_t result = lead & 127;
+    for (uint32_t shift = 7; shift <= 28; shift += 7)
+    {
+        uint8_t const group = *data++;
+        result |= uint32_t{group & 127u} << shift;
+        if (group < 128) break;
+    }
+    return result;
+}
+
+uint32_t decode_delta(uint8_t const*& data, uint32_t last) noexcept
+{
+    auto const v = decode_vbyte(data);
+    return last + ((v >> 1) ^ (0u - (v & 1)));
+}
+
+void write_index(uint8_t* out, size_t i, size_t stride, uint32_t index) noexcept
+{
+    if (stride == 2)
+        store(out + 2 * i, static_cast<uint16_t>(index));
+    else
+        store(out + 4 * i, index);
+}
+
+// recently used edges and vertices the triangle codec refers back to, both wrap around after 16 entries
+struct index_fifos
+{
+    uint32_t edges[16][2];
+    uint32_t vertices[16];
+    size_t   edge_offset{0};
+    size_t   vertex_offset{0};
+
+    index_fifos()
+    {
+        std::fill(&edges[0][0], &edges[0][0] + 32, ~0u);
+        std::fill(vertices, vertices + 16, ~0u);
+    }
+    uint32_t const* edge(size_t back) const noexcept { return edges[(edge_offset - 1 - back) & 15]; }
+    uint32_t        vertex(size_t back) const noexcept { return vertices[(vertex_offset - back) & 15]; }
+    void            push_edge(uint32_t a, uint32_t b) noexcept
+    {
+        edges[edge_offset][0] = a;
+        edges[edge_offset][1] = b;
+        edge_offset           = (edge_offset + 1) & 15;
+    }
+    void push_vertex(uint32_t v, bool advance = true) noexcept
+    {
+        vertices[vertex_offset] = v;
+        vertex_offset           = (vertex_offset + advance) & 15;
+    }
+};
+
+template <typename T>
+T round_signed(float v) noexcept
+{
+    return static_cast<T>(static_cast<int>(v + (v >= 0.0f ? 0.5f : -0.5f)));
+}
+
+#if TRIVIAL_GLTF_X86_SIMD
+// the filters need SSE2 only, which x86 builds assume, they fall back to scalar with the level lowered
+bool simd_filters() noexcept { return active_simd_level() != simd_level::scalar; }
+
+// rounds half away from zero like round_signed
+inline __m128i round_signed(__m128 v) noexcept
+{
+    return _mm_cvttps_epi32(_mm_add_ps(v, _mm_or_ps(_mm_and_ps(v, _mm_set1_ps(-0.0f)), _mm_set1_ps(0.5f))));
+}
+#endif
+
+// unit vectors as octahedral x and y, z holds the length the result is scaled to, w passes through
+template <typename T>
+void octahedral_filter(uint8_t* data, size_t count) noexcept
+{
+    constexpr float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+    constexpr auto  c   = [](uint8_t const* v, int i) { return static_cast<float>(load<T>(v + i * sizeof(T))); };
+    size_t          i   = 0;
+#if TRIVIAL_GLTF_X86_SIMD
+    constexpr int bits = 8 * sizeof(T);
+    auto const    sign = _mm_set1_ps(-0.0f);
+    auto const    low  = _mm_set1_epi32((1 << bits) - 1);
+    // sign extends the component at offset of every 32 bit lane
+    auto const extract = [](__m128i v, int offset)
+    { return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(v, 32 - bits - offset), 32 - bits)); };
+    for (bool const simd = simd_filters(); simd && i + 4 <= count; i += 4)
+    {
+        // four vertices with x and y, z and w in one 32 bit lane each, the same lane for 8 bit components
+        auto* const p = reinterpret_cast<__m128i*>(data + 4 * sizeof(T) * i);
+        __m128i     xy, zw;
+        if constexpr (sizeof(T) == 1)
+            xy = zw = _mm_loadu_si128(p);
+        else
+        {
+            auto const a = _mm_castsi128_ps(_mm_loadu_si128(p));
+            auto const b = _mm_castsi128_ps(_mm_loadu_si128(p + 1));
+            xy           = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            zw           = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+        auto       x = extract(xy, 0);
+        auto       y = extract(xy, bits);
+        auto const z = _mm_sub_ps(_mm_sub_ps(extract(zw, sizeof(T) == 1 ? 16 : 0), _mm_andnot_ps(sign, x)), _mm_andnot_ps(sign, y));
+        // fold the lower hemisphere back
+        auto const t = _mm_min_ps(z, _mm_setzero_ps());
+        x            = _mm_add_ps(x, _mm_xor_ps(t, _mm_and_ps(x, sign)));
+        y            = _mm_add_ps(y, _mm_xor_ps(t, _mm_and_ps(y, sign)));
+        auto const l = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        auto const s = _mm_div_ps(_mm_set1_ps(max), l);
+
+        auto const xi     = _mm_and_si128(round_signed(_mm_mul_ps(x, s)), low);
+        auto const yi     = _mm_and_si128(round_signed(_mm_mul_ps(y, s)), low);
+        auto const zi     = _mm_and_si128(round_signed(_mm_mul_ps(z, s)), low);
+        auto const xy_out = _mm_or_si128(xi, _mm_slli_epi32(yi, bits));
+        if constexpr (sizeof(T) == 1)
+            _mm_storeu_si128(p, _mm_or_si128(_mm_or_si128(xy_out, _mm_slli_epi32(zi, 16)), _mm_andnot_si128(_mm_set1_epi32(0xffffff), zw)));
+        else
+        {
+            auto const zw_out = _mm_or_si128(zi, _mm_andnot_si128(low, zw));
+            _mm_storeu_si128(p, _mm_unpacklo_epi32(xy_out, zw_out));
+            _mm_storeu_si128(p + 1, _mm_unpackhi_epi32(xy_out, zw_out));
+        }
+    }
+#endif
+    for (; i != count; ++i)
+    {
+        auto* const v = data + 4 * sizeof(T) * i;
+        float       x = c(v, 0), y = c(v, 1);
+        float const z = c(v, 2) - std::fabs(x) - std::fabs(y);
+        float const t = std::min(z, 0.0f);
+        x += x >= 0.0f ? t : -t;
+        y += y >= 0.0f ? t : -t;
+        float const s = max / std::sqrt(x * x + y * y + z * z);
+        store(v, round_signed<T>(x * s));
+        store(v + sizeof(T), round_signed<T>(y * s));
+        store(v + 2 * sizeof(T), round_signed<T>(z * s));
+    }
+}
+
+// three components of a unit quaternion, the two low bits of the fourth select the omitted largest one
+void quaternion_filter(uint8_t* data, size_t count) noexcept
+{
+    constexpr float scale = 0.70710678f;
+    constexpr auto  c     = [](uint8_t const* v, int i) { return load<int16_t>(v + 2 * i); };
+    auto const      write = [c](uint8_t* v, int16_t x, int16_t y, int16_t z, int16_t w)
+    {
+        auto const qc = c(v, 3) & 3;
+        store(v + 2 * ((qc + 1) & 3), x);
+        store(v + 2 * ((qc + 2) & 3), y);
+        store(v + 2 * ((qc + 3) & 3), z);
+        store(v + 2 * qc, w);
+    };
+    size_t i = 0;
+#if TRIVIAL_GLTF_X86_SIMD
+    for (bool const simd = simd_filters(); simd && i + 4 <= count; i += 4)
+    {
+        auto* const v  = data + 8 * i;
+        auto const  ss = _mm_div_ps(_mm_set1_ps(scale), _mm_setr_ps(float(c(v, 3) | 3), float(c(v, 7) | 3), float(c(v, 11) | 3),
+                                                                   float(c(v, 15) | 3)));
+        auto const  x  = _mm_mul_ps(_mm_setr_ps(c(v, 0), c(v, 4), c(v, 8), c(v, 12)), ss);
+        auto const  y  = _mm_mul_ps(_mm_setr_ps(c(v, 1), c(v, 5), c(v, 9), c(v, 13)), ss);
+        auto const  z  = _mm_mul_ps(_mm_setr_ps(c(v, 2), c(v, 6), c(v, 10), c(v, 14)), ss);
+        auto const  ww = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        auto const  w  = _mm_sqrt_ps(_mm_max_ps(ww, _mm_setzero_ps()));
+        auto const  q  = _mm_set1_ps(32767.0f);
+        alignas(16) int32_t r[4][4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(r[0]), round_signed(_mm_mul_ps(x, q)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(r[1]), round_signed(_mm_mul_ps(y, q)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(r[2]), round_signed(_mm_mul_ps(z, q)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(r[3]), round_signed(_mm_mul_ps(w, q)));
+        for (int k = 0; k != 4; ++k)
+            write(v + 8 * k, int16_t(r[0][k]), int16_t(r[1][k]), int16_t(r[2][k]), int16_t(r[3][k]));
+    }
+#endif
+    for (; i != count; ++i)
+    {
+        auto* const v  = data + 8 * i;
+        float const ss = scale / float(c(v, 3) | 3);
+        float const x = c(v, 0) * ss, y = c(v, 1) * ss, z = c(v, 2) * ss;
+        float const w = std::sqrt(std::max(1.0f - x * x - y * y - z * z, 0.0f));
+        write(v, round_signed<int16_t>(x * 32767.0f), round_signed<int16_t>(y * 32767.0f), round_signed<int16_t>(z * 32767.0f),
+              round_signed<int16_t>(w * 32767.0f));
+    }
+}
+
+// every 32 bit value is a 24 bit signed mantissa with an 8 bit signed exponent
+void exponential_filter(uint8_t* data, size_t count) noexcept
+{
+    size_t i = 0;
+#if TRIVIAL_GLTF_X86_SIMD
+    for (bool const simd = simd_filters(); simd && i + 4 <= count; i += 4)
+    {
+        auto* const p        = reinterpret_cast<__m128i*>(data + 4 * i);
+        auto const  v        = _mm_loadu_si128(p);
+        auto const  mantissa = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+        auto const  exponent = _mm_srai_epi32(v, 24);
+        auto const  power    = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(127)), 23));
+        _mm_storeu_si128(p, _mm_castps_si128(_mm_mul_ps(power, _mm_cvtepi32_ps(mantissa))));
+    }
+#endif
+    for (; i != count; ++i)
+    {
+        auto const v        = load<uint32_t>(data + 4 * i);
+        auto const mantissa = static_cast<int32_t>(v << 8) >> 8;
+        auto const exponent = static_cast<int32_t>(v) >> 24;
+        float      power;
+        auto const bits = static_cast<uint32_t>(exponent + 127) << 23;
+        std::memcpy(&power, &bits, sizeof power);
+        store(data + 4 * i, power * static_cast<float>(mantissa));
+    }
+}
+}  // namespace
+
+bool decode_meshopt_vertices(std::span<std::byte const> src, size_t count, size_t stride, std::span<std::byte> dst) noexcept
+{
+    if (stride == 0 || stride > 256 || stride % 4 != 0 || dst.size() < count * stride || src.size() < 1 + stride) return false;
+    auto const* data = reinterpret_cast<uint8_t const*>(src.data());
+    auto const* end  = data + src.size();
+    if ((*data & 0xf0) != vertex_header || (*data & 0x0f) != 0) return false;
+    ++data;
+
+    uint8_t last[256];
+    std::memcpy(last, end - stride, stride);
+    bool const   simd  = has_ssse3();
+    auto* const  out   = reinterpret_cast<uint8_t*>(dst.data());
+    size_t const block = vertex_block_size(stride);
+    for (size_t v = 0; v < count; v += block)
+    {
+        data = decode_vertex_block(data, end, out + v * stride, std::min(block, count - v), stride, last, simd);
+        if (!data) return false;
+    }
+    return static_cast<size_t>(end - data) == std::max(tail_min, stride);
+}
+
+bool decode_meshopt_triangles(std::span<std::byte const> src, size_t count, size_t stride, std::span<std::byte> dst) noexcept
+{
+    // header, one code byte per triangle and the table of the most common auxiliary codes at the end
+    if ((stride != 2 && stride != 4) || count % 3 != 0 || dst.size() < count * stride || src.size() < 1 + count / 3 + 16) return false;
+    auto const* buffer = reinterpret_cast<uint8_t const*>(src.data());
+    if ((buffer[0] & 0xf0) != index_header || (buffer[0] & 0x0f) > 1) return false;
+    int const fec_max = (buffer[0] & 0x0f) >= 1 ? 13 : 15;
+
+    auto const* code      = buffer + 1;
+    auto const* data      = code + count / 3;
+    auto const* data_end  = buffer + src.size() - 16;
+    auto const* aux_table = data_end;
+    auto* const out       = reinterpret_cast<uint8_t*>(dst.data());
+    index_fifos fifo;
+    uint32_t    next = 0, last = 0;
+    auto const  emit = [&](size_t i, uint32_t a, uint32_t b, uint32_t c)
+    {
+        write_index(out, i, stride, a);
+        write_index(out, i + 1, stride, b);
+        write_index(out, i + 2, stride, c);
+    };
+
+    for (size_t i = 0; i != count; i += 3)
+    {
+        // a triangle reads at most 16 bytes, the table behind the data keeps that in bounds
+        if (data > data_end) return false;
+        uint8_t const code_tri = *code++;
+        if (code_tri < 0xf0)
+        {
+            // an edge from the fifo and a new, recent or explicit third vertex
+            auto const* edge = fifo.edge(code_tri >> 4);
+            auto const  a = edge[0], b = edge[1];
+            int const   fec = code_tri & 15;
+            uint32_t    c;
+            if (fec < fec_max)
+            {
+                c = fec == 0 ? next++ : fifo.vertex(fec + 1);
+                fifo.push_vertex(c, fec == 0);
+            }
+            else
+            {
+                // 13 and 14 step the last explicit index by -1 and +1
+                last = c = fec != 15 ? last + (fec - (fec ^ 3)) : decode_delta(data, last);
+                fifo.push_vertex(c);
+            }
+            emit(i, a, b, c);
+            fifo.push_edge(c, b);
+            fifo.push_edge(a, c);
+            continue;
+        }
+
+        uint8_t const code_aux = code_tri < 0xfe ? aux_table[code_tri & 15] : *data++;
+        int const     fea      = code_tri == 0xff ? 15 : 0;
+        int const     feb      = code_aux >> 4;
+        int const     fec      = code_aux & 15;
+        // an explicit zero auxiliary code restarts the numbering of new vertices
+        if (code_tri >= 0xfe && code_aux == 0) next = 0;
+        uint32_t a = fea == 0 ? next++ : 0;
+        uint32_t b = feb == 0 ? next++ : fifo.vertex(feb);
+        uint32_t c = fec == 0 ? next++ : fifo.vertex(fec);
+        if (fea == 15) last = a = decode_delta(data, last);
+        if (feb == 15) last = b = decode_delta(data, last);
+        if (fec == 15) last = c = decode_delta(data, last);
+        emit(i, a, b, c);
+        fifo.push_vertex(a);
+        fifo.push_vertex(b, feb == 0 || feb == 15);
+        fifo.push_vertex(c, fec == 0 || fec == 15);
+        fifo.push_edge(b, a);
+        fifo.push_edge(c, b);
+        fifo.push_edge(a, c);
+    }
+    return data == data_end;
+}
+
+bool decode_meshopt_indices(std::span<std::byte const> src, size_t count, size_t stride, std::span<std::byte> dst) noexcept
+{
+    // header, at least one byte per index and a 4 byte tail
+    if ((stride != 2 && stride != 4) || dst.size() < count * stride || src.size() < 1 + count + 4) return false;
+    auto const* data = reinterpret_cast<uint8_t const*>(src.data());
+    if ((data[0] & 0xf0) != sequence_header || (data[0] & 0x0f) > 1) return false;
+    auto const* data_end = data + src.size() - 4;
+    ++data;
+
+    // deltas alternate between two baselines, the low bit selects one
+    uint32_t    last[2] = {0, 0};
+    auto* const out     = reinterpret_cast<uint8_t*>(dst.data());
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (data >= data_end) return false;
+        auto const v        = decode_vbyte(data);
+        auto const baseline = v & 1;
+        auto const delta    = v >> 1;
+        last[baseline] += (delta >> 1) ^ (0u - (delta & 1));
+        write_index(out, i, stride, last[baseline]);
+    }
+    return data == data_end;
+}
+
+bool apply_meshopt_filter(meshopt_filter filter, std::span<std::byte> data, size_t count, size_t stride) noexcept
+{
+    if (data.size() < count * stride) return false;
+    auto* const p = reinterpret_cast<uint8_t*>(data.data());
+    switch (filter)
+    {
+        case meshopt_filter::none: return true;
+        case meshopt_filter::octahedral:
+            if (stride == 4)
+                octahedral_filter<int8_t>(p, count);
+            else if (stride == 8)
+                octahedral_filter<int16_t>(p, count);
+            return stride == 4 || stride == 8;
+        case meshopt_filter::quaternion:
+            if (stride == 8) quaternion_filter(p, count);
+            return stride == 8;
+        case meshopt_filter::exponential:
+            if (stride % 4 == 0) exponential_filter(p, count * stride / 4);
+            return stride % 4 == 0;
+    }
+    return false;
+}
+
+bool decode_meshopt(meshopt_compression const& c, std::span<std::byte const> src, std::span<std::byte> dst) noexcept
+{
+    switch (c.mode)
+    {
+        case meshopt_mode::attributes:
+            return decode_meshopt_vertices(src, c.count, c.stride, dst) && apply_meshopt_filter(c.filter, dst, c.count, c.stride);
+        case meshopt_mode::triangles: return c.filter == meshopt_filter::none && decode_meshopt_triangles(src, c.count, c.stride, dst);
+        case meshopt_mode::indices: return c.filter == meshopt_filter::none && decode_meshopt_indices(src, c.count, c.stride, dst);
+    }
+    return false;
+}
+
+size_t decode_meshopt_views(doc& d, std::vector<std::byte>& storage, thread_pool* pool)
+{
+    // decoded views are placed back to back, 16 byte aligned for the simd converters
+    std::vector<size_t> views, offsets;
+    size_t              total = 0;
+    for (size_t i = 0; i != d.buffer_views.size(); ++i)
+    {
+        auto const& c = d.buffer_views[i].meshopt;
+        if (c.count == 0) continue;
+        views.push_back(i);
+        offsets.push_back(total);
+        total += (size_t{c.count} * c.stride + 15) & ~size_t{15};
+    }
+    if (views.empty()) return 0;
+    storage.assign(total, std::byte{0});
+
+    std::vector<uint8_t> decoded(views.size(), 0);
+    auto const           decode = [&](size_t i)
+    {
+        auto const& c      = d.buffer_views[views[i]].meshopt;
+        auto const  source = buffer_data(d, c.buffer);
+        if (size_t{c.offset} + c.length > source.size()) return;
+        auto const  target = std::span(storage).subspan(offsets[i], size_t{c.count} * c.stride);
+        decoded[i]         = decode_meshopt(c, source.subspan(c.offset, c.length), target);
+    };
+    if (pool && pool->size() > 1 && views.size() > 1)
+        pool->for_each(views.size(), [&](size_t i, size_t) { decode(i); });
+    else
+        for (size_t i = 0; i != views.size(); ++i) decode(i);
+
+    auto const buffer = static_cast<uint32_t>(d.buffers.size());
+    d.buffers.emplace_back(infile_buffer{storage.size(), std::span<std::byte const>(storage)});
+    size_t failed = 0;
+    for (size_t i = 0; i != views.size(); ++i)
+    {
+        if (!decoded[i])
+        {
+            ++failed;
+            continue;
+        }
+        auto& v   = d.buffer_views[views[i]];
+        v.buffer  = buffer;
+        v.offset  = static_cast<uint32_t>(offsets[i]);
+        v.length  = v.meshopt.count * v.meshopt.stride;
+        v.meshopt = meshopt_compression{};
+    }
+    return failed;
+}
+}  // namespace trivial_gltf
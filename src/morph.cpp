@@ -0,0 +1,137 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include "simd.h"
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/morph.h>
+#include <algorithm>
+
+namespace trivial_gltf
+{
+namespace
+{
+// dense targets are accumulated block wise so that the output block stays in cache across all targets
+constexpr size_t block_floats = 3 * 1024;
+
+// a target is stored sparse when at most this fraction of the vertices move
+constexpr size_t sparse_ratio = 4;
+
+int32_t find_accessor(doc const& d, std::pmr::vector<attribute_offset> const& attributes, attribute a) noexcept
+{
+    for (auto const& entry : attributes)
+        if (tiny_tuple::get<0>(entry) == a)
+            return tiny_tuple::get<1>(entry) < d.accessors.size() ? static_cast<int32_t>(tiny_tuple::get<1>(entry)) : -1;
+    return -1;
+}
+
+// out[i] += w * delta[i]
+void accumulate(float w, float const* delta, float* out, size_t n) noexcept
+{
+    size_t i = 0;
+#if TRIVIAL_GLTF_X86_SIMD
+    auto const weight = _mm_set1_ps(w);
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(weight, _mm_loadu_ps(delta + i))));
+        _mm_storeu_ps(out + i + 4, _mm_add_ps(_mm_loadu_ps(out + i + 4), _mm_mul_ps(weight, _mm_loadu_ps(delta + i + 4))));
+    }
+#endif
+    for (; i != n; ++i) out[i] += w * delta[i];
+}
+}  // namespace
+
+morph_deltas::morph_deltas(doc const& d, primitive const& p, attribute attr)
+{
+    auto const base = find_accessor(d, p.attributes, attribute::position);
+    if (base < 0) return;
+    vertex_count = d.accessors[base].count;
+
+    std::vector<float> dense;
+    for (auto const& t : p.targets)
+    {
+        auto& entry       = targets.emplace_back();
+        entry.first_delta = static_cast<uint32_t>(deltas.size() / 3);
+        entry.first_index = static_cast<uint32_t>(indices.size());
+        entry.sparse      = true;  // with no vertices until the displacements decode
+        auto const index  = find_accessor(d, t, attr);
+        if (index < 0) continue;
+        auto const& acc = d.accessors[index];
+        if (acc.count != vertex_count || component_count(acc.type) != 3) continue;
+        if (acc.sparse.count && acc.view >= d.buffer_views.size())
+        {
+            // only the substituted vertices move, take them as they are
+            auto const sparse = resolve_sparse(d, acc);
+            bool       valid  = sparse.indices != nullptr;
+            for (size_t k = 0; valid && k != sparse.count; ++k) valid = sparse.index(k) < vertex_count;
+            if (!valid) continue;
+            for (size_t k = 0; k != sparse.count; ++k) indices.push_back(sparse.index(k));
+            deltas.resize(deltas.size() + 3 * sparse.count);
+            convert_to_float(acc.comp_type, acc.normalized, sparse.values, &deltas[3 * size_t{entry.first_delta}], 3 * sparse.count);
+            entry.count = static_cast<uint32_t>(sparse.count);
+            continue;
+        }
+        dense.resize(3 * size_t{vertex_count});
+        if (decode_floats(d, acc, dense) != dense.size()) continue;
+
+        size_t moved = 0;
+        for (size_t v = 0; v != vertex_count; ++v) moved += dense[3 * v] != 0.0f || dense[3 * v + 1] != 0.0f || dense[3 * v + 2] != 0.0f;
+        if (moved * sparse_ratio > vertex_count)
+        {
+            entry.sparse = false;
+            entry.count  = vertex_count;
+            deltas.insert(deltas.end(), dense.begin(), dense.end());
+            continue;
+        }
+        entry.count = static_cast<uint32_t>(moved);
+        for (uint32_t v = 0; v != vertex_count; ++v)
+        {
+            if (dense[3 * v] == 0.0f && dense[3 * v + 1] == 0.0f && dense[3 * v + 2] == 0.0f) continue;
+            indices.push_back(v);
+            deltas.insert(deltas.end(), &dense[3 * v], &dense[3 * v] + 3);
+        }
+    }
+}
+
+void apply_morph_targets(morph_deltas const& m, std::span<float const> weights, std::span<float const> base, std::span<float> out) noexcept
+{
+    size_t const n = 3 * size_t{m.vertex_count};
+    if (base.size() < n || out.size() < n) return;
+    if (out.data() != base.data()) std::copy(base.begin(), base.begin() + n, out.begin());
+
+    size_t const targets = std::min(weights.size(), m.targets.size());
+    for (size_t block = 0; block < n; block += block_floats)
+    {
+        auto const length = std::min(block_floats, n - block);
+        for (size_t i = 0; i != targets; ++i)
+        {
+            auto const& t = m.targets[i];
+            if (weights[i] == 0.0f || t.sparse) continue;
+            accumulate(weights[i], m.deltas.data() + 3 * size_t{t.first_delta} + block, out.data() + block, length);
+        }
+    }
+    for (size_t i = 0; i != targets; ++i)
+    {
+        auto const& t = m.targets[i];
+        if (weights[i] == 0.0f || !t.sparse) continue;
+        auto const* delta = m.deltas.data() + 3 * size_t{t.first_delta};
+        auto const* index = m.indices.data() + t.first_index;
+        for (size_t k = 0; k != t.count; ++k)
+        {
+            auto* v = out.data() + 3 * size_t{index[k]};
+            v[0] += weights[i] * delta[3 * k];
+            v[1] += weights[i] * delta[3 * k + 1];
+            v[2] += weights[i] * delta[3 * k + 2];
+        }
+    }
+}
+
+std::span<float const> morph_weights(doc const& d, node const& n) noexcept
+{
+    if (!n.weights.empty()) return n.weights;
+    if (n.mesh >= 0 && static_cast<size_t>(n.mesh) < d.meshes.size()) return d.meshes[n.mesh].weights;
+    return {};
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,26 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/parse_stats.h>
+
+namespace trivial_gltf
+{
+char const* section_name(doc_section s) noexcept
+{
+    static char const* const names[] = {"scenes", "nodes",   "meshes",   "animations",  "materials", "skins",  "accessors",
+                                        "images", "textures", "samplers", "bufferViews", "buffers",   "other"};
+    return s < doc_section::count ? names[static_cast<size_t>(s)] : "";
+}
+
+void* counting_resource::do_allocate(size_t size, size_t alignment)
+{
+    ++count;
+    bytes += size;
+    return upstream->allocate(size, alignment);
+}
+
+void counting_resource::do_deallocate(void* p, size_t size, size_t alignment) { upstream->deallocate(p, size, alignment); }
+}  // namespace trivial_gltf
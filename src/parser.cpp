@@ -5,368 +5,878 @@
 ========================================================================== */
 
 #include "parser.h"
+#include "base64_decode.h"
+#include "keyword_matcher.h"
+#include <trivial_gltf/parse_stats.h>
 
 #include <async_json/on_array_element.hpp>
 #include <async_json/is_path.hpp>
 #include <algorithm>
 #include <numeric>
+#include <memory>
+#include <optional>
 
 namespace trivial_gltf
 {
-struct keyword
+constexpr char const* interpolation_keywords[]  = {"LINEAR", "STEP", "CUBICSPLINE"};
+constexpr char const* type_keywords[]           = {"SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4"};
+constexpr char const* path_keywords[]           = {"scale", "rotation", "translation", "weights"};
+constexpr char const* attribute_names[]         = {"POSITION",   "NORMAL",  "TANGENT",  "TEXCOORD_0",
+                                                   "TEXCOORD_1", "COLOR_0", "JOINTS_0", "WEIGHTS_0"};
+constexpr char const* alpha_mode_keywords[]     = {"OPAQUE", "MASK", "BLEND"};
+constexpr char const* meshopt_mode_keywords[]   = {"ATTRIBUTES", "TRIANGLES", "INDICES"};
+constexpr char const* meshopt_filter_keywords[] = {"NONE", "OCTAHEDRAL", "QUATERNION", "EXPONENTIAL"};
+
+constexpr keyword_trie<trie_size(interpolation_keywords)>  interpolation_trie{interpolation_keywords};
+constexpr keyword_trie<trie_size(type_keywords)>           type_trie{type_keywords};
+constexpr keyword_trie<trie_size(path_keywords)>           path_trie{path_keywords};
+constexpr keyword_trie<trie_size(attribute_names)>         attribute_trie{attribute_names};
+constexpr keyword_trie<trie_size(alpha_mode_keywords)>     alpha_mode_trie{alpha_mode_keywords};
+constexpr keyword_trie<trie_size(meshopt_mode_keywords)>   meshopt_mode_trie{meshopt_mode_keywords};
+constexpr keyword_trie<trie_size(meshopt_filter_keywords)> meshopt_filter_trie{meshopt_filter_keywords};
+
+static_assert(interpolation_trie.find("CUBICSPLINE") == static_cast<int>(interpolation_type::cubic_spline));
+static_assert(attribute_trie.find("WEIGHTS_0") == value<attribute::weights_0>);
+static_assert(attribute_trie.find("WEIGHTS_1") == -1 && attribute_trie.find("TEXCOORD") == -1);
+static_assert(meshopt_filter_trie.find("EXPONENTIAL") == static_cast<int>(meshopt_filter::exponential));
+
+// assigns the index of the matching keyword to param once the string value is complete, unknown values leave param untouched
+template <typename Trie>
+constexpr auto resolve_keywords(Trie const& trie, int32_t& param)
 {
-    char const* word;
-    uint32_t    offset{0};
-};
-keyword interpolation_keywords[] = {{"LINEAR"}, {"STEP"}, {"CUBICSPLNE"}};
-keyword type_keywords[]          = {{"SCALAR"}, {"VEC2"}, {"VEC3"}, {"VEC4"}, {"MAT2"}, {"MAT3"}, {"MAT4"}};
-keyword path_keywords[]          = {{"scale"}, {"rotation"}, {"translation"}, {"weights"}};
-keyword attribute_names[]        = {{"POSITION"},   {"NORMAL"},  {"TANGENT"},  {"TEXCOORD_0"},
-                             {"TEXCOORD_1"}, {"COLOR_0"}, {"JOINTS_0"}, {"WEIGHTS_0"}};
-keyword alpha_mode_keywords[]    = {{"OPAQUE"}, {"MASK"}, {"BLEND"}};
-
-bool test(std::string_view const& l, char const* r)
+    return [&param, &trie, state = Trie::root](auto const& ev) mutable
+    {
+        switch (ev.event)
+        {
+            case async_json::saj_event::string_value_start: state = trie.feed(Trie::root, ev.as_string_view()); break;
+            case async_json::saj_event::string_value_cont: state = trie.feed(state, ev.as_string_view()); break;
+            case async_json::saj_event::string_value_end:
+                if (auto const v = trie.value(trie.feed(state, ev.as_string_view())); v != Trie::no_match) param = v;
+                break;
+            default: break;
+        }
+    };
+}
+
+constexpr auto resolve_path(int32_t& param) { return resolve_keywords(path_trie, param); }
+constexpr auto resolve_animation_style(int32_t& param) { return resolve_keywords(interpolation_trie, param); }
+constexpr auto resolve_type(int32_t& param) { return resolve_keywords(type_trie, param); }
+constexpr auto resolve_alpha_mode(int32_t& param) { return resolve_keywords(alpha_mode_trie, param); }
+constexpr auto resolve_meshopt_mode(int32_t& param) { return resolve_keywords(meshopt_mode_trie, param); }
+constexpr auto resolve_meshopt_filter(int32_t& param) { return resolve_keywords(meshopt_filter_trie, param); }
+
+template <typename Element>
+void notify(doc_listener* listener, std::pmr::vector<Element> const& elements, void (doc_listener::*callback)(size_t, Element const&))
+{
+    if (listener) (listener->*callback)(elements.size() - 1, elements.back());
+}
+
+namespace
+{
+std::array<size_t, doc_section_count - 1> section_sizes(doc const& d) noexcept
 {
-    auto lb = l.begin();
-    auto le = l.end();
-    while (*r && lb != le)
-        if (*lb++ != *r++) return false;
-    return lb == le;
+    return {d.scenes.size(),    d.nodes.size(),    d.meshes.size(),   d.animations.size(), d.materials.size(),    d.skins.size(),
+            d.accessors.size(), d.images.size(),   d.textures.size(), d.samplers.size(),   d.buffer_views.size(), d.buffers.size()};
 }
 
-template <size_t N>
-constexpr auto resolve_keywords(keyword (&kws)[N], int32_t& param)
+// stats policies of the parser, everything in no_stats compiles away
+struct no_stats
+{
+    void begin_chunk(size_t) noexcept {}
+    template <typename Event>
+    void on_event(Event const&, int32_t) noexcept
+    {
+    }
+    void end_chunk(doc const&) noexcept {}
+};
+
+class collecting_stats
 {
-    return [&param, kws](auto const& ev) mutable
+   public:
+    collecting_stats(parse_stats& out, doc const& d)
+        : out{out}, counter{dynamic_cast<counting_resource const*>(d.resource())}, base_sizes{section_sizes(d)}
     {
-        if (ev.event == async_json::saj_event::string_value_start || ev.event == async_json::saj_event::string_value_cont)
+        if (counter)
         {
-            for (auto& item : kws)
-                if (test(ev.as_string_view(), item.word + item.offset))
-                    item.offset += ev.as_string_view().size();
-                else
-                    item.offset = 0;
+            base_allocations = counter->allocations();
+            base_bytes       = counter->allocated_bytes();
         }
-        else if (ev.event == async_json::saj_event::string_value_end)
+    }
+
+    void begin_chunk(size_t bytes) noexcept
+    {
+        out.bytes_consumed += bytes;
+        ++out.chunks;
+        last = std::chrono::steady_clock::now();
+    }
+
+    template <typename Event>
+    void on_event(Event const& ev, int32_t depth)
+    {
+        using async_json::saj_event;
+        switch (ev.event)
         {
-            for (auto& item : kws)
-                if (item.word[item.offset] == '\0')
-                {
-                    param       = &item - &(kws[0]);
-                    item.offset = 0;
-                }
+            case saj_event::object_name_start:
+            case saj_event::object_name_cont:
+            case saj_event::object_name_end:
+                if (depth != 1) break;
+                if (ev.event == saj_event::object_name_start) key.clear();
+                key += ev.as_string_view();
+                if (ev.event == saj_event::object_name_end) switch_section();
+                break;
+            case saj_event::string_value_start:
+                count_array_element();
+                string_length = ev.as_string_view().size();
+                break;
+            case saj_event::string_value_cont: string_length += ev.as_string_view().size(); break;
+            case saj_event::string_value_end:
+                string_length += ev.as_string_view().size();
+                out.largest_string = std::max<uint64_t>(out.largest_string, string_length);
+                break;
+            case saj_event::object_start:
+            case saj_event::array_start:
+                count_array_element();
+                open.push_back({ev.event == saj_event::array_start, 0});
+                break;
+            case saj_event::object_end:
+            case saj_event::array_end:
+                if (open.empty()) break;
+                if (open.back().array) out.largest_array = std::max<uint64_t>(out.largest_array, open.back().elements);
+                open.pop_back();
+                break;
+            default: count_array_element(); break;
         }
+    }
+
+    void end_chunk(doc const& d) noexcept
+    {
+        auto const now = std::chrono::steady_clock::now();
+        out.sections[current].time += now - last;
+        last = now;
+
+        auto const sizes = section_sizes(d);
+        for (size_t i = 0; i != sizes.size(); ++i) out.sections[i].elements = sizes[i] - base_sizes[i];
+        if (counter)
+        {
+            out.allocations     = counter->allocations() - base_allocations;
+            out.allocated_bytes = counter->allocated_bytes() - base_bytes;
+        }
+    }
+
+   private:
+    struct container
+    {
+        bool     array;
+        uint64_t elements;
     };
+    void count_array_element() noexcept
+    {
+        if (!open.empty() && open.back().array) ++open.back().elements;
+    }
+    void switch_section()
+    {
+        auto next = doc_section::other;
+        for (size_t i = 0; i != doc_section_count - 1; ++i)
+            if (key == section_name(static_cast<doc_section>(i))) next = static_cast<doc_section>(i);
+        auto const now = std::chrono::steady_clock::now();
+        out.sections[current].time += now - last;
+        last    = now;
+        current = static_cast<size_t>(next);
+    }
+
+    parse_stats&                              out;
+    counting_resource const*                  counter;
+    std::array<size_t, doc_section_count - 1> base_sizes;
+    uint64_t                                  base_allocations{0};
+    uint64_t                                  base_bytes{0};
+    size_t                                    current{static_cast<size_t>(doc_section::other)};
+    std::chrono::steady_clock::time_point     last{};
+    uint64_t                                  string_length{0};
+    std::string                               key;
+    std::vector<container>                    open;
+};
+
+// index of the attribute semantic, names other than the core attributes are registered as extended attributes of the doc
+int32_t resolve_attribute(doc& dest, int16_t core, std::string_view name)
+{
+    if (core != attribute_trie.no_match) return core;
+    auto const known = std::find(dest.extended_attributes.begin(), dest.extended_attributes.end(), name);
+    auto const index = static_cast<size_t>(known - dest.extended_attributes.begin());
+    if (index >= max_extended_attributes) return -1;
+    if (known == dest.extended_attributes.end()) dest.extended_attributes.emplace_back(name);
+    return value<attribute::extended_attribute> + static_cast<int32_t>(index);
 }
 
-constexpr auto resolve_path(int32_t& param) { return resolve_keywords(path_keywords, param); }
-constexpr auto resolve_attribute(int32_t& param) { return resolve_keywords(attribute_names, param); }
-constexpr auto resolve_animation_style(int32_t& param) { return resolve_keywords(interpolation_keywords, param); }
-constexpr auto resolve_type(int32_t& param) { return resolve_keywords(type_keywords, param); }
-constexpr auto resolve_alpha_mode(int32_t& param) { return resolve_keywords(alpha_mode_keywords, param); }
+uint32_t attribute_bit(attribute a) noexcept { return 1u << std::min(static_cast<int>(a), value<attribute::extended_attribute>); }
 
-}  // namespace trivial_gltf
+// what a uri turned out to be while its string fragments arrive
+enum class uri_kind : uint8_t
+{
+    undecided,
+    plain,
+    base64
+};
 
-std::function<trivial_gltf::parse_state(std::span<char const> const&)> trivial_gltf::create_parser(trivial_gltf::doc& dest)
+// data uris are recognized by a comma within this many characters
+constexpr size_t max_data_uri_header = 256;
+
+template <typename Stats>
+struct internal_state
 {
-    namespace a = async_json;
-    struct internal_state
+    // temporaries are allocated from the resource of the doc, so that moving them into the doc keeps them there
+    explicit internal_state(std::pmr::memory_resource* r)
+        : base_color_texture{0, 0, std::pmr::string(r)},
+          metallic_roughness_texture{0, 0, std::pmr::string(r)},
+          emissive_texture{0, 0, std::pmr::string(r)},
+          normal_texture{{0, 0, std::pmr::string(r)}, 0.0f},
+          occlusion_texture{{0, 0, std::pmr::string(r)}, 0.0f},
+          u_numbers(r),
+          node_numbers(r),
+          f_numbers1(r),
+          f_numbers2(r),
+          channels(r),
+          samplers(r),
+          attribute_data(r),
+          target_data(r),
+          targets(r),
+          primitives(r),
+          name_str(r),
+          uri(r),
+          mime(r),
+          attribute_name(r),
+          embedded(r)
+    {
+    }
+    doc*                                dest{nullptr};
+    std::optional<Stats>                stats;
+    doc_listener*                       listener{nullptr};
+    int32_t                             depth{0};
+    bool                                complete{false};
+    bool                                failed{false};
+    int32_t                             id1{-1}, id2{-1}, id4{-1}, id5{-1};
+    int32_t                             id3_nd{0};
+    int32_t                             wrap_s{10497}, wrap_t{10497};
+    int32_t                             draw_mode{4};
+    float                               alpha_cut_off{0.5f};
+    float                               fac1{1.0f};
+    float                               fac2{1.0f};
+    texture_info                        base_color_texture;
+    texture_info                        metallic_roughness_texture;
+    texture_info                        emissive_texture;
+    normal_texture_info                 normal_texture;
+    occlusion_texture_info              occlusion_texture;
+    bool                                flag1{false};
+    std::pmr::vector<uint32_t>          u_numbers;
+    std::pmr::vector<uint32_t>          node_numbers;
+    std::pmr::vector<float>             f_numbers1;
+    std::pmr::vector<float>             f_numbers2;
+    std::pmr::vector<channel>           channels;
+    std::pmr::vector<animation_sampler> samplers;
+    std::pmr::vector<attribute_offset>  attribute_data;
+    std::pmr::vector<attribute_offset>  target_data;
+    std::pmr::vector<morph_target>      targets;
+    std::pmr::vector<primitive>         primitives;
+    std::pmr::string                    name_str, uri, mime;
+    std::pmr::string                    attribute_name;
+    uint16_t                            attribute_state{0};
+    glm::vec3                           scale{1.0f, 1.0f, 1.0f};
+    glm::vec3                           translation{.0f, .0f, .0f};
+    glm::vec4                           color{1.0f, 1.0f, 1.0f, 1.0f};
+    glm::qua<float>                     rotation{1.0f, .0f, .0f, .0f};
+    sparse_accessor                     sparse;
+    int32_t                             sparse_indices_type{5125};
+    meshopt_compression                 meshopt;
+    int32_t                             compression_mode{0}, compression_filter{0};
+    uri_kind                            uri_state{uri_kind::plain};
+    base64_decoder                      base64;
+    std::pmr::vector<std::byte>         embedded;  // decoded data uri, the first embedded_size bytes are valid
+    size_t                              embedded_size{0};
+
+    // clears in place - containers that were not moved into the doc keep their capacity
+    void reset_parse_state() noexcept
     {
-        int32_t                        id1{-1}, id2{-1}, id4{-1}, id5{-1};
-        int32_t                        id3_nd{0};
-        int32_t                        wrap_s{10497}, wrap_t{10497};
-        int32_t                        draw_mode{4};
-        float                          alpha_cut_off{0.5f};
-        float                          fac1{1.0f};
-        float                          fac2{1.0f};
-        texture_info                   base_color_texture;
-        texture_info                   metallic_roughness_texture;
-        texture_info                   emissive_texture;
-        normal_texture_info            normal_texture;
-        occlusion_texture_info         occlusion_texture;
-        bool                           flag1{false};
-        std::vector<uint32_t>          u_numbers;
-        std::vector<uint32_t>          node_numbers;
-        std::vector<float>             f_numbers1;
-        std::vector<float>             f_numbers2;
-        std::vector<channel>           channels;
-        std::vector<animation_sampler> samplers;
-        std::vector<attribute_offset>  attribute_data;
-        std::vector<primitive>         primitives;
-        std::string                    name_str, uri;
-        glm::vec3                      scale{1.0f, 1.0f, 1.0f};
-        glm::vec3                      translation{.0f, .0f, .0f};
-        glm::vec4                      color{1.0f, 1.0f, 1.0f, 1.0f};
-        glm::qua<float>                rotation;
-
-        void reset_parse_state() noexcept { *this = internal_state{}; }
-        void reset_ids() noexcept
+        reset_ids();
+        alpha_cut_off = 0.5f;
+        fac1 = fac2 = 1.0f;
+        flag1       = false;
+        for (texture_info* t : {&base_color_texture, &metallic_roughness_texture, &emissive_texture,
+                                static_cast<texture_info*>(&normal_texture), static_cast<texture_info*>(&occlusion_texture)})
         {
-            id1 = id2 = id4 = id5 = -1;
-            id3_nd                = 0;
-            draw_mode             = 4;
-            wrap_s = wrap_t = 10497;
+            t->index = t->tex_coord = 0;
+            t->name.clear();
         }
-    } p;
-    auto parse_texture = [](char const* tex_attrib, texture_info& info)
+        normal_texture.scale = occlusion_texture.strength = 0.0f;
+        u_numbers.clear();
+        node_numbers.clear();
+        f_numbers1.clear();
+        f_numbers2.clear();
+        channels.clear();
+        samplers.clear();
+        attribute_data.clear();
+        target_data.clear();
+        targets.clear();
+        primitives.clear();
+        name_str.clear();
+        reset_uri();
+        mime.clear();
+        attribute_name.clear();
+        scale               = glm::vec3{1.0f, 1.0f, 1.0f};
+        translation         = glm::vec3{.0f, .0f, .0f};
+        color               = glm::vec4{1.0f, 1.0f, 1.0f, 1.0f};
+        rotation            = glm::qua<float>{1.0f, .0f, .0f, .0f};
+        sparse              = sparse_accessor{};
+        sparse_indices_type = 5125;
+        meshopt             = meshopt_compression{};
+        compression_mode = compression_filter = 0;
+    }
+    // prepares for the next json document
+    void restart() noexcept
+    {
+        depth    = 0;
+        complete = false;
+        failed   = false;
+        reset_parse_state();
+        attribute_state = 0;
+    }
+    void begin_uri()
+    {
+        reset_uri();
+        uri_state = uri_kind::undecided;
+    }
+    void reset_uri() noexcept
+    {
+        uri.clear();
+        uri_state = uri_kind::plain;
+        embedded.clear();
+        embedded_size = 0;
+    }
+
+    // Collects the uri like assign_string, except for base64 data uris. Those keep only their header in uri, the
+    // payload is decoded into embedded as it arrives, preallocated with byte_length when that is already known.
+    void append_uri(std::string_view text, int32_t byte_length)
+    {
+        if (uri_state == uri_kind::base64) return decode_base64(text);
+        uri.append(text);
+        if (uri_state != uri_kind::undecided) return;
+
+        constexpr std::string_view scheme = "data:";
+        std::string_view const     value  = uri;
+        auto const                 comma  = value.find(',');
+        if (!value.starts_with(scheme.substr(0, std::min(value.size(), scheme.size()))) ||
+            (comma == value.npos && value.size() > max_data_uri_header) ||
+            (comma != value.npos && !value.substr(0, comma).ends_with(";base64")))
+            uri_state = uri_kind::plain;
+        if (uri_state != uri_kind::undecided || comma == value.npos) return;
+
+        uri_state = uri_kind::base64;
+        base64.reset();
+        embedded.resize(static_cast<size_t>(std::max(byte_length, 0)));
+        embedded_size = 0;
+        decode_base64(value.substr(comma + 1));
+        uri.resize(comma);
+    }
+    void decode_base64(std::string_view text)
+    {
+        auto const* first = text.data();
+        auto const* last  = first + text.size();
+        for (;;)
+        {
+            auto* out     = embedded.data() + embedded_size;
+            first         = base64.decode(first, last, out, embedded.data() + embedded.size());
+            embedded_size = static_cast<size_t>(out - embedded.data());
+            if (first == last) return;
+            // byteLength was missing or too small
+            embedded.resize(std::max(2 * embedded.size(), size_t{4096}));
+        }
+    }
+    void end_uri()
+    {
+        if (uri_state == uri_kind::undecided) uri_state = uri_kind::plain;
+        if (uri_state != uri_kind::base64) return;
+        if (embedded.size() - embedded_size < base64.pending_bytes()) embedded.resize(embedded_size + base64.pending_bytes());
+        auto* out = embedded.data() + embedded_size;
+        base64.finish(out);
+        embedded_size = static_cast<size_t>(out - embedded.data());
+        embedded.resize(embedded_size);
+    }
+
+    void reset_ids() noexcept
+    {
+        id1 = id2 = id4 = id5 = -1;
+        id3_nd                = 0;
+        draw_mode             = 4;
+        wrap_s = wrap_t = 10497;
+    }
+};
+
+template <typename Stats>
+auto build_extractor(internal_state<Stats>& p, parse_options options)
+{
+    namespace a = async_json;
+    // disabled sections are bound to a key that cannot occur in json, raw control characters have to be escaped
+    constexpr char const* skipped_key = "\x1f";
+    auto const            key         = [options](parse_options section, char const* name)
+    { return has_option(options, section) ? name : skipped_key; };
+    auto const name_key = key(parse_options::names, "name");
+
+    constexpr char const* meshopt_ext = "EXT_meshopt_compression";
+
+    // byte_length is the field of the element that sizes decoded data uris, when given
+    auto const assign_uri = [&p](int32_t const* byte_length)
+    {
+        return [&p, byte_length](auto const& ev)
+        {
+            if (ev.event == a::saj_event::string_value_start) p.begin_uri();
+            if (ev.event == a::saj_event::string_value_start || ev.event == a::saj_event::string_value_cont ||
+                ev.event == a::saj_event::string_value_end)
+                p.append_uri(ev.as_string_view(), byte_length ? *byte_length : -1);
+            if (ev.event == a::saj_event::string_value_end) p.end_uri();
+        };
+    };
+
+    auto parse_texture = [name_key](char const* tex_attrib, texture_info& info)
     {
         return a::path(a::all(                                                      //
                            a::path(a::assign_numeric(info.index), "index"),         //
                            a::path(a::assign_numeric(info.tex_coord), "texCoord"),  //
-                           a::path(a::assign_string(info.name), "name")             //
+                           a::path(assign_string(info.name), name_key)              //
                            ),                                                       //
                        tex_attrib);
     };
-    return [&dest, p,
-            extractor = a::make_extractor(  //
-                [parse_texture](a::error_cause er) { /* todo add error handling for illegal */ },
-                a::path(                                                      //
-                    a::all(                                                   //
-                        a::path(a::assign_string(p.name_str), "name"),        //
-                        a::path(a::assign_numeric(p.node_numbers), "nodes"),  //
-                        a::on_array_element([&](auto const&)
-                                            { dest.scenes.emplace_back(std::move(p.name_str), std::move(p.node_numbers)); })  //
-                        ),                                                                                                    //
-                    "scenes"),                                                                                                //
-                a::path(                                                                                                      //
-                    a::all(                                                                                                   //
-                        a::path(a::assign_string(p.name_str), "name"),                                                        //
-                        a::path(a::assign_numeric(p.id1), "mesh"),                                                            //
-                        a::path(a::assign_numeric(p.id2), "skin"),                                                            //
-                        a::path(a::assign_numeric(p.id4), "camera"),                                                          //
-                        a::path(assign_numeric(p.rotation), "rotation"),                                                      //
-                        a::path(assign_numeric(p.scale), "scale"),                                                            //
-                        a::path(assign_numeric(p.translation), "translation"),                                                //
-                        a::path(a::assign_numeric(p.node_numbers), "children"),                                               //
-                        a::path(a::assign_numeric(p.u_numbers), "weights"),                                                   //
-                        a::on_array_element(
-                            [&](auto const&)
-                            {
-                                dest.nodes.emplace_back(p.id1, p.id2, p.id4, p.rotation, p.scale, p.translation, std::move(p.node_numbers),
-                                                        std::move(p.u_numbers), std::move(p.name_str));
-                                p.reset_parse_state();
-                            })  //
-                        ),
-                    "nodes"),                                                       //
-                a::path(                                                            //
-                    a::all(                                                         //
-                        a::path(a::assign_string(p.name_str), "name"),              //
-                        a::path(                                                    //
-                            a::all(                                                 //
-                                a::path(a::assign_numeric(p.id1), "sampler"),       //
-                                a::path(                                            //
-                                    a::all(                                         //
-                                        a::path(a::assign_numeric(p.id2), "node"),  //
-                                        a::path(resolve_path(p.id4), "path")),      //
-                                    "target"),
-                                a::on_array_element(
-                                    [&](auto const&)
-                                    {
-                                        p.channels.emplace_back(p.id1, p.id2, static_cast<path_type>(p.id4));
-                                        p.reset_ids();
-                                    })),
-                            "channels"),                                      //
-                        a::path(                                              //
-                            a::all(                                           //
-                                a::path(a::assign_numeric(p.id1), "input"),   //
-                                a::path(a::assign_numeric(p.id2), "output"),  //
-                                a::path(resolve_animation_style(p.id3_nd), "interpolation"),
-                                a::on_array_element(
-                                    [&](auto const&)
-                                    {
-                                        p.samplers.emplace_back(p.id1, p.id2, static_cast<interpolation_type>(p.id3_nd));
-                                        p.reset_ids();
-                                    })),
-                            "samplers"),
-                        a::on_array_element(
-                            [&](auto const&)
-                            {
-                                dest.animations.emplace_back(p.name_str, std::move(p.channels), std::move(p.samplers));
-                                p.reset_parse_state();
-                            })),                                                                                   //
-                    "animations"),                                                                                 //
-                a::path(                                                                                           //
-                    a::all(                                                                                        //
-                        a::path(a::assign_string(p.name_str), "name"),                                             //
-                        a::path(a::assign_numeric(p.flag1), "doubleSided"),                                        //
-                        a::path(assign_numeric(p.translation), "emissiveFactor"),                                  //
-                        parse_texture("emissiveTexture", p.emissive_texture),                                      //
-                        parse_texture("normalTexture", p.normal_texture),                                          //
-                        a::path(a::assign_numeric(p.normal_texture.scale), "normalTexture", "scale"),              //
-                        parse_texture("occlusionTexture", p.occlusion_texture),                                    //
-                        a::path(a::assign_numeric(p.occlusion_texture.strength), "occlusionTexture", "strength"),  //
-                        a::path(resolve_alpha_mode(p.id3_nd), "alphaMode"),                                        //
-                        a::path(a::assign_numeric(p.alpha_cut_off), "alphaCutOff"),                                //
-                        a::path(                                                                                   //
-                            a::all(a::path(assign_numeric(p.color), "base_color_factor"),
-                                   a::path(a::assign_numeric(p.fac1), "metallicFactor"),   //
-                                   a::path(a::assign_numeric(p.fac2), "roughnessFactor"),  //
-                                   parse_texture("baseColorTexture", p.base_color_texture),
-                                   parse_texture("metallicRoughnessTexture", p.metallic_roughness_texture)),  //
-                            "pbrMetallicRoughness"),                                                          //
-                        a::on_array_element(
-                            [&](auto const&)
-                            {
-                                dest.materials.emplace_back(p.name_str,
-                                                            pbr_metallic_roughness{p.color, p.base_color_texture, p.fac1, p.fac2, p.metallic_roughness_texture},
-                                                            p.normal_texture, p.occlusion_texture, p.emissive_texture, p.translation,
-                                                            static_cast<alpha_mode_type>(p.id3_nd), p.alpha_cut_off, p.flag1);
-                                p.reset_parse_state();
-                            })),                                              //
-                    "materials"),                                             //
-                a::path(                                                      //
-                    a::all(                                                   //
-                        a::path(a::assign_string(p.name_str), "name"),        //
-                        a::path(a::assign_numeric(p.f_numbers1), "weights"),  //
-                        a::path(                                              //
-                            a::all(                                           //
-                                a::path(                                      //
-                                    a::all(                                   //
-                                        resolve_attribute(p.id5),
-                                        a::assign_numeric(p.id4),  //
-                                        [&](auto const& a)
-                                        {
-                                            p.attribute_data.emplace_back(static_cast<attribute>(p.id5), p.id4);
-                                            p.id5 = -1;
-                                            p.id4 = -1;
-                                        }),
-                                    "attributes"),                                //
-                                a::path(a::assign_numeric(p.id1), "indices"),     //
-                                a::path(a::assign_numeric(p.id2), "material"),    //
-                                a::path(a::assign_numeric(p.draw_mode), "mode"),  //
-                                a::on_array_element(
-                                    [&](auto const&)
-                                    {
-                                        auto att_flags = static_cast<attribute_flag>(std::accumulate(
-                                            p.attribute_data.begin(), p.attribute_data.end(), uint32_t{0},
-                                            [](uint32_t fl, auto const& i) { return fl | static_cast<uint32_t>(tiny_tuple::get<0>(i)); }));
-
-                                        p.primitives.emplace_back(std::move(p.attribute_data), p.id1, p.id2,
-                                                                  static_cast<mode_type>(p.draw_mode), att_flags);
-                                        p.id1 = p.id2 = -1;
-                                        p.draw_mode   = 4;
-                                    })),    //
-                            "primitives"),  //
-                        a::on_array_element(
-                            [&](auto const&)
-                            {
-                                dest.meshes.emplace_back(std::move(p.name_str), std::move(p.primitives), std::move(p.f_numbers1));
-                                p.reset_parse_state();
-                            })),  //
-                    "meshes"),
-                a::path(                                                            //
-                    a::all(                                                         //
-                        a::path(a::assign_string(p.name_str), "name"),              //
-                        a::path(a::assign_numeric(p.id1), "inverseBindMaterials"),  //
-                        a::path(a::assign_numeric(p.id2), "skeleton"),              //
-                        a::path(a::assign_numeric(p.u_numbers), "joints"),          //
-                        a::on_array_element(
-                            [&](auto const&)
-                            {
-                                dest.skins.emplace_back(p.name_str, p.id2, p.id1, std::move(p.u_numbers));
-                                p.reset_parse_state();
-                            })),  //
-                    "skins"),
-                a::path(                                                     //
-                    a::all(                                                  //
-                        a::path(a::assign_numeric(p.id1), "bufferView"),     //
-                        a::path(a::assign_numeric(p.id3_nd), "byteOffset"),  //
-                        a::path(a::assign_numeric(p.id2), "count"),          //
-                        a::path(a::assign_numeric(p.id4), "componentType"),  //
-                        a::path(resolve_type(p.id5), "type"),                //
-                        a::path(a::assign_numeric(p.flag1), "normalized"),   //
-                        a::path(a::assign_numeric(p.f_numbers1), "max"),     //
-                        a::path(a::assign_numeric(p.f_numbers2), "min"),     //
-                        a::on_array_element(
-                            [&](auto const&)
-                            {
-                                // TODO error handling component type valid, type string valid, max min same size.. and correct count
-                                // i.e. if type is MAT3 - it must be nine
-                                dest.accessors.emplace_back(p.id1, p.id3_nd, p.id2, static_cast<component>(p.id4),
-                                                            static_cast<attribute_type>(p.id5), p.flag1, std::move(p.f_numbers1),
-                                                            std::move(p.f_numbers2));
-                                p.reset_parse_state();
-                            })),  //
-                    "accessors"),
-                a::path(                                                  //
-                    a::all(                                               //
-                        a::path(a::assign_string(p.uri), "uri"),          //
-                        a::path(a::assign_string(p.uri), "mime"),         //
-                        a::path(a::assign_string(p.name_str), "name"),    //
-                        a::path(a::assign_numeric(p.id1), "bufferView"),  //
-                        a::on_array_element(
-                            [&](auto const&)
-                            {
-                                if (p.id1 == -1)
-                                    dest.images.emplace_back(external_image{std::move(p.name_str), std::move(p.uri)});
-                                else
-                                    dest.images.emplace_back(infile_image{std::move(p.name_str), std::move(p.uri), p.id1});
-                                p.reset_ids();
-                                p.uri.clear();
-                                p.name_str.clear();
-                            })),  //
-                    "images"),
-                a::path(                                                //
-                    a::all(                                             //
-                        a::path(a::assign_numeric(p.id1), "sampler"),   //
-                        a::path(a::assign_numeric(p.id2), "source"),    //
-                        a::path(a::assign_string(p.name_str), "name"),  //
+    // the attribute names are the keys of the object, the accessor indices its values, other values are ignored
+    auto parse_attributes = [&p](std::pmr::vector<attribute_offset>& dest)
+    {
+        return [&p, &dest](auto const& ev)
+        {
+            switch (ev.event)
+            {
+                case a::saj_event::object_name_start:
+                    p.attribute_name.assign(ev.as_string_view());
+                    p.attribute_state = attribute_trie.feed(attribute_trie.root, ev.as_string_view());
+                    break;
+                case a::saj_event::object_name_cont:
+                    p.attribute_name.append(ev.as_string_view());
+                    p.attribute_state = attribute_trie.feed(p.attribute_state, ev.as_string_view());
+                    break;
+                case a::saj_event::object_name_end:
+                    p.attribute_name.append(ev.as_string_view());
+                    p.attribute_state = attribute_trie.feed(p.attribute_state, ev.as_string_view());
+                    p.id5             = resolve_attribute(*p.dest, attribute_trie.value(p.attribute_state), p.attribute_name);
+                    break;
+                case a::saj_event::number_value:
+                    if (p.id5 != -1) dest.emplace_back(static_cast<attribute>(p.id5), static_cast<uint32_t>(ev.as_number()));
+                    p.id5 = -1;
+                    break;
+                case a::saj_event::string_value_start: p.id5 = -1; break;  // not an accessor index
+                default: break;
+            }
+        };
+    };
+    // the handlers refer to the state, so it has to outlive the extractor
+    return a::make_extractor(  //
+        [&p](a::error_cause er)
+        {
+            if (er != a::error_cause::no_error) p.failed = true;
+        },
+        [&p](auto const& ev)
+        {
+            // the document is complete once the top level object is closed again
+            if (ev.event == a::saj_event::object_start || ev.event == a::saj_event::array_start)
+                ++p.depth;
+            else if ((ev.event == a::saj_event::object_end || ev.event == a::saj_event::array_end) && --p.depth == 0)
+                p.complete = true;
+            p.stats->on_event(ev, p.depth);
+        },
+        a::path(                                                   //
+            a::all(                                                //
+                a::path(assign_string(p.name_str), name_key),      //
+                a::path(assign_numeric(p.node_numbers), "nodes"),  //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        p.dest->scenes.emplace_back(std::move(p.name_str), std::move(p.node_numbers));
+                        notify(p.listener, p.dest->scenes, &doc_listener::on_scene);
+                    })                                                  //
+                ),                                                      //
+            key(parse_options::scenes, "scenes")),                      //
+        a::path(                                                        //
+            a::all(                                                     //
+                a::path(assign_string(p.name_str), name_key),           //
+                a::path(a::assign_numeric(p.id1), "mesh"),              //
+                a::path(a::assign_numeric(p.id2), "skin"),              //
+                a::path(a::assign_numeric(p.id4), "camera"),            //
+                a::path(assign_numeric(p.rotation), "rotation"),        //
+                a::path(assign_numeric(p.scale), "scale"),              //
+                a::path(assign_numeric(p.translation), "translation"),  //
+                a::path(assign_numeric(p.node_numbers), "children"),    //
+                a::path(assign_numeric(p.f_numbers1), "weights"),       //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        p.dest->nodes.emplace_back(p.id1, p.id2, p.id4, p.rotation, p.scale, p.translation, std::move(p.node_numbers),
+                                                std::move(p.f_numbers1), std::move(p.name_str));
+                        notify(p.listener, p.dest->nodes, &doc_listener::on_node);
+                        p.reset_parse_state();
+                    })  //
+                ),
+            key(parse_options::nodes, "nodes")),                            //
+        a::path(                                                            //
+            a::all(                                                         //
+                a::path(assign_string(p.name_str), name_key),               //
+                a::path(                                                    //
+                    a::all(                                                 //
+                        a::path(a::assign_numeric(p.id1), "sampler"),       //
+                        a::path(                                            //
+                            a::all(                                         //
+                                a::path(a::assign_numeric(p.id2), "node"),  //
+                                a::path(resolve_path(p.id4), "path")),      //
+                            "target"),
                         a::on_array_element(
-                            [&](auto const&)
+                            [&p](auto const&)
                             {
-                                dest.textures.emplace_back(p.id1, p.id2, std::move(p.name_str));
+                                p.channels.emplace_back(p.id1, p.id2, static_cast<path_type>(p.id4));
                                 p.reset_ids();
-                                p.name_str.clear();
-                            })),  //
-                    "textures"),
-                a::path(                                                 //
-                    a::all(                                              //
-                        a::path(a::assign_numeric(p.id1), "magFilter"),  //
-                        a::path(a::assign_numeric(p.id2), "minFilter"),  //
-                        a::path(a::assign_numeric(p.wrap_s), "wrapS"),   //
-                        a::path(a::assign_numeric(p.wrap_t), "wrapT"),   //
+                            })),
+                    "channels"),                                      //
+                a::path(                                              //
+                    a::all(                                           //
+                        a::path(a::assign_numeric(p.id1), "input"),   //
+                        a::path(a::assign_numeric(p.id2), "output"),  //
+                        a::path(resolve_animation_style(p.id3_nd), "interpolation"),
                         a::on_array_element(
-                            [&](auto const&)
+                            [&p](auto const&)
                             {
-                                // TODO check values
-                                dest.samplers.emplace_back(p.id1, p.id2, p.wrap_s, p.wrap_t);
+                                p.samplers.emplace_back(p.id1, p.id2, static_cast<interpolation_type>(p.id3_nd));
                                 p.reset_ids();
-                            })),  //
+                            })),
                     "samplers"),
-                a::path(                                                     //
-                    a::all(                                                  //
-                        a::path(a::assign_numeric(p.id1), "buffer"),         //
-                        a::path(a::assign_numeric(p.id2), "byteLength"),   //
-                        a::path(a::assign_numeric(p.id3_nd), "byteOffset"),  //
-                        a::on_array_element(
-                            [&](auto const&)
-                            {
-                                dest.buffer_views.emplace_back(p.id1, p.id2, p.id3_nd);
-                                p.reset_ids();
-                            })),  //
-                    "bufferViews"),
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        p.dest->animations.emplace_back(std::move(p.name_str), std::move(p.channels), std::move(p.samplers));
+                        notify(p.listener, p.dest->animations, &doc_listener::on_animation);
+                        p.reset_parse_state();
+                    })),                                                                                   //
+            key(parse_options::animations, "animations")),                                                 //
+        a::path(                                                                                           //
+            a::all(                                                                                        //
+                a::path(assign_string(p.name_str), name_key),                                              //
+                a::path(a::assign_numeric(p.flag1), "doubleSided"),                                        //
+                a::path(assign_numeric(p.translation), "emissiveFactor"),                                  //
+                parse_texture("emissiveTexture", p.emissive_texture),                                      //
+                parse_texture("normalTexture", p.normal_texture),                                          //
+                a::path(a::assign_numeric(p.normal_texture.scale), "normalTexture", "scale"),              //
+                parse_texture("occlusionTexture", p.occlusion_texture),                                    //
+                a::path(a::assign_numeric(p.occlusion_texture.strength), "occlusionTexture", "strength"),  //
+                a::path(resolve_alpha_mode(p.id3_nd), "alphaMode"),                                        //
+                a::path(a::assign_numeric(p.alpha_cut_off), "alphaCutOff"),                                //
+                a::path(                                                                                   //
+                    a::all(a::path(assign_numeric(p.color), "base_color_factor"),
+                           a::path(a::assign_numeric(p.fac1), "metallicFactor"),   //
+                           a::path(a::assign_numeric(p.fac2), "roughnessFactor"),  //
+                           parse_texture("baseColorTexture", p.base_color_texture),
+                           parse_texture("metallicRoughnessTexture", p.metallic_roughness_texture)),  //
+                    "pbrMetallicRoughness"),                                                          //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        p.dest->materials.emplace_back(std::move(p.name_str),
+                                                    pbr_metallic_roughness{p.color, std::move(p.base_color_texture), p.fac1, p.fac2,
+                                                                           std::move(p.metallic_roughness_texture)},
+                                                    std::move(p.normal_texture), std::move(p.occlusion_texture),
+                                                    std::move(p.emissive_texture), p.translation,
+                                                    static_cast<alpha_mode_type>(p.id3_nd), p.alpha_cut_off, p.flag1);
+                        notify(p.listener, p.dest->materials, &doc_listener::on_material);
+                        p.reset_parse_state();
+                    })),                                                  //
+            key(parse_options::materials, "materials")),                  //
+        a::path(                                                          //
+            a::all(                                                       //
+                a::path(assign_string(p.name_str), name_key),             //
+                a::path(assign_numeric(p.f_numbers1), "weights"),         //
                 a::path(                                                  //
                     a::all(                                               //
-                        a::path(a::assign_numeric(p.id1), "byteLength"),  //
-                        a::path(a::assign_string(p.name_str), "uri"),     //
+                        a::path(parse_attributes(p.attribute_data), "attributes"),  //
+                        a::path(a::assign_numeric(p.id1), "indices"),               //
+                        a::path(a::assign_numeric(p.id2), "material"),              //
+                        a::path(a::assign_numeric(p.draw_mode), "mode"),            //
+                        a::path(                                                    //
+                            a::all(parse_attributes(p.target_data),
+                                   a::on_array_element([&p](auto const&) { p.targets.push_back(std::move(p.target_data)); })),
+                            "targets"),  //
                         a::on_array_element(
-                            [&](auto const&)
+                            [&p](auto const&)
                             {
-                                if (p.name_str.empty())
-                                {
-                                    dest.buffers.emplace_back(infile_buffer{static_cast<uint32_t>(p.id1)});
-                                    p.reset_ids();
-                                }
-                                else
-                                {
-                                    dest.buffers.emplace_back(external_buffer{static_cast<uint32_t>(p.id1), p.name_str});
-                                    p.reset_ids();
-                                    p.name_str.clear();
-                                }
-                            })),  //
-                    "buffers"))](std::span<char const> const& buf) mutable
+                                auto att_flags = static_cast<attribute_flag>(std::accumulate(
+                                    p.attribute_data.begin(), p.attribute_data.end(), uint32_t{0},
+                                    [](uint32_t fl, auto const& i) { return fl | attribute_bit(tiny_tuple::get<0>(i)); }));
+
+                                p.primitives.emplace_back(std::move(p.attribute_data), p.id1, p.id2,
+                                                          static_cast<mode_type>(p.draw_mode), att_flags, std::move(p.targets));
+                                p.id1 = p.id2 = -1;
+                                p.draw_mode   = 4;
+                            })),    //
+                    "primitives"),  //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        p.dest->meshes.emplace_back(std::move(p.name_str), std::move(p.primitives), std::move(p.f_numbers1));
+                        notify(p.listener, p.dest->meshes, &doc_listener::on_mesh);
+                        p.reset_parse_state();
+                    })),  //
+            key(parse_options::meshes, "meshes")),
+        a::path(                                                           //
+            a::all(                                                        //
+                a::path(assign_string(p.name_str), name_key),              //
+                a::path(a::assign_numeric(p.id1), "inverseBindMatrices"),  //
+                a::path(a::assign_numeric(p.id2), "skeleton"),             //
+                a::path(assign_numeric(p.u_numbers), "joints"),            //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        p.dest->skins.emplace_back(std::move(p.name_str), p.id2, p.id1, std::move(p.u_numbers));
+                        notify(p.listener, p.dest->skins, &doc_listener::on_skin);
+                        p.reset_parse_state();
+                    })),  //
+            key(parse_options::skins, "skins")),
+        a::path(                                                                                          //
+            a::all(                                                                                       //
+                a::path(a::assign_numeric(p.id1), "bufferView"),                                          //
+                a::path(a::assign_numeric(p.id3_nd), "byteOffset"),                                       //
+                a::path(a::assign_numeric(p.id2), "count"),                                               //
+                a::path(a::assign_numeric(p.id4), "componentType"),                                       //
+                a::path(resolve_type(p.id5), "type"),                                                     //
+                a::path(a::assign_numeric(p.flag1), "normalized"),                                        //
+                a::path(assign_numeric(p.f_numbers1), "max"),                                             //
+                a::path(assign_numeric(p.f_numbers2), "min"),                                             //
+                a::path(a::assign_numeric(p.sparse.count), "sparse", "count"),                            //
+                a::path(a::assign_numeric(p.sparse.indices_view), "sparse", "indices", "bufferView"),     //
+                a::path(a::assign_numeric(p.sparse.indices_offset), "sparse", "indices", "byteOffset"),   //
+                a::path(a::assign_numeric(p.sparse_indices_type), "sparse", "indices", "componentType"),  //
+                a::path(a::assign_numeric(p.sparse.values_view), "sparse", "values", "bufferView"),       //
+                a::path(a::assign_numeric(p.sparse.values_offset), "sparse", "values", "byteOffset"),     //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        // TODO error handling component type valid, type string valid, max min same size.. and correct count
+                        // i.e. if type is MAT3 - it must be nine
+                        p.sparse.indices_type = static_cast<component>(p.sparse_indices_type);
+                        p.dest->accessors.emplace_back(p.id1, p.id3_nd, p.id2, static_cast<component>(p.id4),
+                                                    static_cast<attribute_type>(p.id5), p.flag1, std::move(p.f_numbers1),
+                                                    std::move(p.f_numbers2), p.sparse);
+                        notify(p.listener, p.dest->accessors, &doc_listener::on_accessor);
+                        p.reset_parse_state();
+                    })),  //
+            key(parse_options::accessors, "accessors")),
+        a::path(                                                  //
+            a::all(                                               //
+                a::path(assign_uri(nullptr), "uri"),              //
+                a::path(assign_string(p.mime), "mime"),           //
+                a::path(assign_string(p.name_str), name_key),     //
+                a::path(a::assign_numeric(p.id1), "bufferView"),  //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        if (p.uri_state == uri_kind::base64)
+                        {
+                            // the mime type from data:image/png;base64
+                            p.uri.resize(p.uri.size() - std::string_view(";base64").size());
+                            p.uri.erase(0, std::string_view("data:").size());
+                            p.dest->images.emplace_back(embedded_image{std::move(p.name_str), std::move(p.uri), std::move(p.embedded)});
+                        }
+                        else if (p.id1 == -1)
+                            p.dest->images.emplace_back(external_image{std::move(p.name_str), std::move(p.uri)});
+                        else
+                            p.dest->images.emplace_back(infile_image{std::move(p.name_str), std::move(p.mime), p.id1});
+                        notify(p.listener, p.dest->images, &doc_listener::on_image);
+                        p.reset_ids();
+                        p.reset_uri();
+                        p.mime.clear();
+                        p.name_str.clear();
+                    })),  //
+            key(parse_options::images, "images")),
+        a::path(                                               //
+            a::all(                                            //
+                a::path(a::assign_numeric(p.id1), "sampler"),  //
+                a::path(a::assign_numeric(p.id2), "source"),   //
+                a::path(assign_string(p.name_str), name_key),  //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        p.dest->textures.emplace_back(p.id1, p.id2, std::move(p.name_str));
+                        notify(p.listener, p.dest->textures, &doc_listener::on_texture);
+                        p.reset_ids();
+                        p.name_str.clear();
+                    })),  //
+            key(parse_options::textures, "textures")),
+        a::path(                                                 //
+            a::all(                                              //
+                a::path(a::assign_numeric(p.id1), "magFilter"),  //
+                a::path(a::assign_numeric(p.id2), "minFilter"),  //
+                a::path(a::assign_numeric(p.wrap_s), "wrapS"),   //
+                a::path(a::assign_numeric(p.wrap_t), "wrapT"),   //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        // TODO check values
+                        p.dest->samplers.emplace_back(p.id1, p.id2, p.wrap_s, p.wrap_t);
+                        notify(p.listener, p.dest->samplers, &doc_listener::on_sampler);
+                        p.reset_ids();
+                    })),  //
+            key(parse_options::samplers, "samplers")),
+        a::path(                                                                                             //
+            a::all(                                                                                          //
+                a::path(a::assign_numeric(p.id1), "buffer"),                                                 //
+                a::path(a::assign_numeric(p.id2), "byteLength"),                                             //
+                a::path(a::assign_numeric(p.id3_nd), "byteOffset"),                                          //
+                a::path(a::assign_numeric(p.id4), "byteStride"),                                             //
+                a::path(a::assign_numeric(p.id5), "target"),                                                 //
+                a::path(a::assign_numeric(p.meshopt.buffer), "extensions", meshopt_ext, "buffer"),           //
+                a::path(a::assign_numeric(p.meshopt.offset), "extensions", meshopt_ext, "byteOffset"),       //
+                a::path(a::assign_numeric(p.meshopt.length), "extensions", meshopt_ext, "byteLength"),       //
+                a::path(a::assign_numeric(p.meshopt.stride), "extensions", meshopt_ext, "byteStride"),       //
+                a::path(a::assign_numeric(p.meshopt.count), "extensions", meshopt_ext, "count"),             //
+                a::path(resolve_meshopt_mode(p.compression_mode), "extensions", meshopt_ext, "mode"),        //
+                a::path(resolve_meshopt_filter(p.compression_filter), "extensions", meshopt_ext, "filter"),  //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        // stride 0 means tightly packed elements
+                        p.meshopt.mode   = static_cast<meshopt_mode>(p.compression_mode);
+                        p.meshopt.filter = static_cast<meshopt_filter>(p.compression_filter);
+                        p.dest->buffer_views.emplace_back(p.id1, p.id2, p.id3_nd, std::max(p.id4, 0), std::max(p.id5, 0), p.meshopt);
+                        notify(p.listener, p.dest->buffer_views, &doc_listener::on_buffer_view);
+                        p.reset_parse_state();
+                    })),  //
+            key(parse_options::buffer_views, "bufferViews")),
+        a::path(                                                  //
+            a::all(                                               //
+                a::path(a::assign_numeric(p.id1), "byteLength"),  //
+                a::path(assign_uri(&p.id1), "uri"),               //
+                a::on_array_element(
+                    [&p](auto const&)
+                    {
+                        if (p.uri_state == uri_kind::base64)
+                            p.dest->buffers.emplace_back(embedded_buffer{static_cast<uint32_t>(p.id1), std::move(p.embedded)});
+                        else if (p.uri.empty())
+                            p.dest->buffers.emplace_back(infile_buffer{static_cast<uint32_t>(p.id1), {}});
+                        else
+                            p.dest->buffers.emplace_back(external_buffer{static_cast<uint32_t>(p.id1), std::move(p.uri), {}});
+                        p.reset_ids();
+                        p.reset_uri();
+                        notify(p.listener, p.dest->buffers, &doc_listener::on_buffer);
+                    })),  //
+            key(parse_options::buffers, "buffers")));
+}
+
+// Parser state and extractor in one place, the extractor refers into *p.
+template <typename Stats>
+class parser_state
+{
+   public:
+    parser_state(doc& dest, doc_listener* listener, Stats stats, parse_options options)
+        : p{std::make_unique<internal_state<Stats>>(dest.resource())}, options{options}
     {
-        extractor.parse_bytes(std::string_view(buf.data(), buf.size()));
-        return parse_state::more_input_needed;
-    };
+        p->dest     = &dest;
+        p->listener = listener;
+        p->stats.emplace(std::move(stats));
+        extractor.emplace(build_extractor(*p, options));
+    }
+    parser_state(parser_state const&) = delete;
+    parser_state& operator=(parser_state const&) = delete;
+
+    parse_state operator()(std::span<char const> const& buf)
+    {
+        p->stats->begin_chunk(buf.size());
+        if (!p->failed) extractor->parse_bytes(std::string_view(buf.data(), buf.size()));
+        p->stats->end_chunk(*p->dest);
+        if (p->failed) return parse_state::error;
+        return p->complete ? parse_state::json_complete : parse_state::more_input_needed;
+    }
+
+    // Continues with the next json document into dest. The scratch containers keep their capacity as long as dest
+    // uses the same memory resource as the previous doc. async_json offers no way to reset the lexer of an
+    // extractor, so the extractor is still built anew.
+    void reset(doc& dest)
+    {
+        auto* const listener = p->listener;
+        if (dest.resource() != p->name_str.get_allocator().resource())
+        {
+            // the containers cannot change their resource, a new state is made before the old one is let go
+            auto fresh = std::make_unique<internal_state<Stats>>(dest.resource());
+            fresh->stats.emplace();
+            extractor.reset();
+            p = std::move(fresh);
+        }
+        else
+            p->restart();
+        p->dest     = &dest;
+        p->listener = listener;
+        extractor.emplace(build_extractor(*p, options));
+    }
+
+    doc& destination() const noexcept { return *p->dest; }
+
+   private:
+    std::unique_ptr<internal_state<Stats>>                                                  p;
+    parse_options                                                                           options;
+    std::optional<decltype(build_extractor(std::declval<internal_state<Stats>&>(), parse_options::all))> extractor;
+};
+
+template <typename Stats>
+std::function<parse_state(std::span<char const> const&)> make_parser(doc& dest, doc_listener* listener, Stats stats, parse_options options)
+{
+    auto state = std::make_shared<parser_state<Stats>>(dest, listener, std::move(stats), options);
+    return [state](std::span<char const> const& buf) { return (*state)(buf); };
 }
+}  // namespace
+}  // namespace trivial_gltf
+
+std::function<trivial_gltf::parse_state(std::span<char const> const&)> trivial_gltf::create_parser(doc& dest, parse_options options)
+{
+    return make_parser(dest, nullptr, no_stats{}, options);
+}
+
+std::function<trivial_gltf::parse_state(std::span<char const> const&)> trivial_gltf::create_parser(doc&          dest,
+                                                                                                    doc_listener& listener,
+                                                                                                    parse_options options)
+{
+    return make_parser(dest, &listener, no_stats{}, options);
+}
+
+std::function<trivial_gltf::parse_state(std::span<char const> const&)> trivial_gltf::create_parser(doc& dest, parse_stats& stats,
+                                                                                                    parse_options options)
+{
+    return make_parser(dest, nullptr, collecting_stats{stats, dest}, options);
+}
+
+std::function<trivial_gltf::parse_state(std::span<char const> const&)> trivial_gltf::create_parser(doc&          dest,
+                                                                                                    doc_listener& listener,
+                                                                                                    parse_stats&  stats,
+                                                                                                    parse_options options)
+{
+    return make_parser(dest, &listener, collecting_stats{stats, dest}, options);
+}
+
+struct trivial_gltf::parser::impl : parser_state<no_stats>
+{
+    using parser_state::parser_state;
+};
+
+trivial_gltf::parser::parser(doc& destination, parse_options options)
+    : state{std::make_unique<impl>(destination, nullptr, no_stats{}, options)}
+{
+}
+
+trivial_gltf::parser::parser(doc& destination, doc_listener& listener, parse_options options)
+    : state{std::make_unique<impl>(destination, &listener, no_stats{}, options)}
+{
+}
+
+trivial_gltf::parser::parser(parser&&) noexcept = default;
+trivial_gltf::parser& trivial_gltf::parser::operator=(parser&&) noexcept = default;
+trivial_gltf::parser::~parser()                                          = default;
+
+trivial_gltf::parse_state trivial_gltf::parser::operator()(std::span<char const> const& bytes) { return (*state)(bytes); }
+void                      trivial_gltf::parser::reset(doc& destination) { state->reset(destination); }
+trivial_gltf::doc&        trivial_gltf::parser::destination() const noexcept { return state->destination(); }
@@ -45,4 +45,30 @@ constexpr auto assign_numeric(glm::vec<I, T, Q>& ref)
     };
 }
 
+// strings and number lists of the doc come from its memory resource, which async_json does not know about
+template <typename T>
+constexpr auto assign_numeric(std::pmr::vector<T>& ref)
+{
+    return [&ref](auto const& ev)
+    {
+        switch (ev.value_type())
+        {
+            case async_json::saj_variant_value::float_number: ref.push_back(static_cast<T>(ev.as_float_number())); break;
+            case async_json::saj_variant_value::number: ref.push_back(static_cast<T>(ev.as_number())); break;
+            default: break;
+        }
+    };
+}
+
+constexpr auto assign_string(std::pmr::string& ref)
+{
+    return [&ref](auto const& ev)
+    {
+        if (ev.event == async_json::saj_event::string_value_start)
+            ref.assign(ev.as_string_view());
+        else if (ev.event == async_json::saj_event::string_value_cont)
+            ref.append(ev.as_string_view());
+    };
+}
+
 }  // namespace gltf
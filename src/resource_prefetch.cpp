@@ -0,0 +1,147 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/mapped_asset.h>
+#include <trivial_gltf/resource_prefetch.h>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TRIVIAL_GLTF_POSIX_FILES 1
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#else
+#include <fstream>
+#endif
+
+namespace trivial_gltf
+{
+bool file_fetcher::fetch(std::string_view uri, std::vector<std::byte>& contents)
+{
+#if TRIVIAL_GLTF_POSIX_FILES
+    int fd = ::open(resolve_uri(base, uri).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    bool        ok = ::fstat(fd, &st) == 0;
+    if (ok) contents.resize(static_cast<size_t>(st.st_size));
+    for (size_t done = 0; ok && done != contents.size();)
+    {
+        auto const n = ::pread(fd, contents.data() + done, contents.size() - done, static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR) continue;
+        ok = n > 0;
+        if (ok) done += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    return ok;
+#else
+    std::ifstream in(resolve_uri(base, uri), std::ios::binary | std::ios::ate);
+    auto const    end = in ? static_cast<std::streamoff>(in.tellg()) : std::streamoff{-1};
+    if (end < 0 || !in.seekg(0)) return false;
+    contents.resize(static_cast<size_t>(end));
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(contents.data()), end));
+#endif
+}
+
+resource_prefetcher::resource_prefetcher(resource_fetcher& fetcher, size_t threads) : fetcher{fetcher}
+{
+    this->threads.reserve(std::max<size_t>(threads, 1));
+    for (size_t t = 0; t != std::max<size_t>(threads, 1); ++t) this->threads.emplace_back([this] { worker_loop(); });
+}
+
+resource_prefetcher::~resource_prefetcher()
+{
+    {
+        std::lock_guard<std::mutex> guard(control);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void resource_prefetcher::on_buffer(size_t index, buffer const& b)
+{
+    auto const* ext = std::get_if<external_buffer>(&b);
+    if (!ext || ext->uri.starts_with("data:")) return;
+    std::lock_guard<std::mutex> guard(control);
+    if (buffer_resources.size() <= index) buffer_resources.resize(index + 1, nullptr);
+    buffer_resources[index] = request(ext->uri);
+}
+
+void resource_prefetcher::on_image(size_t index, image const& i)
+{
+    auto const* ext = std::get_if<external_image>(&i);
+    if (!ext || ext->uri.starts_with("data:")) return;
+    std::lock_guard<std::mutex> guard(control);
+    if (image_resources.size() <= index) image_resources.resize(index + 1, nullptr);
+    image_resources[index] = request(ext->uri);
+}
+
+// with control held
+resource_prefetcher::resource* resource_prefetcher::request(std::string_view uri)
+{
+    for (auto& r : resources)
+        if (r.uri == uri) return &r;
+    auto& r = resources.emplace_back();
+    r.uri   = uri;
+    queue.push_back(&r);
+    ++pending;
+    wake.notify_one();
+    return &r;
+}
+
+void resource_prefetcher::worker_loop()
+{
+    std::unique_lock<std::mutex> lock(control);
+    for (;;)
+    {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) return;
+        auto* r = queue.front();
+        queue.pop_front();
+        lock.unlock();
+        std::vector<std::byte> contents;
+        bool const             loaded = fetcher.fetch(r->uri, contents);
+        lock.lock();
+        r->contents = std::move(contents);
+        r->loaded   = loaded;
+        if (--pending == 0) finished.notify_all();
+    }
+}
+
+void resource_prefetcher::wait()
+{
+    std::unique_lock<std::mutex> lock(control);
+    finished.wait(lock, [this] { return pending == 0; });
+}
+
+size_t resource_prefetcher::bind(doc& d)
+{
+    wait();
+    std::lock_guard<std::mutex> guard(control);
+    size_t                      failed = 0;
+    for (size_t i = 0; i != buffer_resources.size() && i != d.buffers.size(); ++i)
+    {
+        auto* ext = std::get_if<external_buffer>(&d.buffers[i]);
+        auto* r   = buffer_resources[i];
+        if (!ext || !r) continue;
+        if (!r->loaded || r->contents.size() < ext->byte_length)
+        {
+            ++failed;
+            continue;
+        }
+        ext->data = std::span<std::byte const>(r->contents).first(ext->byte_length);
+    }
+    return failed;
+}
+
+std::span<std::byte const> resource_prefetcher::image_data(size_t image) const noexcept
+{
+    std::lock_guard<std::mutex> guard(control);
+    if (image >= image_resources.size() || !image_resources[image] || !image_resources[image]->loaded) return {};
+    return image_resources[image]->contents;
+}
+}  // namespace trivial_gltf
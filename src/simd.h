@@ -0,0 +1,22 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_SIMD_H_INCLUDED
+#define TRIVIAL_GLTF_SIMD_H_INCLUDED
+
+// The vector kernels are written with the x86 intrinsics, other targets only build the scalar paths.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRIVIAL_GLTF_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace trivial_gltf
+{
+// Whether the SSSE3 kernels may run: the cpu supports them and active_simd_level() is not scalar.
+bool has_ssse3() noexcept;
+}  // namespace trivial_gltf
+
+#endif
@@ -0,0 +1,142 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/skinning.h>
+#include <trivial_gltf/thread_pool.h>
+#include <cmath>
+#include "matrix_simd.h"
+
+namespace trivial_gltf
+{
+namespace
+{
+accessor const* find_accessor(doc const& d, primitive const& p, attribute a) noexcept
+{
+    for (auto const& entry : p.attributes)
+        if (tiny_tuple::get<0>(entry) == a)
+        {
+            auto const index = tiny_tuple::get<1>(entry);
+            return index < d.accessors.size() ? &d.accessors[index] : nullptr;
+        }
+    return nullptr;
+}
+
+void build_palette(skin_instance const& instance, glm::mat4* out) noexcept
+{
+    auto const& ibm = instance.bind->inverse_bind_matrices;
+    for (size_t j = 0; j != ibm.size(); ++j)
+    {
+        auto const slot = instance.slots[j];
+        if (slot < 0)
+            out[j] = ibm[j];
+        else
+            multiply_mat4(&instance.scene->world(slot)[0][0], &ibm[j][0][0], &out[j][0][0]);
+    }
+}
+
+// weighted sum of up to four joint matrices
+void blend_joints(glm::mat4 const* palette, size_t palette_size, float const* joints, float const* weights, float* m) noexcept
+{
+#if TRIVIAL_GLTF_X86_SIMD
+    __m128 c[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+    for (int i = 0; i != 4; ++i)
+    {
+        if (weights[i] == 0.0f || !(joints[i] < static_cast<float>(palette_size))) continue;
+        auto const  w = _mm_set1_ps(weights[i]);
+        auto const* j = &palette[static_cast<size_t>(joints[i])][0][0];
+        for (int col = 0; col != 4; ++col) c[col] = _mm_add_ps(c[col], _mm_mul_ps(w, _mm_loadu_ps(j + 4 * col)));
+    }
+    for (int col = 0; col != 4; ++col) _mm_storeu_ps(m + 4 * col, c[col]);
+#else
+    std::fill(m, m + 16, 0.0f);
+    for (int i = 0; i != 4; ++i)
+    {
+        if (weights[i] == 0.0f || !(joints[i] < static_cast<float>(palette_size))) continue;
+        auto const* j = &palette[static_cast<size_t>(joints[i])][0][0];
+        for (int e = 0; e != 16; ++e) m[e] += weights[i] * j[e];
+    }
+#endif
+}
+}  // namespace
+
+skin_bind::skin_bind(doc const& d, skin const& s)
+    : joints(s.joints.begin(), s.joints.end()), inverse_bind_matrices(s.joints.size(), glm::mat4(1.0f))
+{
+    if (s.inverse_bind_matrices < 0 || static_cast<size_t>(s.inverse_bind_matrices) >= d.accessors.size()) return;
+    auto const& acc = d.accessors[s.inverse_bind_matrices];
+    if (acc.type != attribute_type::mat4 || acc.count < joints.size()) return;
+    std::vector<float> values(acc.count * 16);
+    if (decode_floats(d, acc, values) != values.size()) return;
+    for (size_t j = 0; j != joints.size(); ++j) std::copy(&values[16 * j], &values[16 * j] + 16, &inverse_bind_matrices[j][0][0]);
+}
+
+skin_instance::skin_instance(skin_bind const& source, flat_scene const& target) : bind{&source}, scene{&target}, slots(source.joints.size())
+{
+    for (size_t j = 0; j != slots.size(); ++j) slots[j] = target.slot(source.joints[j]);
+}
+
+size_t layout_palettes(std::span<skin_instance> instances) noexcept
+{
+    size_t offset = 0;
+    for (auto& instance : instances)
+    {
+        instance.palette_offset = offset;
+        offset += instance.bind->joints.size();
+    }
+    return offset;
+}
+
+void build_skin_palettes(std::span<skin_instance const> instances, std::span<glm::mat4> palette, thread_pool* pool)
+{
+    auto const build = [&](skin_instance const& instance)
+    {
+        if (instance.palette_offset + instance.slots.size() <= palette.size()) build_palette(instance, &palette[instance.palette_offset]);
+    };
+    if (pool && pool->size() > 1 && instances.size() > 1)
+        pool->for_each(instances.size(), [&](size_t i, size_t) { build(instances[i]); });
+    else
+        for (auto const& instance : instances) build(instance);
+}
+
+size_t skin_vertices(doc const& d, primitive const& p, std::span<glm::mat4 const> joint_matrices, std::span<float> positions,
+                     std::span<float> normals)
+{
+    auto const* position = find_accessor(d, p, attribute::position);
+    auto const* joints   = find_accessor(d, p, attribute::joints_0);
+    auto const* weights  = find_accessor(d, p, attribute::weights_0);
+    auto const* normal   = normals.empty() ? nullptr : find_accessor(d, p, attribute::normal);
+    if (!position || !joints || !weights || (!normals.empty() && !normal)) return 0;
+    size_t const count = position->count;
+    if (joints->count < count || weights->count < count || component_count(joints->type) != 4 || component_count(weights->type) != 4)
+        return 0;
+    if (positions.size() < 3 * count || (normal && (normals.size() < 3 * count || normal->count < count))) return 0;
+
+    // joint indices are small unsigned integers, exact as float
+    std::vector<float> joint_values(4 * joints->count);
+    std::vector<float> weight_values(4 * weights->count);
+    if (decode_floats(d, *position, positions) != 3 * count || decode_floats(d, *joints, joint_values) != joint_values.size() ||
+        decode_floats(d, *weights, weight_values) != weight_values.size() || (normal && decode_floats(d, *normal, normals) != 3 * count))
+        return 0;
+
+    float m[16];
+    for (size_t v = 0; v != count; ++v)
+    {
+        blend_joints(joint_matrices.data(), joint_matrices.size(), &joint_values[4 * v], &weight_values[4 * v], m);
+        float*      pos = &positions[3 * v];
+        float const x   = pos[0], y = pos[1], z = pos[2];
+        for (int r = 0; r != 3; ++r) pos[r] = m[r] * x + m[4 + r] * y + m[8 + r] * z + m[12 + r];
+        if (!normal) continue;
+        float*      n  = &normals[3 * v];
+        float const nx = n[0], ny = n[1], nz = n[2];
+        for (int r = 0; r != 3; ++r) n[r] = m[r] * nx + m[4 + r] * ny + m[8 + r] * nz;
+        auto const len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len > 0.0f)
+            for (int r = 0; r != 3; ++r) n[r] /= len;
+    }
+    return count;
+}
+}  // namespace trivial_gltf
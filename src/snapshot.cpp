@@ -0,0 +1,381 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/snapshot.h>
+#include <cstring>
+
+namespace trivial_gltf
+{
+namespace
+{
+constexpr char   snapshot_magic[8] = {'T', 'G', 'L', 'T', 'F', 'S', 'N', 'P'};
+constexpr size_t section_alignment = 8;
+constexpr size_t payload_alignment = 16;  // of the payload section and of every payload within it
+
+constexpr size_t record_size(snapshot_section s) noexcept
+{
+    namespace r = snapshot_record;
+    switch (s)
+    {
+        case snapshot_section::scenes: return sizeof(r::scene);
+        case snapshot_section::nodes: return sizeof(r::node);
+        case snapshot_section::meshes: return sizeof(r::mesh);
+        case snapshot_section::primitives: return sizeof(r::primitive);
+        case snapshot_section::attributes: return sizeof(r::attribute);
+        case snapshot_section::animations: return sizeof(r::animation);
+        case snapshot_section::channels: return sizeof(r::channel);
+        case snapshot_section::animation_samplers: return sizeof(r::animation_sampler);
+        case snapshot_section::materials: return sizeof(r::material);
+        case snapshot_section::accessors: return sizeof(r::accessor);
+        case snapshot_section::buffer_views: return sizeof(r::buffer_view);
+        case snapshot_section::buffers: return sizeof(r::buffer);
+        case snapshot_section::skins: return sizeof(r::skin);
+        case snapshot_section::images: return sizeof(r::image);
+        case snapshot_section::samplers: return sizeof(r::sampler);
+        case snapshot_section::textures: return sizeof(r::texture);
+        case snapshot_section::attribute_names: return sizeof(snapshot_range);
+        case snapshot_section::morph_targets: return sizeof(snapshot_range);
+        case snapshot_section::indices: return sizeof(uint32_t);
+        case snapshot_section::floats: return sizeof(float);
+        default: return 1;
+    }
+}
+
+struct snapshot_writer
+{
+    std::vector<snapshot_record::scene>             scenes;
+    std::vector<snapshot_record::node>              nodes;
+    std::vector<snapshot_record::mesh>              meshes;
+    std::vector<snapshot_record::primitive>         primitives;
+    std::vector<snapshot_record::attribute>         attributes;
+    std::vector<snapshot_record::animation>         animations;
+    std::vector<snapshot_record::channel>           channels;
+    std::vector<snapshot_record::animation_sampler> animation_samplers;
+    std::vector<snapshot_record::material>          materials;
+    std::vector<snapshot_record::accessor>          accessors;
+    std::vector<snapshot_record::buffer_view>       buffer_views;
+    std::vector<snapshot_record::buffer>            buffers;
+    std::vector<snapshot_record::skin>              skins;
+    std::vector<snapshot_record::image>             images;
+    std::vector<snapshot_record::sampler>           samplers;
+    std::vector<snapshot_record::texture>           textures;
+    std::vector<snapshot_range>                     attribute_names;
+    std::vector<snapshot_range>                     morph_targets;
+    std::vector<uint32_t>                           indices;
+    std::vector<float>                              floats;
+    std::vector<char>                               chars;
+    std::vector<std::byte>                          payload;
+
+    template <typename T>
+    static snapshot_range append(std::vector<T>& pool, std::span<T const> values)
+    {
+        snapshot_range r{static_cast<uint32_t>(pool.size()), static_cast<uint32_t>(values.size())};
+        pool.insert(pool.end(), values.begin(), values.end());
+        return r;
+    }
+    snapshot_range add(std::span<uint32_t const> v) { return append(indices, v); }
+    snapshot_range add(std::span<float const> v) { return append(floats, v); }
+    snapshot_range add(std::string_view v) { return append(chars, std::span<char const>(v.data(), v.size())); }
+
+    // payload aligned, returns the offset into the payload section
+    uint64_t add_payload(std::span<std::byte const> data)
+    {
+        auto const offset = (payload.size() + payload_alignment - 1) & ~(payload_alignment - 1);
+        payload.resize(offset);
+        payload.insert(payload.end(), data.begin(), data.end());
+        return offset;
+    }
+
+    snapshot_record::texture_info add(texture_info const& t, float value)
+    {
+        return {t.index, t.tex_coord, add(t.name), value};
+    }
+
+    template <typename T>
+    static void place(std::vector<std::byte>& image, snapshot_header& header, snapshot_section s, std::vector<T> const& records,
+                      size_t alignment = section_alignment)
+    {
+        auto const offset = (image.size() + alignment - 1) & ~(alignment - 1);
+        image.resize(offset + records.size() * sizeof(T));
+        if (!records.empty()) std::memcpy(image.data() + offset, records.data(), records.size() * sizeof(T));
+        header.sections[static_cast<size_t>(s)] = {offset, records.size()};
+    }
+};
+}  // namespace
+
+std::vector<std::byte> write_snapshot(doc const& source, bool embed_buffers)
+{
+    snapshot_writer w;
+    for (auto const& s : source.scenes) w.scenes.push_back({w.add(s.name), w.add(std::span<uint32_t const>(s.root_nodes))});
+    for (auto const& n : source.nodes)
+        w.nodes.push_back({n.mesh,
+                           n.skin,
+                           n.camera,
+                           {n.rotaton.x, n.rotaton.y, n.rotaton.z, n.rotaton.w},
+                           {n.scale[0], n.scale[1], n.scale[2]},
+                           {n.translation[0], n.translation[1], n.translation[2]},
+                           w.add(std::span<uint32_t const>(n.children)),
+                           w.add(std::span<float const>(n.weights)),
+                           w.add(n.name)});
+    for (auto const& m : source.meshes)
+    {
+        snapshot_range prims{static_cast<uint32_t>(w.primitives.size()), static_cast<uint32_t>(m.primitives.size())};
+        for (auto const& p : m.primitives)
+        {
+            auto const attribs = [&w](std::span<attribute_offset const> source)
+            {
+                snapshot_range r{static_cast<uint32_t>(w.attributes.size()), static_cast<uint32_t>(source.size())};
+                for (auto const& a : source)
+                    w.attributes.push_back({static_cast<uint32_t>(tiny_tuple::get<0>(a)), static_cast<uint32_t>(tiny_tuple::get<1>(a))});
+                return r;
+            };
+            snapshot_range targets{static_cast<uint32_t>(w.morph_targets.size()), static_cast<uint32_t>(p.targets.size())};
+            for (auto const& t : p.targets) w.morph_targets.push_back(attribs(t));
+            w.primitives.push_back(
+                {attribs(p.attributes), p.indices, p.material, static_cast<uint32_t>(p.mode), static_cast<uint32_t>(p.flags), targets});
+        }
+        w.meshes.push_back({w.add(m.name), prims, w.add(std::span<float const>(m.weights))});
+    }
+    for (auto const& a : source.animations)
+    {
+        snapshot_range chans{static_cast<uint32_t>(w.channels.size()), static_cast<uint32_t>(a.channels.size())};
+        for (auto const& c : a.channels) w.channels.push_back({c.sampler_id, c.node_id, static_cast<uint32_t>(c.path)});
+        snapshot_range samps{static_cast<uint32_t>(w.animation_samplers.size()), static_cast<uint32_t>(a.samplers.size())};
+        for (auto const& s : a.samplers) w.animation_samplers.push_back({s.input, s.output, static_cast<uint32_t>(s.interpolation)});
+        w.animations.push_back({w.add(a.name), chans, samps});
+    }
+    for (auto const& m : source.materials)
+    {
+        auto const& pbr = m.data;
+        w.materials.push_back({w.add(m.name),
+                               {pbr.base_color_factor[0], pbr.base_color_factor[1], pbr.base_color_factor[2], pbr.base_color_factor[3]},
+                               w.add(pbr.base_color_texture, 0.0f),
+                               pbr.metallic_factor,
+                               pbr.roughness_factor,
+                               w.add(pbr.metallic_roughness_texture, 0.0f),
+                               w.add(m.normal, m.normal.scale),
+                               w.add(m.occlusion, m.occlusion.strength),
+                               w.add(m.emissive, 0.0f),
+                               {m.emssive_factor[0], m.emssive_factor[1], m.emssive_factor[2]},
+                               static_cast<uint32_t>(m.alpha_mode),
+                               m.alpha_cut_off,
+                               m.double_sided});
+    }
+    for (auto const& a : source.accessors)
+        w.accessors.push_back({a.view, a.offset, a.count, static_cast<uint16_t>(a.comp_type), static_cast<uint8_t>(a.type), a.normalized,
+                               w.add(std::span<float const>(a.max)), w.add(std::span<float const>(a.min)), a.sparse.count,
+                               a.sparse.indices_view, a.sparse.indices_offset, static_cast<uint32_t>(a.sparse.indices_type),
+                               a.sparse.values_view, a.sparse.values_offset});
+    for (auto const& v : source.buffer_views)
+        w.buffer_views.push_back({v.buffer, v.length, v.offset, v.stride, v.target, v.meshopt.buffer, v.meshopt.offset, v.meshopt.length,
+                                  v.meshopt.stride, v.meshopt.count, static_cast<uint8_t>(v.meshopt.mode),
+                                  static_cast<uint8_t>(v.meshopt.filter), 0});
+    for (size_t i = 0; i != source.buffers.size(); ++i)
+    {
+        auto const&             b = source.buffers[i];
+        snapshot_record::buffer rec{};
+        auto const              data = buffer_data(source, i);
+        rec.byte_length              = std::visit([](auto const& b) { return b.byte_length; }, b);
+        if (auto const* ext = std::get_if<external_buffer>(&b))
+        {
+            rec.uri      = w.add(ext->uri);
+            rec.external = 1;
+        }
+        // decoded data uris exist nowhere else and are always kept
+        if (std::holds_alternative<embedded_buffer>(b)) rec.external = 2;
+        if ((embed_buffers || rec.external == 2) && !data.empty())
+        {
+            rec.payload_offset = w.add_payload(data);
+            rec.payload_size   = data.size();
+        }
+        w.buffers.push_back(rec);
+    }
+    for (auto const& s : source.skins)
+        w.skins.push_back({w.add(s.name), s.skeleton, s.inverse_bind_matrices, w.add(std::span<uint32_t const>(s.joints))});
+    for (auto const& i : source.images)
+    {
+        if (auto const* ext = std::get_if<external_image>(&i))
+            w.images.push_back({1, -1, w.add(ext->name), w.add(ext->uri), 0, 0});
+        else if (auto const* in = std::get_if<infile_image>(&i))
+            w.images.push_back({0, in->buffer_view, w.add(in->name), w.add(in->mime), 0, 0});
+        else if (auto const* em = std::get_if<embedded_image>(&i))
+            w.images.push_back({2, -1, w.add(em->name), w.add(em->mime), w.add_payload(em->bytes), em->bytes.size()});
+    }
+    for (auto const& s : source.samplers) w.samplers.push_back({s.min_filter, s.mag_filter, s.wrap_s, s.wrap_t});
+    for (auto const& t : source.textures) w.textures.push_back({t.sampler, t.source, w.add(t.name)});
+    for (auto const& n : source.extended_attributes) w.attribute_names.push_back(w.add(n));
+
+    std::vector<std::byte> image(sizeof(snapshot_header));
+    snapshot_header        header{};
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.flags   = embed_buffers ? 1 : 0;
+    w.place(image, header, snapshot_section::scenes, w.scenes);
+    w.place(image, header, snapshot_section::nodes, w.nodes);
+    w.place(image, header, snapshot_section::meshes, w.meshes);
+    w.place(image, header, snapshot_section::primitives, w.primitives);
+    w.place(image, header, snapshot_section::attributes, w.attributes);
+    w.place(image, header, snapshot_section::animations, w.animations);
+    w.place(image, header, snapshot_section::channels, w.channels);
+    w.place(image, header, snapshot_section::animation_samplers, w.animation_samplers);
+    w.place(image, header, snapshot_section::materials, w.materials);
+    w.place(image, header, snapshot_section::accessors, w.accessors);
+    w.place(image, header, snapshot_section::buffer_views, w.buffer_views);
+    w.place(image, header, snapshot_section::buffers, w.buffers);
+    w.place(image, header, snapshot_section::skins, w.skins);
+    w.place(image, header, snapshot_section::images, w.images);
+    w.place(image, header, snapshot_section::samplers, w.samplers);
+    w.place(image, header, snapshot_section::textures, w.textures);
+    w.place(image, header, snapshot_section::attribute_names, w.attribute_names);
+    w.place(image, header, snapshot_section::morph_targets, w.morph_targets);
+    w.place(image, header, snapshot_section::indices, w.indices);
+    w.place(image, header, snapshot_section::floats, w.floats);
+    w.place(image, header, snapshot_section::chars, w.chars);
+    w.place(image, header, snapshot_section::payload, w.payload, payload_alignment);
+    header.size = image.size();
+    std::memcpy(image.data(), &header, sizeof(header));
+    return image;
+}
+
+snapshot_view::snapshot_view(std::span<std::byte const> image) noexcept
+{
+    auto const* h = reinterpret_cast<snapshot_header const*>(image.data());
+    if (image.size() < sizeof(snapshot_header) || reinterpret_cast<uintptr_t>(image.data()) % section_alignment != 0) return;
+    if (std::memcmp(h->magic, snapshot_magic, sizeof(snapshot_magic)) != 0 || h->version != snapshot_version || h->size > image.size())
+        return;
+    for (size_t i = 0; i != snapshot_section_count; ++i)
+    {
+        auto const& sec = h->sections[i];
+        auto const  rs  = record_size(static_cast<snapshot_section>(i));
+        if (sec.offset % section_alignment != 0 || sec.offset > h->size || sec.count > (h->size - sec.offset) / rs) return;
+    }
+    if (h->sections[static_cast<size_t>(snapshot_section::payload)].offset % payload_alignment != 0) return;
+    bytes  = image;
+    header = h;
+}
+
+std::span<std::byte const> snapshot_view::payload(uint64_t offset, uint64_t size) const noexcept
+{
+    auto const all = records<std::byte>(snapshot_section::payload);
+    if (size == 0 || offset > all.size() || size > all.size() - offset) return {};
+    return all.subspan(offset, size);
+}
+
+parse_state load_snapshot(snapshot_view const& s, doc& dest)
+{
+    if (!s.valid()) return parse_state::error;
+    auto* const res  = dest.resource();
+    auto        str  = [&s, res](snapshot_range r) { return std::pmr::string(s.string(r), res); };
+    auto        u32s = [&s, res](snapshot_range r)
+    {
+        auto v = s.indices(r);
+        return std::pmr::vector<uint32_t>(v.begin(), v.end(), res);
+    };
+    auto f32s = [&s, res](snapshot_range r)
+    {
+        auto v = s.floats(r);
+        return std::pmr::vector<float>(v.begin(), v.end(), res);
+    };
+    auto bytes = [res](std::span<std::byte const> v) { return std::pmr::vector<std::byte>(v.begin(), v.end(), res); };
+    auto tex   = [&str](snapshot_record::texture_info const& t) { return texture_info{t.index, t.tex_coord, str(t.name)}; };
+
+    dest.scenes.reserve(s.scenes().size());
+    for (auto const& r : s.scenes()) dest.scenes.emplace_back(str(r.name), u32s(r.root_nodes));
+    dest.nodes.reserve(s.nodes().size());
+    for (auto const& r : s.nodes())
+        dest.nodes.emplace_back(r.mesh, r.skin, r.camera, glm::qua<float>(r.rotation[3], r.rotation[0], r.rotation[1], r.rotation[2]),
+                                glm::vec<3, float>(r.scale[0], r.scale[1], r.scale[2]),
+                                glm::vec<3, float>(r.translation[0], r.translation[1], r.translation[2]), u32s(r.children),
+                                f32s(r.weights), str(r.name));
+    dest.meshes.reserve(s.meshes().size());
+    for (auto const& r : s.meshes())
+    {
+        std::pmr::vector<primitive> prims(res);
+        prims.reserve(r.primitives.count);
+        for (auto const& p : s.primitives(r.primitives))
+        {
+            auto const attribs = [&s, res](snapshot_range r)
+            {
+                std::pmr::vector<attribute_offset> result(res);
+                result.reserve(r.count);
+                for (auto const& a : s.attributes(r)) result.emplace_back(static_cast<attribute>(a.semantic), a.accessor);
+                return result;
+            };
+            std::pmr::vector<morph_target> targets(res);
+            targets.reserve(p.targets.count);
+            for (auto const& t : s.morph_targets(p.targets)) targets.push_back(attribs(t));
+            prims.emplace_back(attribs(p.attributes), p.indices, p.material, static_cast<mode_type>(p.mode),
+                               static_cast<attribute_flag>(p.flags), std::move(targets));
+        }
+        dest.meshes.emplace_back(str(r.name), std::move(prims), f32s(r.weights));
+    }
+    dest.animations.reserve(s.animations().size());
+    for (auto const& r : s.animations())
+    {
+        std::pmr::vector<channel>           chans(res);
+        std::pmr::vector<animation_sampler> samps(res);
+        for (auto const& c : s.channels(r.channels)) chans.emplace_back(c.sampler_id, c.node_id, static_cast<path_type>(c.path));
+        for (auto const& a : s.animation_samplers(r.samplers))
+            samps.emplace_back(a.input, a.output, static_cast<interpolation_type>(a.interpolation));
+        dest.animations.emplace_back(str(r.name), std::move(chans), std::move(samps));
+    }
+    dest.materials.reserve(s.materials().size());
+    for (auto const& r : s.materials())
+    {
+        normal_texture_info    normal{tex(r.normal), r.normal.value};
+        occlusion_texture_info occlusion{tex(r.occlusion), r.occlusion.value};
+        auto const&            c = r.base_color_factor;
+        dest.materials.emplace_back(
+            str(r.name),
+            pbr_metallic_roughness{glm::vec<4, float>(c[0], c[1], c[2], c[3]), tex(r.base_color_texture), r.metallic_factor,
+                                   r.roughness_factor, tex(r.metallic_roughness_texture)},
+            normal, occlusion, tex(r.emissive), glm::vec<3, float>(r.emissive_factor[0], r.emissive_factor[1], r.emissive_factor[2]),
+            static_cast<alpha_mode_type>(r.alpha_mode), r.alpha_cut_off, r.double_sided != 0);
+    }
+    dest.accessors.reserve(s.accessors().size());
+    for (auto const& r : s.accessors())
+        dest.accessors.emplace_back(r.view, r.offset, r.count, static_cast<component>(r.comp_type), static_cast<attribute_type>(r.type),
+                                    r.normalized != 0, f32s(r.max), f32s(r.min),
+                                    sparse_accessor{r.sparse_count, r.sparse_indices_view, r.sparse_indices_offset,
+                                                    static_cast<component>(r.sparse_indices_type), r.sparse_values_view,
+                                                    r.sparse_values_offset});
+    dest.buffer_views.reserve(s.buffer_views().size());
+    for (auto const& r : s.buffer_views())
+        dest.buffer_views.emplace_back(r.buffer, r.length, r.offset, r.stride, r.target,
+                                       meshopt_compression{r.meshopt_buffer, r.meshopt_offset, r.meshopt_length, r.meshopt_stride,
+                                                           r.meshopt_count, static_cast<meshopt_mode>(r.meshopt_mode),
+                                                           static_cast<meshopt_filter>(r.meshopt_filter)});
+    dest.buffers.reserve(s.buffers().size());
+    for (auto const& r : s.buffers())
+    {
+        if (r.external == 2)
+            dest.buffers.emplace_back(embedded_buffer{r.byte_length, bytes(s.payload(r))});
+        else if (r.external)
+            dest.buffers.emplace_back(external_buffer{r.byte_length, str(r.uri), s.payload(r)});
+        else
+            dest.buffers.emplace_back(infile_buffer{r.byte_length, s.payload(r)});
+    }
+    dest.skins.reserve(s.skins().size());
+    for (auto const& r : s.skins()) dest.skins.emplace_back(str(r.name), r.skeleton, r.inverse_bind_matrices, u32s(r.joints));
+    dest.images.reserve(s.images().size());
+    for (auto const& r : s.images())
+    {
+        if (r.external == 2)
+            dest.images.emplace_back(embedded_image{str(r.name), str(r.uri_or_mime), bytes(s.payload(r))});
+        else if (r.external)
+            dest.images.emplace_back(external_image{str(r.name), str(r.uri_or_mime)});
+        else
+            dest.images.emplace_back(infile_image{str(r.name), str(r.uri_or_mime), r.buffer_view});
+    }
+    dest.samplers.reserve(s.samplers().size());
+    for (auto const& r : s.samplers()) dest.samplers.emplace_back(r.min_filter, r.mag_filter, r.wrap_s, r.wrap_t);
+    dest.textures.reserve(s.textures().size());
+    for (auto const& r : s.textures()) dest.textures.emplace_back(r.sampler, r.source, str(r.name));
+    dest.extended_attributes.reserve(s.attribute_names().size());
+    for (auto const& r : s.attribute_names()) dest.extended_attributes.push_back(str(r));
+    return parse_state::json_complete;
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,135 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/thread_pool.h>
+#include <algorithm>
+#include <utility>
+
+namespace trivial_gltf
+{
+thread_pool::thread_pool(size_t workers) : queue_count{std::max<size_t>(workers, 1)}, queues{std::make_unique<range_queue[]>(queue_count)}
+{
+    threads.reserve(queue_count - 1);
+    for (size_t w = 1; w != queue_count; ++w) threads.emplace_back([this, w] { worker_loop(w); });
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> guard(control);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void thread_pool::for_each(size_t count, std::function<void(size_t index, size_t worker)> const& body)
+{
+    if (count == 0) return;
+    {
+        std::lock_guard<std::mutex> guard(control);
+        job = &body;
+        cancelled.store(false, std::memory_order_relaxed);
+        for (size_t w = 0; w != queue_count; ++w)
+        {
+            std::lock_guard<std::mutex> queue_guard(queues[w].lock);
+            queues[w].begin = w * count / queue_count;
+            queues[w].end   = (w + 1) * count / queue_count;
+        }
+        active = threads.size();
+        ++generation;
+    }
+    wake.notify_all();
+    run(0);
+
+    std::unique_lock<std::mutex> lock(control);
+    finished.wait(lock, [this] { return active == 0; });
+    job = nullptr;
+    if (auto error = std::exchange(failure, nullptr)) std::rethrow_exception(error);
+}
+
+bool thread_pool::pop(size_t worker, size_t& index) noexcept
+{
+    auto&                       q = queues[worker];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.begin == q.end || cancelled.load(std::memory_order_relaxed)) return false;
+    index = q.begin++;
+    return true;
+}
+
+bool thread_pool::steal(size_t worker) noexcept
+{
+    for (size_t i = 1; i != queue_count; ++i)
+    {
+        auto&  victim = queues[(worker + i) % queue_count];
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.begin == victim.end) continue;
+            end        = victim.end;
+            begin      = victim.begin + (victim.end - victim.begin) / 2;
+            victim.end = begin;
+        }
+        // a cancel between the two locks has already cleared the own queue, the stolen range is dropped
+        auto&                       own = queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (cancelled.load(std::memory_order_relaxed)) return false;
+        own.begin = begin;
+        own.end   = end;
+        return true;
+    }
+    return false;
+}
+
+void thread_pool::cancel(std::exception_ptr error) noexcept
+{
+    {
+        std::lock_guard<std::mutex> guard(control);
+        if (!failure) failure = std::move(error);
+    }
+    // set before the queues are cleared, so that a steal that sees a cleared queue also sees the flag
+    cancelled.store(true, std::memory_order_relaxed);
+    for (size_t w = 0; w != queue_count; ++w)
+    {
+        std::lock_guard<std::mutex> guard(queues[w].lock);
+        queues[w].begin = queues[w].end;
+    }
+}
+
+void thread_pool::run(size_t worker) noexcept
+{
+    auto const& body = *job;
+    try
+    {
+        do
+        {
+            size_t index;
+            while (pop(worker, index)) body(index, worker);
+        } while (steal(worker));
+    }
+    catch (...)
+    {
+        cancel(std::current_exception());
+    }
+}
+
+void thread_pool::worker_loop(size_t worker)
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(control);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        run(worker);
+        std::lock_guard<std::mutex> guard(control);
+        if (--active == 0) finished.notify_one();
+    }
+}
+}  // namespace trivial_gltf
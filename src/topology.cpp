@@ -0,0 +1,249 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include "simd.h"
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/thread_pool.h>
+#include <trivial_gltf/topology.h>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace trivial_gltf
+{
+namespace
+{
+constexpr uint32_t element_array_buffer = 34963;
+
+struct converted_primitive
+{
+    size_t                mesh;
+    size_t                primitive;
+    std::vector<uint32_t> indices;
+    component             type{component::unsigned_int_type};
+    size_t                offset{0};  // into the arena
+    bool                  done{false};
+};
+
+// the indices to expand, generated for non indexed primitives
+bool source_indices(doc const& d, primitive const& p, std::vector<uint32_t>& out)
+{
+    if (p.indices < 0)
+    {
+        if (p.attributes.empty() || tiny_tuple::get<1>(p.attributes.front()) >= d.accessors.size()) return false;
+        out.resize(d.accessors[tiny_tuple::get<1>(p.attributes.front())].count);
+        std::iota(out.begin(), out.end(), 0u);
+        return true;
+    }
+    if (static_cast<size_t>(p.indices) >= d.accessors.size()) return false;
+    auto const& acc = d.accessors[p.indices];
+    if (acc.type != attribute_type::scalar ||
+        (acc.comp_type != component::unsigned_byte_type && acc.comp_type != component::unsigned_short_type &&
+         acc.comp_type != component::unsigned_int_type))
+        return false;
+    out.resize(acc.count);
+    return widen_indices(d, acc, out) == acc.count;
+}
+
+#if TRIVIAL_GLTF_X86_SIMD
+// the vector loops only cover the bulk, the scalar tails take the rest, or everything at the scalar level
+bool simd_loops() noexcept { return active_simd_level() != simd_level::scalar; }
+
+__m128i load(uint32_t const* p) noexcept { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p)); }
+
+// writes the four triangles {a[k], b[k], c[k]} as twelve consecutive indices
+void store_triangles(__m128i a, __m128i b, __m128i c, uint32_t* out) noexcept
+{
+    auto const ab_lo = _mm_castsi128_ps(_mm_unpacklo_epi32(a, b));
+    auto const ab_hi = _mm_castsi128_ps(_mm_unpackhi_epi32(a, b));
+    auto const bc_lo = _mm_castsi128_ps(_mm_unpacklo_epi32(b, c));
+    auto const bc_hi = _mm_castsi128_ps(_mm_unpackhi_epi32(b, c));
+    auto const ca_lo = _mm_castsi128_ps(_mm_unpacklo_epi32(c, a));
+    auto const ca_hi = _mm_castsi128_ps(_mm_unpackhi_epi32(c, a));
+    auto*      dst   = reinterpret_cast<float*>(out);
+    _mm_storeu_ps(dst, _mm_shuffle_ps(ab_lo, ca_lo, _MM_SHUFFLE(3, 0, 1, 0)));
+    _mm_storeu_ps(dst + 4, _mm_shuffle_ps(bc_lo, ab_hi, _MM_SHUFFLE(1, 0, 3, 2)));
+    _mm_storeu_ps(dst + 8, _mm_shuffle_ps(ca_hi, bc_hi, _MM_SHUFFLE(3, 2, 3, 0)));
+}
+#endif
+}  // namespace
+
+void expand_to_list(mode_type m, std::span<uint32_t const> indices, std::vector<uint32_t>& out)
+{
+    auto const n     = indices.size();
+    auto const first = out.size();
+    switch (m)
+    {
+        case mode_type::points: out.insert(out.end(), indices.begin(), indices.end()); break;
+        case mode_type::lines: out.insert(out.end(), indices.begin(), indices.begin() + n / 2 * 2); break;
+        case mode_type::triangles: out.insert(out.end(), indices.begin(), indices.begin() + n / 3 * 3); break;
+        case mode_type::line_loop:
+        case mode_type::line_strip:
+        {
+            if (n < 2) break;
+            out.resize(first + 2 * (n - 1));
+            auto*  line = out.data() + first;
+            size_t i    = 0;
+#if TRIVIAL_GLTF_X86_SIMD
+            for (bool const simd = simd_loops(); simd && i + 5 <= n; i += 4, line += 8)
+            {
+                auto const a = load(indices.data() + i), b = load(indices.data() + i + 1);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(line), _mm_unpacklo_epi32(a, b));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(line + 4), _mm_unpackhi_epi32(a, b));
+            }
+#endif
+            for (; i + 1 < n; ++i, line += 2)
+            {
+                line[0] = indices[i];
+                line[1] = indices[i + 1];
+            }
+            if (m == mode_type::line_loop) out.insert(out.end(), {indices[n - 1], indices[0]});
+            break;
+        }
+        case mode_type::triangles_strip:
+        {
+            if (n < 3) break;
+            out.resize(first + 3 * (n - 2));
+            auto*      triangle = out.data() + first;
+            // every second triangle is flipped to keep the winding
+            auto const emit = [&](size_t i)
+            {
+                auto const a = indices[i], b = indices[i + 1 + i % 2], c = indices[i + 2 - i % 2];
+                if (a == b || b == c || c == a) return;
+                triangle[0]  = a;
+                triangle[1]  = b;
+                triangle[2]  = c;
+                triangle    += 3;
+            };
+            size_t i = 0;
+#if TRIVIAL_GLTF_X86_SIMD
+            // four triangles from an even start, one by one when a degenerate one is among them
+            for (bool const simd = simd_loops(); simd && i + 6 <= n; i += 4)
+            {
+                auto const v0 = load(indices.data() + i), v1 = load(indices.data() + i + 1), v2 = load(indices.data() + i + 2);
+                auto const b  = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(v1), _mm_castsi128_ps(v2), _MM_SHUFFLE(3, 1, 2, 0)));
+                auto const c  = _mm_shuffle_epi32(v2, _MM_SHUFFLE(2, 2, 0, 0));
+                auto const degenerate = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(v0, b), _mm_cmpeq_epi32(b, c)), _mm_cmpeq_epi32(c, v0));
+                if (_mm_movemask_epi8(degenerate))
+                    for (size_t k = 0; k != 4; ++k) emit(i + k);
+                else
+                {
+                    store_triangles(v0, b, c, triangle);
+                    triangle += 12;
+                }
+            }
+#endif
+            for (; i + 2 < n; ++i) emit(i);
+            out.resize(static_cast<size_t>(triangle - out.data()));
+            break;
+        }
+        case mode_type::triangle_fan:
+        {
+            if (n < 3) break;
+            out.resize(first + 3 * (n - 2));
+            auto*  triangle = out.data() + first;
+            size_t i        = 1;
+#if TRIVIAL_GLTF_X86_SIMD
+            auto const center = _mm_set1_epi32(static_cast<int>(indices[0]));
+            for (bool const simd = simd_loops(); simd && i + 5 <= n; i += 4, triangle += 12)
+                store_triangles(load(indices.data() + i), load(indices.data() + i + 1), center, triangle);
+#endif
+            for (; i + 1 < n; ++i, triangle += 3)
+            {
+                triangle[0] = indices[i];
+                triangle[1] = indices[i + 1];
+                triangle[2] = indices[0];
+            }
+            break;
+        }
+    }
+}
+
+void narrow_to_uint16(std::span<uint32_t const> indices, uint16_t* out) noexcept
+{
+    size_t i = 0;
+#if TRIVIAL_GLTF_X86_SIMD
+    // the signed saturating pack keeps values that were moved into the int16 range beforehand
+    auto const bias   = _mm_set1_epi32(0x8000);
+    auto const unbias = _mm_set1_epi16(-0x8000);
+    for (bool const simd = simd_loops(); simd && i + 8 <= indices.size(); i += 8)
+    {
+        auto const lo = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(indices.data() + i)), bias);
+        auto const hi = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(indices.data() + i + 4)), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi16(_mm_packs_epi32(lo, hi), unbias));
+    }
+#endif
+    for (; i != indices.size(); ++i) out[i] = static_cast<uint16_t>(indices[i]);
+}
+
+size_t normalize_topology(doc& d, std::vector<std::byte>& arena, thread_pool* pool)
+{
+    std::vector<converted_primitive> converted;
+    for (size_t m = 0; m != d.meshes.size(); ++m)
+        for (size_t i = 0; i != d.meshes[m].primitives.size(); ++i) converted.push_back({m, i, {}});
+    if (converted.empty()) return 0;
+
+    std::vector<std::vector<uint32_t>> scratch(pool ? pool->size() : 1);
+    auto const                         expand = [&](size_t i, size_t worker)
+    {
+        auto&       c = converted[i];
+        auto const& p = d.meshes[c.mesh].primitives[c.primitive];
+        if (!source_indices(d, p, scratch[worker])) return;
+        expand_to_list(p.mode, scratch[worker], c.indices);
+        if (c.indices.empty()) return;
+        // 0xffff is the primitive restart value, which gltf does not allow as an index
+        c.type = *std::max_element(c.indices.begin(), c.indices.end()) < 0xffff ? component::unsigned_short_type
+                                                                                 : component::unsigned_int_type;
+        c.done = true;
+    };
+    auto const parallel = pool && pool->size() > 1 && converted.size() > 1;
+    if (parallel)
+        pool->for_each(converted.size(), expand);
+    else
+        for (size_t i = 0; i != converted.size(); ++i) expand(i, 0);
+
+    size_t total = 0;
+    for (auto& c : converted)
+    {
+        if (!c.done) continue;
+        c.offset = total;
+        total    = (total + c.indices.size() * component_size(c.type) + 3) & ~size_t{3};
+    }
+    arena.assign(total, std::byte{0});
+    auto const store = [&](size_t i, size_t)
+    {
+        auto& c = converted[i];
+        if (!c.done) return;
+        if (c.type == component::unsigned_short_type)
+            narrow_to_uint16(c.indices, reinterpret_cast<uint16_t*>(arena.data() + c.offset));
+        else
+            std::memcpy(arena.data() + c.offset, c.indices.data(), c.indices.size() * sizeof(uint32_t));
+    };
+    if (parallel)
+        pool->for_each(converted.size(), store);
+    else
+        for (size_t i = 0; i != converted.size(); ++i) store(i, 0);
+
+    auto const buffer    = static_cast<uint32_t>(d.buffers.size());
+    auto* const resource = d.resource();
+    d.buffers.emplace_back(infile_buffer{arena.size(), std::span<std::byte const>(arena)});
+    size_t rewritten = 0;
+    for (auto const& c : converted)
+    {
+        if (!c.done) continue;
+        auto const count = static_cast<uint32_t>(c.indices.size());
+        d.buffer_views.emplace_back(buffer, static_cast<uint32_t>(count * component_size(c.type)), static_cast<uint32_t>(c.offset), 0u,
+                                    element_array_buffer, meshopt_compression{});
+        d.accessors.push_back(accessor{static_cast<uint32_t>(d.buffer_views.size() - 1), 0, count, c.type, attribute_type::scalar, false,
+                                       std::pmr::vector<float>(resource), std::pmr::vector<float>(resource), sparse_accessor{}});
+        auto& p   = d.meshes[c.mesh].primitives[c.primitive];
+        p.indices = static_cast<int32_t>(d.accessors.size() - 1);
+        p.mode    = list_mode(p.mode);
+        ++rewritten;
+    }
+    return rewritten;
+}
+}  // namespace trivial_gltf
@@ -0,0 +1,197 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <catch2/catch_test_macros.hpp>
+#include <trivial_gltf/accessor_decode.h>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace trivial_gltf;
+
+namespace
+{
+constexpr simd_level levels[] = {simd_level::scalar, simd_level::sse2, simd_level::avx2};
+constexpr component  components[] = {component::byte_type,         component::unsigned_byte_type, component::short_type,
+                                     component::unsigned_short_type, component::unsigned_int_type,  component::float_type};
+constexpr attribute_type types[]  = {attribute_type::scalar, attribute_type::vec2, attribute_type::vec3, attribute_type::vec4,
+                                     attribute_type::mat2,   attribute_type::mat3, attribute_type::mat4};
+
+// floats the conversions have to agree on, NaNs with payloads and both signs included
+std::vector<float> special_floats()
+{
+    std::vector<uint32_t> const bits = {0x7fc00000, 0xffc00000, 0x7fc12345, 0xffa00001, 0x7f800001, 0x7f800000, 0xff800000,
+                                        0x00000001, 0x80000001, 0x00800000, 0x387fe000, 0x38800000, 0x477fefff, 0x477ff000,
+                                        0x33000000, 0x33000001, 0x3f800000, 0x80000000, 0x00000000, 0x7f7fffff};
+    std::vector<float>          out(bits.size());
+    std::memcpy(out.data(), bits.data(), bits.size() * 4);
+    return out;
+}
+
+// random bytes, with the special floats spread over the float components
+std::vector<std::byte> random_bytes(size_t size, uint32_t seed)
+{
+    std::mt19937           rng(seed);
+    std::vector<std::byte> out(size);
+    for (auto& b : out) b = static_cast<std::byte>(rng());
+    auto const specials = special_floats();
+    for (size_t i = 0; i + 4 <= size; i += 4 * 7) std::memcpy(out.data() + i, &specials[i / 28 % specials.size()], 4);
+    return out;
+}
+
+// runs f once per simd level and requires bit identical results to the scalar level
+template <typename T, typename F>
+void require_identical_levels(F&& f)
+{
+    std::vector<T> reference;
+    for (auto level : levels)
+    {
+        force_simd_level(level);
+        auto const result = f();
+        if (level == simd_level::scalar)
+            reference = result;
+        else
+        {
+            REQUIRE(result.size() == reference.size());
+            REQUIRE(std::memcmp(result.data(), reference.data(), result.size() * sizeof(T)) == 0);
+        }
+    }
+    force_simd_level(simd_level::avx2);
+}
+
+bool is_integer(component c) noexcept { return c != component::float_type; }
+bool is_index(component c) noexcept
+{
+    return c == component::unsigned_byte_type || c == component::unsigned_short_type || c == component::unsigned_int_type;
+}
+}  // namespace
+
+TEST_CASE("bulk conversions agree with the scalar path", "[accessor_decode]")
+{
+    for (size_t scalars : {size_t{0}, size_t{1}, size_t{7}, size_t{31}, size_t{1000}, size_t{4099}})
+    {
+        auto const bytes = random_bytes(scalars * 4, static_cast<uint32_t>(scalars));
+        for (auto c : components)
+            for (bool normalized : {false, true})
+                require_identical_levels<float>(
+                    [&]
+                    {
+                        std::vector<float> out(scalars);
+                        convert_to_float(c, normalized, bytes.data(), out.data(), scalars);
+                        return out;
+                    });
+        for (auto c : components)
+        {
+            if (!is_index(c)) continue;
+            require_identical_levels<uint32_t>(
+                [&]
+                {
+                    std::vector<uint32_t> out(scalars);
+                    widen_to_uint32(c, bytes.data(), out.data(), scalars);
+                    return out;
+                });
+        }
+        std::vector<float> floats(scalars);
+        std::memcpy(floats.data(), bytes.data(), scalars * 4);
+        require_identical_levels<uint16_t>(
+            [&]
+            {
+                std::vector<uint16_t> out(scalars);
+                convert_to_half(floats.data(), out.data(), scalars);
+                return out;
+            });
+    }
+}
+
+TEST_CASE("half conversion rounds to nearest even and writes quiet NaNs", "[accessor_decode]")
+{
+    auto const              floats   = special_floats();
+    std::vector<uint16_t> const expected = {0x7e00, 0xfe00, 0x7e00, 0xfe00, 0x7e00, 0x7c00, 0xfc00, 0x0000, 0x8000, 0x0000,
+                                            0x0400, 0x0400, 0x7bff, 0x7c00, 0x0000, 0x0001, 0x3c00, 0x8000, 0x0000, 0x7c00};
+    for (auto level : levels)
+    {
+        force_simd_level(level);
+        // repeated so that the vector loops see every value
+        std::vector<float> repeated;
+        for (size_t i = 0; i != 8; ++i) repeated.insert(repeated.end(), floats.begin(), floats.end());
+        std::vector<uint16_t> out(repeated.size());
+        convert_to_half(repeated.data(), out.data(), repeated.size());
+        for (size_t i = 0; i != out.size(); ++i) REQUIRE(out[i] == expected[i % expected.size()]);
+    }
+    force_simd_level(simd_level::avx2);
+}
+
+TEST_CASE("normalized integers map onto the unit range", "[accessor_decode]")
+{
+    int8_t const   bytes[]  = {-128, -127, 0, 127};
+    uint16_t const shorts[] = {0, 65535};
+    for (auto level : levels)
+    {
+        force_simd_level(level);
+        float out[4];
+        convert_to_float(component::byte_type, true, bytes, out, 4);
+        REQUIRE((out[0] == -1.0f && out[1] == -1.0f && out[2] == 0.0f && out[3] == 1.0f));
+        convert_to_float(component::unsigned_short_type, true, shorts, out, 2);
+        REQUIRE((out[0] == 0.0f && out[1] == 1.0f));
+    }
+    force_simd_level(simd_level::avx2);
+}
+
+TEST_CASE("accessor decoding agrees with the scalar path for every layout", "[accessor_decode]")
+{
+    constexpr uint32_t count = 300;
+    for (auto c : components)
+        for (auto t : types)
+        {
+            auto const size = element_size(c, t);
+            for (size_t stride : {size_t{0}, (size + 3) & ~size_t{3}, ((size + 3) & ~size_t{3}) + 4, size_t{252}})
+            {
+                if (stride != 0 && stride < size) continue;
+                auto const step   = stride ? stride : size;
+                auto const offset = size_t{8};
+                auto const bytes  = random_bytes(offset + step * count, static_cast<uint32_t>(size * 1000 + stride));
+
+                doc d;
+                d.buffers.emplace_back(infile_buffer{bytes.size(), std::span<std::byte const>(bytes)});
+                d.buffer_views.emplace_back(0u, static_cast<uint32_t>(bytes.size() - offset), static_cast<uint32_t>(offset),
+                                            static_cast<uint32_t>(stride), 0u, meshopt_compression{});
+                for (bool normalized : {false, true})
+                {
+                    if (normalized && !is_integer(c)) continue;
+                    d.accessors.push_back(accessor{0, 0, count, c, t, normalized, {}, {}, sparse_accessor{}});
+                }
+                auto const scalars = count * component_count(t);
+                for (auto const& acc : d.accessors)
+                {
+                    INFO("component " << static_cast<int>(c) << " type " << static_cast<int>(t) << " stride " << stride << " normalized "
+                                      << acc.normalized);
+                    require_identical_levels<float>(
+                        [&]
+                        {
+                            std::vector<float> out(scalars);
+                            REQUIRE(decode_floats(d, acc, out) == scalars);
+                            return out;
+                        });
+                    require_identical_levels<uint16_t>(
+                        [&]
+                        {
+                            std::vector<uint16_t> out(scalars);
+                            REQUIRE(decode_halfs(d, acc, out) == scalars);
+                            return out;
+                        });
+                    if (t != attribute_type::scalar || !is_index(c)) continue;
+                    require_identical_levels<uint32_t>(
+                        [&]
+                        {
+                            std::vector<uint32_t> out(scalars);
+                            REQUIRE(widen_indices(d, acc, out) == scalars);
+                            return out;
+                        });
+                }
+            }
+        }
+}
@@ -0,0 +1,110 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <catch2/catch_test_macros.hpp>
+#include <trivial_gltf/accessor_decode.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "base64_decode.h"
+
+using namespace trivial_gltf;
+
+namespace
+{
+constexpr simd_level levels[] = {simd_level::scalar, simd_level::sse2, simd_level::avx2};
+constexpr char       alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// plain base64 with '=' and '==' endings
+std::string encode(std::vector<uint8_t> const& data)
+{
+    std::string out;
+    for (size_t i = 0; i < data.size(); i += 3)
+    {
+        auto const rest = data.size() - i;
+        auto const bits = uint32_t{data[i]} << 16 | (rest > 1 ? uint32_t{data[i + 1]} << 8 : 0) | (rest > 2 ? data[i + 2] : 0);
+        out += alphabet[bits >> 18 & 63];
+        out += alphabet[bits >> 12 & 63];
+        out += rest > 1 ? alphabet[bits >> 6 & 63] : '=';
+        out += rest > 2 ? alphabet[bits & 63] : '=';
+    }
+    return out;
+}
+
+// the text as it may still be json escaped: \/, alphabet characters as \uXXXX in either case, and escapes of
+// characters outside of the alphabet in between, which are skipped
+std::string escape(std::string const& text, std::mt19937& rng)
+{
+    std::string out;
+    char        code[8];
+    for (char c : text)
+    {
+        switch (rng() % 10)
+        {
+            case 0:  // the character itself
+                std::snprintf(code, sizeof code, rng() % 2 ? "\\u%04x" : "\\u%04X", static_cast<unsigned>(c));
+                out += code;
+                continue;
+            case 1: out += "\\u00e9"; break;
+            case 2: out += "\\n"; break;
+            default: break;
+        }
+        out += c == '/' && rng() % 2 ? std::string("\\/") : std::string(1, c);
+    }
+    return out;
+}
+
+// decodes the text fed in fragments of chunk characters, into exactly as much room as the data needs
+std::vector<uint8_t> decode(std::string const& text, size_t chunk, size_t size)
+{
+    base64_decoder         decoder;
+    std::vector<std::byte> out(size);
+    auto*                  pos = out.data();
+    for (size_t i = 0; i < text.size(); i += chunk)
+    {
+        auto const* first = text.data() + i;
+        auto const* last  = text.data() + std::min(text.size(), i + chunk);
+        REQUIRE(decoder.decode(first, last, pos, out.data() + out.size()) == last);
+    }
+    REQUIRE(static_cast<size_t>(out.data() + out.size() - pos) == decoder.pending_bytes());
+    decoder.finish(pos);
+    return std::vector<uint8_t>(reinterpret_cast<uint8_t const*>(out.data()), reinterpret_cast<uint8_t const*>(pos));
+}
+}  // namespace
+
+TEST_CASE("base64 decoding agrees with the source on every level and in every fragment size", "[base64]")
+{
+    std::mt19937 rng(17);
+    for (size_t size : {0, 1, 2, 3, 11, 12, 13, 47, 48, 300})
+    {
+        std::vector<uint8_t> data(size);
+        for (auto& b : data) b = static_cast<uint8_t>(rng());
+        auto const plain   = encode(data);
+        auto const escaped = escape(plain, rng);
+        for (auto const& text : {plain, escaped, plain + "=garbage that is ignored"})
+            for (auto level : levels)
+            {
+                force_simd_level(level);
+                for (size_t chunk = 1; chunk <= 64; ++chunk)
+                {
+                    INFO("size " << size << " level " << static_cast<int>(level) << " chunk " << chunk << " text " << text);
+                    REQUIRE(decode(text, chunk, size) == data);
+                }
+            }
+    }
+    force_simd_level(simd_level::avx2);
+}
+
+TEST_CASE("escapes of other characters are skipped as a whole", "[base64]")
+{
+    // the hex digits of the escapes are alphabet characters, they must not be decoded
+    REQUIRE(decode("\\u00e9QUJD", 1, 3) == std::vector<uint8_t>{'A', 'B', 'C'});
+    REQUIRE(decode("QU\\u0020JD", 3, 3) == std::vector<uint8_t>{'A', 'B', 'C'});
+    REQUIRE(decode("QUJ\\u0044", 2, 3) == std::vector<uint8_t>{'A', 'B', 'C'});
+    REQUIRE(decode("QUI\\u003d", 4, 2) == std::vector<uint8_t>{'A', 'B'});
+}
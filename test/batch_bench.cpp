@@ -0,0 +1,66 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/batch_loader.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "synthetic_gltf.h"
+
+// Parses a pack of small generated documents with growing pool sizes and reports the scaling.
+// usage: gltf_batch_bench [files] [meshes_per_file]
+int main(int argc, char const** argv)
+{
+    size_t const files           = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    size_t const meshes_per_file = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4;
+
+    std::vector<std::string>                texts;
+    std::vector<std::span<std::byte const>> sources;
+    texts.reserve(files);
+    for (size_t i = 0; i != files; ++i)
+    {
+        synthetic_scene shape;
+        shape.meshes     = meshes_per_file + i % 3;
+        shape.nodes      = shape.meshes * 2;
+        shape.primitives = 1;
+        shape.animations = i % 2;
+        shape.channels   = 4;
+        texts.push_back(synthetic_gltf(shape));
+    }
+    size_t total_bytes = 0;
+    for (auto const& t : texts)
+    {
+        sources.emplace_back(reinterpret_cast<std::byte const*>(t.data()), t.size());
+        total_bytes += t.size();
+    }
+
+    size_t const        hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> thread_counts;
+    for (size_t n = 1; n < hardware; n *= 2) thread_counts.push_back(n);
+    thread_counts.push_back(hardware);
+
+    std::printf("%zu files, %.2f MiB json\n%8s %10s %10s %8s %7s\n", files, total_bytes / (1024.0 * 1024.0), "threads", "ms", "files/s",
+                "speedup", "failed");
+    double single = 0;
+    for (auto const threads : thread_counts)
+    {
+        trivial_gltf::thread_pool pool(threads);
+        double                    best   = 1e30;
+        size_t                    failed = 0;
+        for (int run = 0; run != 3; ++run)
+        {
+            auto const start  = std::chrono::steady_clock::now();
+            auto const result = trivial_gltf::parse_batch(sources, pool);
+            auto const ms     = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            best              = std::min(best, ms);
+            failed            = std::count_if(result.begin(), result.end(),
+                                              [](auto const& e) { return e.state != trivial_gltf::parse_state::json_complete; });
+        }
+        if (threads == 1) single = best;
+        std::printf("%8zu %10.2f %10.0f %8.2f %7zu\n", threads, best, files * 1000.0 / best, single / best, failed);
+    }
+}
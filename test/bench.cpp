@@ -0,0 +1,536 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/flat_scene.h>
+#include <trivial_gltf/meshopt_decode.h>
+#include <trivial_gltf/parse_stats.h>
+#include <trivial_gltf/thread_pool.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include "keyword_matcher.h"
+#include "meshopt_encode.h"
+#include "synthetic_gltf.h"
+
+// Counting global allocator, so that the number of heap allocations per parse can be reported.
+namespace
+{
+std::atomic<size_t> allocation_count{0};
+std::atomic<size_t> allocation_bytes{0};
+}  // namespace
+
+void* operator new(size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+// std::pmr::new_delete_resource allocates through the aligned overloads
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    auto const align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    if (void* p = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align)) return p;
+    throw std::bad_alloc{};
+}
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace
+{
+struct measurement
+{
+    double      seconds{1e30};
+    size_t      allocations{0};
+    size_t      allocated_bytes{0};
+    size_t      elements{0};
+    size_t      peak_rss_kib{0};
+    char const* state{"?"};
+};
+
+size_t element_count(trivial_gltf::doc const& d)
+{
+    size_t n = d.scenes.size() + d.nodes.size() + d.meshes.size() + d.animations.size() + d.materials.size() + d.accessors.size() +
+               d.buffer_views.size() + d.buffers.size() + d.skins.size() + d.images.size() + d.samplers.size() + d.textures.size();
+    for (auto const& m : d.meshes) n += m.primitives.size();
+    for (auto const& a : d.animations) n += a.channels.size() + a.samplers.size();
+    return n;
+}
+
+char const* state_name(trivial_gltf::parse_state s)
+{
+    switch (s)
+    {
+        case trivial_gltf::parse_state::json_complete: return "ok";
+        case trivial_gltf::parse_state::error: return "error";
+        default: return "partial";
+    }
+}
+
+trivial_gltf::doc& document_of(trivial_gltf::doc& d) { return d; }
+trivial_gltf::doc& document_of(trivial_gltf::arena_doc& d) { return d.document; }
+
+// Feeds the text in chunks of the given size, the best of several runs is kept.
+template <typename Document>
+measurement measure(std::string const& text, size_t chunk, int runs, trivial_gltf::parse_options options = trivial_gltf::parse_options::all)
+{
+    measurement best;
+    for (int run = 0; run != runs; ++run)
+    {
+        auto const count_before = allocation_count.load();
+        auto const bytes_before = allocation_bytes.load();
+        auto const start        = std::chrono::steady_clock::now();
+        {
+            Document   storage;
+            auto&      dest   = document_of(storage);
+            auto       parser = trivial_gltf::create_parser(dest, options);
+            auto       state  = trivial_gltf::parse_state::more_input_needed;
+            auto const data   = std::span<char const>(text.data(), text.size());
+            for (size_t pos = 0; pos < data.size() && state == trivial_gltf::parse_state::more_input_needed; pos += chunk)
+                state = parser(data.subspan(pos, std::min(chunk, data.size() - pos)));
+            best.state    = state_name(state);
+            best.elements = element_count(dest);
+        }
+        auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds >= best.seconds) continue;
+        best.seconds         = seconds;
+        best.allocations     = allocation_count.load() - count_before;
+        best.allocated_bytes = allocation_bytes.load() - bytes_before;
+    }
+    return best;
+}
+
+size_t peak_rss_kib()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss);
+}
+
+// Runs measure in a child process, whose peak resident set covers only this configuration and the input text
+// instead of the largest configuration measured so far.
+template <typename Document>
+measurement measure_isolated(std::string const& text, size_t chunk, int runs,
+                             trivial_gltf::parse_options options = trivial_gltf::parse_options::all)
+{
+    int fds[2];
+    if (pipe(fds) != 0) return measure<Document>(text, chunk, runs, options);
+    auto const child = fork();
+    if (child < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return measure<Document>(text, chunk, runs, options);
+    }
+    if (child == 0)
+    {
+        close(fds[0]);
+        auto m         = measure<Document>(text, chunk, runs, options);
+        m.peak_rss_kib = peak_rss_kib();
+        auto const ok  = write(fds[1], &m, sizeof m) == static_cast<ssize_t>(sizeof m);
+        _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    measurement m;
+    if (read(fds[0], &m, sizeof m) != static_cast<ssize_t>(sizeof m)) m.state = "failed";
+    close(fds[0]);
+    waitpid(child, nullptr, 0);
+    return m;
+}
+
+// Fills the elements the parser creates for a synthetic scene - names, child lists, primitives with their attribute
+// lists and accessor bounds - straight into the doc, the same way the parser moves its temporaries in.
+void build_elements(trivial_gltf::doc& d, synthetic_scene const& shape)
+{
+    namespace tg    = trivial_gltf;
+    auto* const r   = d.resource();
+    auto const name = [&](size_t i) { return std::pmr::string(shape.name_length + 6, static_cast<char>('a' + i % 26), r); };
+    for (size_t i = 0; i != shape.nodes; ++i)
+    {
+        std::pmr::vector<uint32_t> children(r);
+        if (2 * i + 1 < shape.nodes) children.push_back(static_cast<uint32_t>(2 * i + 1));
+        if (2 * i + 2 < shape.nodes) children.push_back(static_cast<uint32_t>(2 * i + 2));
+        d.nodes.emplace_back(static_cast<int32_t>(i % std::max<size_t>(shape.meshes, 1)), -1, -1, glm::qua<float>{}, glm::vec3{1.0f},
+                             glm::vec3{}, std::move(children), std::pmr::vector<float>(r), name(i));
+    }
+    for (size_t m = 0; m != shape.meshes; ++m)
+    {
+        std::pmr::vector<tg::primitive> primitives(r);
+        for (size_t p = 0; p != shape.primitives; ++p)
+        {
+            auto const                             a = static_cast<uint32_t>((m * shape.primitives + p) * 5);
+            std::pmr::vector<tg::attribute_offset> attributes(r);
+            for (auto [attribute, k] : {std::pair{tg::attribute::position, 0u}, std::pair{tg::attribute::normal, 1u},
+                                        std::pair{tg::attribute::tangent, 2u}, std::pair{tg::attribute::texcoord_0, 3u}})
+                attributes.emplace_back(attribute, a + k);
+            for (size_t e = 0; e != shape.extra_attributes; ++e) attributes.emplace_back(tg::attribute::color_0, a + 3);
+            primitives.emplace_back(std::move(attributes), static_cast<int32_t>(a + 4), 0, tg::mode_type::triangles, tg::attribute_flag{},
+                                    std::pmr::vector<tg::morph_target>(r));
+        }
+        d.meshes.emplace_back(name(m), std::move(primitives), std::pmr::vector<float>(r));
+    }
+    for (size_t a = 0; a != shape.meshes * shape.primitives * 5; ++a)
+    {
+        std::pmr::vector<float> max(r), min(r);
+        if (a % 5 == 0)
+        {
+            max.assign({1.0f, 1.0f, 1.0f});
+            min.assign({-1.0f, -1.0f, -1.0f});
+        }
+        d.accessors.emplace_back(static_cast<uint32_t>(a / 5 * 2), 0u, 24u, tg::component::float_type, tg::attribute_type::vec3, false,
+                                 std::move(max), std::move(min), tg::sparse_accessor{});
+    }
+    for (size_t i = 0; i != shape.animations; ++i)
+    {
+        std::pmr::vector<tg::channel>           channels(r);
+        std::pmr::vector<tg::animation_sampler> samplers(r);
+        for (size_t c = 0; c != shape.channels; ++c)
+        {
+            channels.emplace_back(static_cast<int32_t>(c), static_cast<int32_t>(c % std::max<size_t>(shape.nodes, 1)),
+                                  tg::path_type::translation);
+            samplers.emplace_back(0, 1, tg::interpolation_type::linear);
+        }
+        d.animations.emplace_back(name(i), std::move(channels), std::move(samplers));
+    }
+}
+
+// The doc takes a memory_resource since the arena was introduced. On new_delete_resource it allocates every name and
+// list the way its std::allocator containers did before, so this compares the element construction of the old and
+// the new layout without the parser.
+void doc_build_bench(synthetic_scene const& shape)
+{
+    constexpr int runs = 20;
+    auto const    run  = [&](auto&& build)
+    {
+        double best = 1e30;
+        size_t allocations{0};
+        for (int r = 0; r != runs; ++r)
+        {
+            auto const count_before = allocation_count.load();
+            auto const start        = std::chrono::steady_clock::now();
+            build();
+            auto const seconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (seconds < best)
+            {
+                best        = seconds;
+                allocations = allocation_count.load() - count_before;
+            }
+        }
+        return std::pair{best, allocations};
+    };
+    auto const [heap_ms, heap_allocs] = run(
+        [&]
+        {
+            trivial_gltf::doc d{std::pmr::new_delete_resource()};
+            build_elements(d, shape);
+        });
+    auto const [arena_ms, arena_allocs] = run(
+        [&]
+        {
+            trivial_gltf::arena_doc d;
+            build_elements(d.document, shape);
+        });
+    std::printf("\ndoc construction of %zu nodes: per element heap %.3f ms %zu allocs, arena %.3f ms %zu allocs\n", shape.nodes, heap_ms,
+                heap_allocs, arena_ms, arena_allocs);
+}
+
+// The per keyword prefix scan the parser used before the keyword_trie, kept as baseline.
+struct scanned_keyword
+{
+    char const* word;
+    uint32_t    offset{0};
+};
+
+bool scan_test(std::string_view const& l, char const* r)
+{
+    auto lb = l.begin();
+    auto le = l.end();
+    while (*r && lb != le)
+        if (*lb++ != *r++) return false;
+    return lb == le;
+}
+
+template <size_t N>
+int scan_fragments(scanned_keyword (&kws)[N], std::string_view head, std::string_view tail)
+{
+    for (auto fragment : {head, tail})
+        for (auto& item : kws)
+            if (scan_test(fragment, item.word + item.offset))
+                item.offset += fragment.size();
+            else
+                item.offset = 0;
+    int found = -1;
+    for (auto& item : kws)
+    {
+        if (item.word[item.offset] == '\0') found = &item - &kws[0];
+        item.offset = 0;
+    }
+    return found;
+}
+
+// Resolves attribute names split into two streamed fragments, with the linear scan and with the trie.
+void keyword_bench()
+{
+    static constexpr char const* core[] = {"POSITION", "NORMAL", "TANGENT", "TEXCOORD_0", "TEXCOORD_1", "COLOR_0", "JOINTS_0", "WEIGHTS_0"};
+    static char const* const input[] = {"POSITION", "NORMAL",   "TANGENT",    "TEXCOORD_0", "TEXCOORD_1", "COLOR_0",
+                                        "JOINTS_0", "WEIGHTS_0", "TEXCOORD_2", "JOINTS_1",   "_BATCHID"};
+    static constexpr trivial_gltf::keyword_trie<trivial_gltf::trie_size(core)> trie{core};
+    scanned_keyword                                                             scanned[std::size(core)];
+    for (size_t i = 0; i != std::size(core); ++i) scanned[i].word = core[i];
+
+    constexpr size_t lookups = 1 << 22;
+    auto const       run     = [&](auto&& resolve)
+    {
+        long       checksum = 0;
+        auto const start    = std::chrono::steady_clock::now();
+        for (size_t i = 0; i != lookups; ++i)
+        {
+            std::string_view const name = input[i % std::size(input)];
+            auto const             half = name.size() / 2;
+            checksum += resolve(name.substr(0, half), name.substr(half));
+        }
+        auto const ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+        return std::pair{ns, checksum};
+    };
+    auto const [scan_ns, scan_sum] = run([&](std::string_view head, std::string_view tail) { return scan_fragments(scanned, head, tail); });
+    auto const [trie_ns, trie_sum] =
+        run([&](std::string_view head, std::string_view tail) { return trie.value(trie.feed(trie.feed(trie.root, head), tail)); });
+    std::printf("\nattribute keywords: linear scan %.2f ns, trie %.2f ns per name%s\n", scan_ns, trie_ns,
+                scan_sum == trie_sum ? "" : " (results differ)");
+}
+
+// Loads the same small document many times, with a fresh parser and doc each time and with one parser reset onto
+// one cleared doc.
+void reuse_bench(std::string const& text)
+{
+    constexpr int loads = 2000;
+    auto const    bytes = std::span<char const>(text.data(), text.size());
+    auto const    run   = [&](auto&& load)
+    {
+        auto const count_before = allocation_count.load();
+        auto const start        = std::chrono::steady_clock::now();
+        for (int i = 0; i != loads; ++i) load();
+        auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return std::pair{loads / seconds, double(allocation_count.load() - count_before) / loads};
+    };
+    auto const [fresh_rate, fresh_allocs] = run(
+        [&]
+        {
+            trivial_gltf::doc dest;
+            trivial_gltf::create_parser(dest)(bytes);
+        });
+    trivial_gltf::doc    reused_doc;
+    trivial_gltf::parser reused(reused_doc);
+    auto const [reuse_rate, reuse_allocs] = run(
+        [&]
+        {
+            reused_doc.clear();
+            reused.reset(reused_doc);
+            reused(bytes);
+        });
+    std::printf("\nrepeated loads: fresh parser %.0f docs/s %.1f allocs, reused parser %.0f docs/s %.1f allocs\n", fresh_rate, fresh_allocs,
+                reuse_rate, reuse_allocs);
+}
+
+void transform_bench(size_t node_count)
+{
+    auto const        text = synthetic_gltf({node_count, 1, 1, 0, 0, 8});
+    trivial_gltf::doc dest;
+    trivial_gltf::create_parser(dest)(std::span<char const>(text.data(), text.size()));
+    trivial_gltf::flat_scene  scene(dest, 0);
+    trivial_gltf::thread_pool pool;
+
+    constexpr int frames = 50;
+    auto const    run    = [&](auto&& frame)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        for (int i = 0; i != frames; ++i) frame(i);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    };
+    auto const serial   = run([&](int) { scene.compute_world_transforms(); });
+    auto const parallel = run([&](int) { scene.compute_world_transforms(&pool); });
+    // every hundredth node with a small subtree animated per frame, like skeleton joints
+    auto const animated = run(
+        [&](int frame)
+        {
+            for (size_t i = frame; i < scene.size(); i += 100)
+                if (scene.subtree_end(i) - i <= 16) scene.set_translation(i, glm::vec3(float(frame), 0.0f, 1.0f));
+            scene.update_world_transforms(&pool);
+        });
+    std::printf("\nworld transforms of %zu nodes: serial %.3f ms, %zu threads %.3f ms, animated %.3f ms\n", scene.size(), serial,
+                pool.size(), parallel, animated);
+}
+
+// Decodes meshopt compressed grid meshes - quantized positions and uvs, octahedral normals and triangle lists - with
+// the scalar and the simd kernels, and in parallel across the buffer views.
+void meshopt_bench(size_t views)
+{
+    constexpr uint32_t    side  = 256;
+    constexpr uint32_t    count = side * side;
+    std::vector<uint8_t>  vertices(count * 16), normals(count * 4);
+    std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y != side; ++y)
+        for (uint32_t x = 0; x != side; ++x)
+        {
+            uint32_t const v         = y * side + x;
+            uint16_t const attrs[8]  = {uint16_t(x << 6), uint16_t(x * y & 0x3ff), uint16_t(y << 6), 0, uint16_t(x << 8), uint16_t(y << 8)};
+            int8_t const   normal[4] = {int8_t(x % 64 - 32), int8_t(y % 64 - 32), 127, 0};
+            std::memcpy(&vertices[16 * v], attrs, 16);
+            std::memcpy(&normals[4 * v], normal, 4);
+            if (x + 1 != side && y + 1 != side) indices.insert(indices.end(), {v, v + 1, v + side, v + 1, v + side + 1, v + side});
+        }
+
+    // one bin buffer holding every stream once, views of the three kinds in turn
+    struct stream
+    {
+        std::vector<uint8_t>              bytes;
+        trivial_gltf::meshopt_compression compression;
+    } const streams[] = {
+        {meshopt_encode::vertices(vertices.data(), count, 16), {0, 0, 0, 16, count, trivial_gltf::meshopt_mode::attributes, {}}},
+        {meshopt_encode::vertices(normals.data(), count, 4),
+         {0, 0, 0, 4, count, trivial_gltf::meshopt_mode::attributes, trivial_gltf::meshopt_filter::octahedral}},
+        {meshopt_encode::triangles(indices.data(), indices.size()),
+         {0, 0, 0, 4, uint32_t(indices.size()), trivial_gltf::meshopt_mode::triangles, {}}},
+    };
+    std::vector<std::byte>                 bin;
+    std::vector<trivial_gltf::buffer_view> template_views;
+    size_t                                 decoded_bytes = 0;
+    for (auto const& s : streams)
+    {
+        auto c   = s.compression;
+        c.offset = static_cast<uint32_t>(bin.size());
+        c.length = static_cast<uint32_t>(s.bytes.size());
+        std::transform(s.bytes.begin(), s.bytes.end(), std::back_inserter(bin), [](uint8_t b) { return std::byte{b}; });
+        template_views.push_back({1, c.count * c.stride, 0, c.mode == trivial_gltf::meshopt_mode::attributes ? c.stride : 0, 0, c});
+    }
+
+    trivial_gltf::thread_pool pool;
+    std::vector<std::byte>    storage;
+    auto const                run = [&](trivial_gltf::thread_pool* p)
+    {
+        double best = 1e30;
+        for (int r = 0; r != 5; ++r)
+        {
+            trivial_gltf::doc d;
+            d.buffers.emplace_back(trivial_gltf::infile_buffer{bin.size(), bin});
+            d.buffers.emplace_back(trivial_gltf::infile_buffer{0, {}});
+            for (size_t i = 0; i != views; ++i) d.buffer_views.push_back(template_views[i % template_views.size()]);
+            decoded_bytes = 0;
+            for (auto const& v : d.buffer_views) decoded_bytes += v.length;
+            auto const start  = std::chrono::steady_clock::now();
+            auto const failed = trivial_gltf::decode_meshopt_views(d, storage, p);
+            best              = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            if (failed) std::printf("%zu views failed to decode\n", failed);
+        }
+        return decoded_bytes / best / 1e9;
+    };
+    auto const level = trivial_gltf::active_simd_level();
+    trivial_gltf::force_simd_level(trivial_gltf::simd_level::scalar);
+    auto const scalar = run(nullptr);
+    trivial_gltf::force_simd_level(level);
+    auto const simd     = run(nullptr);
+    auto const parallel = run(&pool);
+    std::printf("\nmeshopt decode of %zu views, %.1f MiB compressed: scalar %.2f GB/s, simd %.2f GB/s, %zu threads %.2f GB/s\n", views,
+                bin.size() * double(views) / template_views.size() / (1024.0 * 1024.0), scalar, simd, pool.size(), parallel);
+}
+
+// The same text parsed completely and with only the geometry requested, the skipped sections invoke no handler.
+void options_bench(std::string const& text)
+{
+    using trivial_gltf::parse_options;
+    auto const all      = measure_isolated<trivial_gltf::doc>(text, text.size(), 5);
+    auto const geometry = measure_isolated<trivial_gltf::doc>(text, text.size(), 5, parse_options::geometry & ~parse_options::names);
+    std::printf("\nparse options on %.1f MB with animations: all %.1f MB/s %zu elements %zu allocs, geometry without names %.1f MB/s "
+                "%zu elements %zu allocs\n",
+                text.size() / 1e6, text.size() / all.seconds / 1e6, all.elements, all.allocations, text.size() / geometry.seconds / 1e6,
+                geometry.elements, geometry.allocations);
+}
+
+void report(char const* scene, char const* storage, std::string const& text, size_t chunk, measurement const& m)
+{
+    char chunk_name[32];
+    if (chunk >= text.size())
+        std::snprintf(chunk_name, sizeof chunk_name, "whole");
+    else
+        std::snprintf(chunk_name, sizeof chunk_name, "%zu", chunk);
+    std::printf("%-8s %-6s %8s %10.2f %12.0f %10zu %12zu %10zu %8s\n", scene, storage, chunk_name, text.size() / m.seconds / 1e6,
+                m.elements / m.seconds, m.allocations, m.allocated_bytes, m.peak_rss_kib, m.state);
+}
+}  // namespace
+
+// usage: gltf_bench [scale]
+// Parses generated documents of several sizes and shapes, each with input chunks of 1 B, 4 KiB, 64 KiB and the whole document
+// at once, into a heap allocated doc and into an arena_doc. Every configuration runs in its own process for its peak resident
+// set, allocations are those of the fastest run. The animation heavy scene is parsed again with only the geometry requested.
+int main(int argc, char const** argv)
+{
+    size_t const scale = argc > 1 ? std::max<size_t>(std::strtoul(argv[1], nullptr, 10), 1) : 1;
+
+    struct
+    {
+        char const*     name;
+        synthetic_scene shape;
+    } const scenes[] = {
+        {"small", {16 * scale, 4 * scale, 2, 1, 8, 12}},
+        {"medium", {512 * scale, 64 * scale, 8, 8, 64, 24}},
+        {"large", {8192 * scale, 512 * scale, 16, 32, 256, 64}},
+        {"attribs", {256 * scale, 256 * scale, 8, 0, 0, 12, 12}},
+        {"anim", {1024 * scale, 32 * scale, 2, 64 * scale, 128, 12}},
+    };
+
+    std::printf("%-8s %-6s %8s %10s %12s %10s %12s %10s %8s\n", "scene", "doc", "chunk", "MB/s", "elements/s", "allocs", "alloc bytes",
+                "peak KiB", "state");
+    for (auto const& scene : scenes)
+    {
+        auto const text = synthetic_gltf(scene.shape);
+        for (size_t chunk : {size_t{1}, size_t{4096}, size_t{64 * 1024}, text.size()})
+        {
+            // single byte chunks are slow, keep the total run time bounded
+            int const runs = chunk == 1 ? 1 : 5;
+            report(scene.name, "heap", text, chunk, measure_isolated<trivial_gltf::doc>(text, chunk, runs));
+            report(scene.name, "arena", text, chunk, measure_isolated<trivial_gltf::arena_doc>(text, chunk, runs));
+        }
+    }
+
+    options_bench(synthetic_gltf(scenes[4].shape));
+    doc_build_bench(scenes[2].shape);
+    keyword_bench();
+    reuse_bench(synthetic_gltf(scenes[0].shape));
+    transform_bench(128 * 1024 * scale);
+    meshopt_bench(24 * scale);
+
+    // per section breakdown of the large scene
+    auto const                      text = synthetic_gltf(scenes[2].shape);
+    trivial_gltf::counting_resource counter;
+    trivial_gltf::doc               dest{&counter};
+    trivial_gltf::parse_stats       stats;
+    trivial_gltf::create_parser(dest, stats)(std::span<char const>(text.data(), text.size()));
+    std::printf("\n%-12s %10s %10s\n", "section", "ms", "elements");
+    for (size_t i = 0; i != trivial_gltf::doc_section_count; ++i)
+    {
+        auto const  section = static_cast<trivial_gltf::doc_section>(i);
+        auto const& s       = stats[section];
+        std::printf("%-12s %10.3f %10llu\n", trivial_gltf::section_name(section), s.time.count() / 1e6,
+                    static_cast<unsigned long long>(s.elements));
+    }
+    std::printf("%llu bytes, %llu doc allocations (%llu bytes), largest string %llu, largest array %llu\n",
+                static_cast<unsigned long long>(stats.bytes_consumed), static_cast<unsigned long long>(stats.allocations),
+                static_cast<unsigned long long>(stats.allocated_bytes), static_cast<unsigned long long>(stats.largest_string),
+                static_cast<unsigned long long>(stats.largest_array));
+}
@@ -5,18 +5,8 @@
 #include <trivial_gltf/gltf_parse.h>
 
 namespace a = async_json;
-void parse_json(std::istream& in, std::size_t length)
+void print(trivial_gltf::doc const& dest)
 {
-    std::string buf;
-    std::string foo;
-    buf.resize(length);
-    in.read(buf.data(), length);
-    trivial_gltf::doc dest;
-
-    auto parser = trivial_gltf::create_parser(dest);
-
-    parser(std::string_view(buf));
-
     for (auto const& item : dest.nodes) std::cout << "node: " << item.name << '\n';
     for (auto const& item : dest.meshes) std::cout << "mesh: " << item.name << '\n';
     for (auto const& item : dest.textures) std::cout << "texture: " << item.name << '\n';
@@ -41,26 +31,24 @@ int main(int argc, char const** argv)
     {
         std::ifstream input(argv[1], std::ios::binary | std::ios::in);
 
-        char header[12];
-        input.read(header, 12);
-        if (header[0] == 'g' && header[1] == 'l' && header[2] == 'T' && header[3] == 'F')
-        {
-            uint32_t version;
-            uint32_t length;
-            std::memcpy(&version, header + 4, 4);
-            std::memcpy(&length, header + 8, 4);
-            std::cout << "GLTF Found\n" << version << "  " << length << '\n';
-            char chunk_data[8];
-            input.read(chunk_data, 8);
-            uint32_t chunk_length;
-            char     chunk_type[5] = {0};
-            std::memcpy(&chunk_length, chunk_data, 4);
-            std::memcpy(&chunk_type, chunk_data + 4, 4);
-            std::cout << "GLTF Found\n" << chunk_length << "  " << chunk_type << '\n';
-            // parse json
-            parse_json(input, chunk_length);
+        char header[4] = {0};
+        input.read(header, 4);
+        bool const is_glb = header[0] == 'g' && header[1] == 'l' && header[2] == 'T' && header[3] == 'F';
+        input.seekg(0);
 
-            input.seekg(chunk_length + ((chunk_length & 3) != 0) * 4 + sizeof(header));
+        trivial_gltf::doc        dest;
+        trivial_gltf::glb_reader glb(dest);
+        auto                     json = trivial_gltf::create_parser(dest);
+        std::vector<char>        chunk(64 * 1024);
+        auto                     state = trivial_gltf::parse_state::more_input_needed;
+        while (input && state == trivial_gltf::parse_state::more_input_needed)
+        {
+            input.read(chunk.data(), chunk.size());
+            std::span<char const> bytes(chunk.data(), input.gcount());
+            state = is_glb ? glb(bytes) : json(bytes);
         }
+        if (state != trivial_gltf::parse_state::json_complete) std::cout << "incomplete or malformed input\n";
+        if (is_glb) std::cout << "GLB BIN chunk: " << glb.bin_chunk().size() << " bytes\n";
+        print(dest);
     }
 }
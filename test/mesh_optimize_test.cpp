@@ -0,0 +1,398 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <catch2/catch_test_macros.hpp>
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/mesh_optimize.h>
+#include <trivial_gltf/thread_pool.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace trivial_gltf;
+
+namespace
+{
+constexpr uint32_t array_buffer         = 34962;
+constexpr uint32_t element_array_buffer = 34963;
+
+// one buffer of the doc, filled with views of the given data
+struct buffer_builder
+{
+    std::vector<std::byte> bytes;
+
+    template <typename T>
+    uint32_t add_view(doc& d, std::vector<T> const& data, uint32_t target)
+    {
+        auto const offset = static_cast<uint32_t>(bytes.size());
+        bytes.resize(offset + ((data.size() * sizeof(T) + 3) & ~size_t{3}));
+        std::memcpy(bytes.data() + offset, data.data(), data.size() * sizeof(T));
+        d.buffer_views.emplace_back(0u, static_cast<uint32_t>(data.size() * sizeof(T)), offset, 0u, target, meshopt_compression{});
+        return static_cast<uint32_t>(d.buffer_views.size() - 1);
+    }
+    void bind(doc& d) { d.buffers.emplace_back(infile_buffer{bytes.size(), std::span<std::byte const>(bytes)}); }
+};
+
+uint32_t add_accessor(doc& d, uint32_t view, uint32_t count, component c, attribute_type t)
+{
+    d.accessors.push_back(accessor{view, 0, count, c, t, false, {}, {}, sparse_accessor{}});
+    return static_cast<uint32_t>(d.accessors.size() - 1);
+}
+
+void add_mesh(doc& d, std::pmr::vector<attribute_offset> attributes, uint32_t indices)
+{
+    std::pmr::vector<primitive> primitives(1);
+    primitives[0].attributes = std::move(attributes);
+    primitives[0].indices    = static_cast<int32_t>(indices);
+    d.meshes.push_back(mesh{"mesh", std::move(primitives), {}});
+}
+
+void add_mesh(doc& d, uint32_t position, uint32_t texcoord, uint32_t indices)
+{
+    add_mesh(d, {attribute_offset(attribute::position, position), attribute_offset(attribute::texcoord_0, texcoord)}, indices);
+}
+
+// Grid of side x side vertices with every triangle on its own three vertices, so that welding gives the grid back.
+struct unwelded_grid
+{
+    std::vector<float>    positions;
+    std::vector<float>    texcoords;
+    std::vector<uint32_t> indices;
+    size_t                side;
+
+    explicit unwelded_grid(size_t side) : side{side}
+    {
+        for (size_t y = 0; y + 1 < side; ++y)
+            for (size_t x = 0; x + 1 < side; ++x)
+                for (auto [dx, dy] : {std::pair{0, 0}, {1, 0}, {0, 1}, {1, 0}, {1, 1}, {0, 1}})
+                {
+                    auto const px = static_cast<float>(x + dx), py = static_cast<float>(y + dy);
+                    positions.insert(positions.end(), {px, py, 0.0f});
+                    texcoords.insert(texcoords.end(), {px / side, py / side});
+                    indices.push_back(static_cast<uint32_t>(indices.size()));
+                }
+    }
+    uint32_t vertex_count() const noexcept { return static_cast<uint32_t>(indices.size()); }
+};
+
+// Indexed triangles over vec3 positions, each vertex at a distinct position.
+struct indexed_mesh
+{
+    std::vector<float>    positions;
+    std::vector<uint32_t> indices;
+
+    size_t vertex_count() const noexcept { return positions.size() / 3; }
+};
+
+// columns x rows vertices in the z = 0 plane, the triangles row by row
+indexed_mesh grid(size_t columns, size_t rows)
+{
+    indexed_mesh m;
+    for (size_t y = 0; y != rows; ++y)
+        for (size_t x = 0; x != columns; ++x) m.positions.insert(m.positions.end(), {static_cast<float>(x), static_cast<float>(y), 0.0f});
+    for (size_t y = 0; y + 1 < rows; ++y)
+        for (size_t x = 0; x + 1 < columns; ++x)
+        {
+            auto const v = static_cast<uint32_t>(y * columns + x), c = static_cast<uint32_t>(columns);
+            m.indices.insert(m.indices.end(), {v, v + 1, v + c, v + 1, v + c + 1, v + c});
+        }
+    return m;
+}
+
+// unit sphere of rings x segments quads, the poles fanned, facing outward
+indexed_mesh sphere(size_t rings, size_t segments)
+{
+    indexed_mesh m;
+    m.positions = {0.0f, 0.0f, 1.0f};
+    for (size_t r = 1; r != rings; ++r)
+        for (size_t s = 0; s != segments; ++s)
+        {
+            auto const theta = 3.14159265f * static_cast<float>(r) / static_cast<float>(rings);
+            auto const phi   = 6.2831853f * static_cast<float>(s) / static_cast<float>(segments);
+            m.positions.insert(m.positions.end(), {std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)});
+        }
+    m.positions.insert(m.positions.end(), {0.0f, 0.0f, -1.0f});
+    auto const ring   = [&](size_t r, size_t s) { return static_cast<uint32_t>(1 + (r - 1) * segments + s % segments); };
+    auto const bottom = static_cast<uint32_t>(m.vertex_count() - 1);
+    for (size_t s = 0; s != segments; ++s)
+    {
+        m.indices.insert(m.indices.end(), {0, ring(1, s), ring(1, s + 1)});
+        for (size_t r = 1; r + 1 < rings; ++r)
+            m.indices.insert(m.indices.end(),
+                             {ring(r, s), ring(r + 1, s), ring(r + 1, s + 1), ring(r, s), ring(r + 1, s + 1), ring(r, s + 1)});
+        m.indices.insert(m.indices.end(), {ring(rings - 1, s), bottom, ring(rings - 1, s + 1)});
+    }
+    return m;
+}
+
+// the triangles in random order, each rotated at random, which keeps its winding
+std::vector<uint32_t> shuffled(std::vector<uint32_t> const& indices, std::mt19937& rng)
+{
+    std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+    for (size_t t = 0; t != triangles.size(); ++t)
+    {
+        auto const r = rng() % 3;
+        for (size_t j = 0; j != 3; ++j) triangles[t][j] = indices[3 * t + (j + r) % 3];
+    }
+    std::shuffle(triangles.begin(), triangles.end(), rng);
+    std::vector<uint32_t> out;
+    for (auto const& t : triangles) out.insert(out.end(), t.begin(), t.end());
+    return out;
+}
+
+// every triangle rotated to begin with its smallest vertex, in sorted order, equal for permutations that keep the winding
+template <typename T>
+std::vector<std::array<T, 3>> canonical(std::vector<T> const& corners)
+{
+    std::vector<std::array<T, 3>> triangles;
+    for (size_t t = 0; t + 2 < corners.size(); t += 3)
+    {
+        auto const r = std::min_element(corners.begin() + t, corners.begin() + t + 3) - (corners.begin() + t);
+        triangles.push_back({corners[t + r], corners[t + (r + 1) % 3], corners[t + (r + 2) % 3]});
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+std::vector<uint32_t> resolved_indices(doc const& d, primitive const& p)
+{
+    std::vector<uint32_t> indices(d.accessors[p.indices].count);
+    REQUIRE(widen_indices(d, d.accessors[p.indices], indices) == indices.size());
+    return indices;
+}
+
+// the position of every index
+std::vector<std::array<float, 3>> corner_positions(doc const& d, primitive const& p)
+{
+    auto const& acc = d.accessors[tiny_tuple::get<1>(p.attributes[0])];
+    std::vector<std::array<float, 3>> positions(acc.count);
+    REQUIRE(materialize_accessor(d, acc, std::as_writable_bytes(std::span(positions))) == positions.size() * 12);
+    std::vector<std::array<float, 3>> out;
+    for (auto i : resolved_indices(d, p)) out.push_back(positions.at(i));
+    return out;
+}
+
+// a doc with one mesh of m, the indices stored as c
+template <typename T>
+doc mesh_doc(indexed_mesh const& m, component c, buffer_builder& bin)
+{
+    doc                  d;
+    std::vector<T> const indices(m.indices.begin(), m.indices.end());
+    auto const position = add_accessor(d, bin.add_view(d, m.positions, array_buffer), static_cast<uint32_t>(m.vertex_count()),
+                                       component::float_type, attribute_type::vec3);
+    auto const index    = add_accessor(d, bin.add_view(d, indices, element_array_buffer), static_cast<uint32_t>(indices.size()), c,
+                                       attribute_type::scalar);
+    bin.bind(d);
+    add_mesh(d, {attribute_offset(attribute::position, position)}, index);
+    return d;
+}
+
+// the position and texcoord bytes of every index, in index order
+std::vector<std::byte> corner_bytes(doc const& d, primitive const& p)
+{
+    auto const&           index_accessor = d.accessors[p.indices];
+    std::vector<uint32_t> indices(index_accessor.count);
+    REQUIRE(widen_indices(d, index_accessor, indices) == indices.size());
+    std::vector<std::byte> out;
+    for (auto const& a : p.attributes)
+    {
+        auto const& acc  = d.accessors[tiny_tuple::get<1>(a)];
+        auto const  size = element_size(acc.comp_type, acc.type);
+        std::vector<std::byte> elements(acc.count * size);
+        REQUIRE(materialize_accessor(d, acc, elements) == elements.size());
+        for (auto i : indices)
+        {
+            REQUIRE(i < acc.count);
+            out.insert(out.end(), elements.begin() + i * size, elements.begin() + (i + 1) * size);
+        }
+    }
+    return out;
+}
+}  // namespace
+
+TEST_CASE("welding keeps every corner and counts the vertices saved", "[mesh_optimize]")
+{
+    unwelded_grid const grid(9);
+    thread_pool         pool(3);
+    for (thread_pool* p : {static_cast<thread_pool*>(nullptr), &pool})
+    {
+        doc            d;
+        buffer_builder bin;
+        auto const     position = add_accessor(d, bin.add_view(d, grid.positions, array_buffer), grid.vertex_count(), component::float_type,
+                                               attribute_type::vec3);
+        auto const     texcoord = add_accessor(d, bin.add_view(d, grid.texcoords, array_buffer), grid.vertex_count(), component::float_type,
+                                               attribute_type::vec2);
+        auto const     indices  = add_accessor(d, bin.add_view(d, grid.indices, element_array_buffer), grid.vertex_count(),
+                                               component::unsigned_int_type, attribute_type::scalar);
+        bin.bind(d);
+        add_mesh(d, position, texcoord, indices);
+        auto const before = corner_bytes(d, d.meshes[0].primitives[0]);
+
+        std::vector<std::byte> storage;
+        auto const             report = weld_vertices(d, storage, p);
+        REQUIRE(report.vertices_before == grid.vertex_count());
+        REQUIRE(report.vertices_after == grid.side * grid.side);
+        REQUIRE(report.bytes_saved == (report.vertices_before - report.vertices_after) * (12 + 8));
+        auto const& welded = d.meshes[0].primitives[0];
+        REQUIRE(d.accessors[tiny_tuple::get<1>(welded.attributes[0])].count == grid.side * grid.side);
+        REQUIRE(corner_bytes(d, welded) == before);
+
+        // nothing left to weld
+        auto const again = weld_vertices(d, storage, p);
+        REQUIRE(again.vertices_before == again.vertices_after);
+        REQUIRE(again.bytes_saved == 0);
+    }
+}
+
+TEST_CASE("sharing identical accessors counts only the storage given up", "[mesh_optimize]")
+{
+    unwelded_grid const grid(3);
+    doc                 d;
+    buffer_builder      bin;
+    auto const          first_view  = bin.add_view(d, grid.positions, array_buffer);
+    auto const          second_view = bin.add_view(d, grid.positions, array_buffer);
+    auto const          texcoords   = bin.add_view(d, grid.texcoords, array_buffer);
+    auto const          index_view  = bin.add_view(d, grid.indices, element_array_buffer);
+    // a second view over the bytes of second_view
+    d.buffer_views.push_back(d.buffer_views[second_view]);
+    auto const alias_view = static_cast<uint32_t>(d.buffer_views.size() - 1);
+    bin.bind(d);
+
+    auto const count = grid.vertex_count();
+    auto const add   = [&](uint32_t view, component c, attribute_type t) { return add_accessor(d, view, count, c, t); };
+    auto const texcoord = add(texcoords, component::float_type, attribute_type::vec2);
+    auto const indices  = add(index_view, component::unsigned_int_type, attribute_type::scalar);
+    // the representative, an alias of it on the same view, a copy, and an alias of the copy on another view
+    for (auto view : {first_view, first_view, second_view, alias_view})
+        add_mesh(d, add(view, component::float_type, attribute_type::vec3), texcoord, indices);
+    d.nodes.resize(4);
+    for (size_t i = 0; i != 4; ++i) d.nodes[i].mesh = static_cast<int32_t>(i);
+
+    auto const report = share_identical(d);
+    REQUIRE(report.accessors_shared == 3);
+    REQUIRE(report.bytes_saved == count * 12);
+    REQUIRE(report.meshes_shared == 3);
+    for (auto const& n : d.nodes) REQUIRE(n.mesh == 0);
+}
+
+TEST_CASE("vertex cache and overdraw ordering keep every triangle and its winding", "[mesh_optimize]")
+{
+    std::mt19937 rng(23);
+    for (auto const& m : {grid(40, 30), sphere(24, 32), sphere(3, 3)})
+        for (size_t cache_size : {3, 8, 16, 32})
+        {
+            INFO("vertices " << m.vertex_count() << " cache " << cache_size);
+            auto const            input = shuffled(m.indices, rng);
+            std::vector<uint32_t> cached(input.size()), drawn(input.size());
+            REQUIRE(optimize_vertex_cache(input, m.vertex_count(), cached, cache_size));
+            REQUIRE(canonical(cached) == canonical(input));
+            REQUIRE(optimize_overdraw(cached, m.positions, drawn, cache_size));
+            REQUIRE(canonical(drawn) == canonical(input));
+        }
+
+    // out of range indices are refused
+    std::vector<uint32_t> const bad = {0, 1, 3};
+    std::vector<uint32_t>       out(3);
+    REQUIRE_FALSE(optimize_vertex_cache(bad, 3, out));
+    REQUIRE_FALSE(optimize_overdraw(bad, std::vector<float>(9), out));
+}
+
+TEST_CASE("vertex cache ordering lowers the miss ratio of a shuffled grid", "[mesh_optimize]")
+{
+    std::mt19937 rng(29);
+    auto const   m = grid(64, 64);
+    for (size_t cache_size : {8, 16, 32})
+    {
+        auto const            input = shuffled(m.indices, rng);
+        std::vector<uint32_t> out(input.size());
+        REQUIRE(optimize_vertex_cache(input, m.vertex_count(), out, cache_size));
+        INFO("cache " << cache_size);
+        REQUIRE(average_cache_miss_ratio(out, cache_size) <= average_cache_miss_ratio(input, cache_size));
+        // row by row the cache holds too few vertices of the previous row to reuse them
+        REQUIRE(average_cache_miss_ratio(out, cache_size) < average_cache_miss_ratio(m.indices, cache_size));
+    }
+}
+
+TEST_CASE("overdraw ordering stays within the threshold of the vertex cache order", "[mesh_optimize]")
+{
+    std::mt19937 rng(31);
+    for (auto const& m : {sphere(24, 32), sphere(64, 64), grid(50, 50)})
+    {
+        auto const            input = shuffled(m.indices, rng);
+        std::vector<uint32_t> cached(input.size()), drawn(input.size());
+        REQUIRE(optimize_vertex_cache(input, m.vertex_count(), cached));
+        auto const base = average_cache_miss_ratio(cached);
+        for (float threshold : {1.0f, 1.05f, 1.2f, 1.5f})
+        {
+            INFO("vertices " << m.vertex_count() << " threshold " << threshold);
+            REQUIRE(optimize_overdraw(cached, m.positions, drawn, 16, threshold));
+            REQUIRE(average_cache_miss_ratio(drawn) <= threshold * base);
+        }
+    }
+}
+
+TEST_CASE("rewritten indices are widened before they reach the restart value", "[mesh_optimize]")
+{
+    struct expectation
+    {
+        indexed_mesh m;
+        component    original, rewritten;
+    };
+    expectation const expectations[] = {{grid(15, 17), component::unsigned_byte_type, component::unsigned_byte_type},
+                                        {grid(16, 16), component::unsigned_byte_type, component::unsigned_short_type},
+                                        {grid(255, 257), component::unsigned_short_type, component::unsigned_short_type},
+                                        {grid(256, 256), component::unsigned_short_type, component::unsigned_int_type}};
+    for (auto const& [m, original, rewritten] : expectations)
+    {
+        INFO("vertices " << m.vertex_count());
+        buffer_builder bin;
+        auto           d = original == component::unsigned_byte_type ? mesh_doc<uint8_t>(m, original, bin)
+                                                                      : mesh_doc<uint16_t>(m, original, bin);
+        auto const     before = canonical(corner_positions(d, d.meshes[0].primitives[0]));
+
+        std::vector<std::byte> storage;
+        REQUIRE(optimize_primitives(d, storage) == 1);
+        auto const& p = d.meshes[0].primitives[0];
+        REQUIRE(d.accessors[p.indices].comp_type == rewritten);
+        auto const indices = resolved_indices(d, p);
+        REQUIRE(*std::max_element(indices.begin(), indices.end()) == m.vertex_count() - 1);
+        REQUIRE(canonical(corner_positions(d, p)) == before);
+    }
+}
+
+TEST_CASE("primitives are ordered for overdraw within the threshold", "[mesh_optimize]")
+{
+    std::mt19937 rng(37);
+    auto         m = sphere(32, 48);
+    m.indices      = shuffled(m.indices, rng);
+    thread_pool pool(2);
+
+    // without the overdraw pass the order is that of the vertex cache pass
+    buffer_builder         plain_bin;
+    auto                   plain = mesh_doc<uint32_t>(m, component::unsigned_int_type, plain_bin);
+    std::vector<std::byte> plain_storage;
+    REQUIRE(optimize_primitives(plain, plain_storage, nullptr, 16, 0.0f) == 1);
+    auto const base = average_cache_miss_ratio(resolved_indices(plain, plain.meshes[0].primitives[0]));
+    REQUIRE(base < average_cache_miss_ratio(m.indices));
+
+    for (thread_pool* p : {static_cast<thread_pool*>(nullptr), &pool})
+    {
+        buffer_builder         bin;
+        auto                   d      = mesh_doc<uint32_t>(m, component::unsigned_int_type, bin);
+        auto const             before = canonical(corner_positions(d, d.meshes[0].primitives[0]));
+        std::vector<std::byte> storage;
+        REQUIRE(optimize_primitives(d, storage, p, 16, 1.5f) == 1);
+        auto const& optimized = d.meshes[0].primitives[0];
+        REQUIRE(canonical(corner_positions(d, optimized)) == before);
+        auto const ratio = average_cache_miss_ratio(resolved_indices(d, optimized));
+        REQUIRE(ratio <= 1.5 * base);
+        // the clusters were reordered
+        REQUIRE(corner_positions(d, optimized) != corner_positions(plain, plain.meshes[0].primitives[0]));
+    }
+}
@@ -0,0 +1,150 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <catch2/catch_test_macros.hpp>
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/meshopt_decode.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include "meshopt_encode.h"
+
+using namespace trivial_gltf;
+
+namespace
+{
+std::span<std::byte const> as_bytes(std::vector<uint8_t> const& v) { return std::as_bytes(std::span(v)); }
+
+// decodes with the scalar and the simd kernels, requires both to give the same bytes and returns them
+template <typename Decode>
+std::vector<uint8_t> decode_both(size_t size, Decode&& decode)
+{
+    auto const           level = active_simd_level();
+    std::vector<uint8_t> scalar(size), simd(size);
+    force_simd_level(simd_level::scalar);
+    REQUIRE(decode(std::as_writable_bytes(std::span(scalar))));
+    force_simd_level(level);
+    REQUIRE(decode(std::as_writable_bytes(std::span(simd))));
+    REQUIRE(std::memcmp(scalar.data(), simd.data(), size) == 0);
+    return simd;
+}
+
+// smooth values that the deltas compress well, mixed with random ones that need the wide groups and escapes
+std::vector<uint8_t> vertex_data(size_t count, size_t stride, uint32_t seed)
+{
+    std::mt19937         rng(seed);
+    std::vector<uint8_t> out(count * stride);
+    for (size_t v = 0; v != count; ++v)
+        for (size_t k = 0; k != stride; ++k)
+            out[v * stride + k] = k % 3 == 0 ? static_cast<uint8_t>(rng()) : static_cast<uint8_t>(v * (k + 1) / 7 + (rng() % 3));
+    return out;
+}
+
+std::vector<uint32_t> grid_triangles(uint32_t side)
+{
+    std::vector<uint32_t> out;
+    for (uint32_t y = 0; y + 1 < side; ++y)
+        for (uint32_t x = 0; x + 1 < side; ++x)
+        {
+            uint32_t const v = y * side + x;
+            out.insert(out.end(), {v, v + 1, v + side, v + 1, v + side + 1, v + side});
+        }
+    return out;
+}
+
+// triangles compared up to rotation, which the codec does not keep
+std::vector<uint32_t> canonical_triangles(std::vector<uint32_t> t)
+{
+    for (size_t i = 0; i + 3 <= t.size(); i += 3) std::rotate(&t[i], std::min_element(&t[i], &t[i + 3]), &t[i + 3]);
+    return t;
+}
+}  // namespace
+
+TEST_CASE("meshopt vertex streams round trip on every level", "[meshopt]")
+{
+    for (size_t stride : {size_t{4}, size_t{8}, size_t{12}, size_t{16}, size_t{64}, size_t{256}})
+        for (size_t count : {size_t{1}, size_t{15}, size_t{16}, size_t{17}, size_t{1000}, size_t{5000}})
+        {
+            INFO("stride " << stride << " count " << count);
+            auto const source  = vertex_data(count, stride, static_cast<uint32_t>(stride * count));
+            auto const encoded = meshopt_encode::vertices(source.data(), count, stride);
+            auto const decoded = decode_both(count * stride, [&](std::span<std::byte> out)
+                                             { return decode_meshopt_vertices(as_bytes(encoded), count, stride, out); });
+            REQUIRE(std::memcmp(decoded.data(), source.data(), source.size()) == 0);
+
+            // truncated streams are rejected
+            auto const truncated = std::span(encoded).first(encoded.size() - 1);
+            std::vector<std::byte> out(count * stride);
+            REQUIRE_FALSE(decode_meshopt_vertices(std::as_bytes(truncated), count, stride, out));
+        }
+}
+
+TEST_CASE("meshopt index streams round trip on every level", "[meshopt]")
+{
+    auto const triangles = grid_triangles(50);
+    auto       shuffled  = triangles;
+    std::mt19937 rng(7);
+    for (size_t i = shuffled.size() / 3; i > 1; --i)
+    {
+        auto const j = rng() % i;
+        std::swap_ranges(&shuffled[3 * (i - 1)], &shuffled[3 * i], &shuffled[3 * j]);
+    }
+    for (std::vector<uint32_t> const* source : {&triangles, static_cast<std::vector<uint32_t> const*>(&shuffled)})
+    {
+        auto const count = source->size();
+        for (size_t stride : {size_t{2}, size_t{4}})
+        {
+            INFO("stride " << stride);
+            auto const index_type = stride == 2 ? component::unsigned_short_type : component::unsigned_int_type;
+            auto const encoded = meshopt_encode::triangles(source->data(), count);
+            auto const decoded = decode_both(count * stride, [&](std::span<std::byte> out)
+                                             { return decode_meshopt_triangles(as_bytes(encoded), count, stride, out); });
+            std::vector<uint32_t> widened(count);
+            widen_to_uint32(index_type, decoded.data(), widened.data(), count);
+            REQUIRE(canonical_triangles(widened) == canonical_triangles(*source));
+
+            auto const sequence = meshopt_encode::indices(source->data(), count);
+            auto const indices  = decode_both(count * stride, [&](std::span<std::byte> out)
+                                              { return decode_meshopt_indices(as_bytes(sequence), count, stride, out); });
+            widen_to_uint32(index_type, indices.data(), widened.data(), count);
+            REQUIRE(widened == *source);
+        }
+    }
+}
+
+TEST_CASE("meshopt filters give the same result on the vector and the scalar path", "[meshopt]")
+{
+    struct filter_case
+    {
+        meshopt_filter filter;
+        size_t         stride;
+    };
+    for (auto [filter, stride] : {filter_case{meshopt_filter::octahedral, 4}, filter_case{meshopt_filter::octahedral, 8},
+                                  filter_case{meshopt_filter::quaternion, 8}, filter_case{meshopt_filter::exponential, 4},
+                                  filter_case{meshopt_filter::exponential, 12}})
+        for (size_t count : {size_t{3}, size_t{4}, size_t{257}, size_t{1024}})
+        {
+            INFO("filter " << static_cast<int>(filter) << " stride " << stride << " count " << count);
+            std::mt19937         rng(static_cast<uint32_t>(count * stride));
+            std::vector<uint8_t> source(count * stride);
+            for (auto& b : source) b = static_cast<uint8_t>(rng());
+            if (filter == meshopt_filter::exponential)  // exponents in a range that stays finite
+                for (size_t i = 3; i < source.size(); i += 4) source[i] = static_cast<uint8_t>(static_cast<int8_t>(rng() % 40) - 20);
+            if (filter == meshopt_filter::octahedral)  // the length component is positive
+                for (size_t v = 0; v != count; ++v) source[v * stride + 2 * stride / 4 + stride / 4 - 1] &= 0x7f;
+
+            auto const encoded = meshopt_encode::vertices(source.data(), count, stride);
+            meshopt_compression const c{0,
+                                        0,
+                                        static_cast<uint32_t>(encoded.size()),
+                                        static_cast<uint32_t>(stride),
+                                        static_cast<uint32_t>(count),
+                                        meshopt_mode::attributes,
+                                        filter};
+            // the vector loops cover four elements at once, the scalar path every element and the tail
+            decode_both(count * stride, [&](std::span<std::byte> out) { return decode_meshopt(c, as_bytes(encoded), out); });
+        }
+}
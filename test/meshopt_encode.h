@@ -0,0 +1,206 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_MESHOPT_ENCODE_H_INCLUDED
+#define TRIVIAL_GLTF_MESHOPT_ENCODE_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Straightforward encoders of the EXT_meshopt_compression bitstreams, to generate input for the decoder
+// benchmarks. They produce valid streams but do not try as hard as a production encoder.
+namespace meshopt_encode
+{
+inline void vbyte(std::vector<uint8_t>& out, uint32_t v)
+{
+    for (; v >= 128; v >>= 7) out.push_back(static_cast<uint8_t>((v & 127) | 128));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline uint32_t zigzag(int32_t v) { return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31); }
+
+// vertices holds count elements of stride bytes, stride a multiple of 4 up to 256
+inline std::vector<uint8_t> vertices(uint8_t const* vertices, size_t count, size_t stride)
+{
+    std::vector<uint8_t> out{0xa0};
+    size_t const         block = std::min<size_t>((8192 / stride) & ~size_t{15}, 256);
+    std::vector<uint8_t> last(vertices, vertices + stride);
+    for (size_t first = 0; first < count; first += block)
+    {
+        size_t const n       = std::min(block, count - first);
+        size_t const aligned = (n + 15) & ~size_t{15};
+        for (size_t k = 0; k != stride; ++k)
+        {
+            uint8_t deltas[256] = {};
+            uint8_t previous    = last[k];
+            for (size_t i = 0; i != n; ++i)
+            {
+                auto const v = vertices[(first + i) * stride + k];
+                auto const d = static_cast<int8_t>(v - previous);
+                deltas[i]    = static_cast<uint8_t>((d << 1) ^ (d >> 7));
+                previous     = v;
+            }
+            size_t const header = out.size();
+            out.resize(out.size() + (aligned / 16 + 3) / 4);
+            for (size_t g = 0; g != aligned / 16; ++g)
+            {
+                uint8_t const* group = deltas + 16 * g;
+                auto const     cost  = [group](int bits)
+                {
+                    size_t size = 2 * bits;
+                    for (int i = 0; i != 16; ++i) size += group[i] >= (1 << bits) - 1;
+                    return size;
+                };
+                // the narrowest width, escaped bytes included
+                int bits_log2 = 3;
+                if (std::all_of(group, group + 16, [](uint8_t v) { return v == 0; }))
+                    bits_log2 = 0;
+                else if (cost(2) <= std::min<size_t>(cost(4), 16))
+                    bits_log2 = 1;
+                else if (cost(4) <= 16)
+                    bits_log2 = 2;
+                out[header + g / 4] |= static_cast<uint8_t>(bits_log2 << (g % 4 * 2));
+                if (bits_log2 == 3) out.insert(out.end(), group, group + 16);
+                if (bits_log2 != 1 && bits_log2 != 2) continue;
+
+                int const    bits   = bits_log2 == 1 ? 2 : 4;
+                int const    escape = (1 << bits) - 1;
+                size_t const packed = out.size();
+                out.resize(out.size() + 2 * bits);
+                for (int i = 0; i != 16; ++i)
+                    out[packed + i * bits / 8] |= static_cast<uint8_t>(std::min<int>(group[i], escape) << (8 - bits - i * bits % 8));
+                for (int i = 0; i != 16; ++i)
+                    if (group[i] >= escape) out.push_back(group[i]);
+            }
+        }
+        last.assign(vertices + (first + n - 1) * stride, vertices + (first + n) * stride);
+    }
+    out.resize(out.size() + std::max<size_t>(32, stride) - stride);
+    out.insert(out.end(), vertices, vertices + stride);
+    return out;
+}
+
+// index sequence, deltas against the closer of the two last indices
+inline std::vector<uint8_t> indices(uint32_t const* indices, size_t count)
+{
+    std::vector<uint8_t> out{0xd1};
+    uint32_t             last[2] = {0, 0};
+    for (size_t i = 0; i != count; ++i)
+    {
+        auto const d0       = static_cast<int32_t>(indices[i] - last[0]);
+        auto const d1       = static_cast<int32_t>(indices[i] - last[1]);
+        auto const baseline = std::abs(int64_t{d1}) < std::abs(int64_t{d0}) ? 1u : 0u;
+        vbyte(out, (zigzag(baseline ? d1 : d0) << 1) | baseline);
+        last[baseline] = indices[i];
+    }
+    out.resize(out.size() + 4);
+    return out;
+}
+
+// triangle lists, with the edge and vertex fifos of the version 1 codec
+inline std::vector<uint8_t> triangles(uint32_t const* indices, size_t count)
+{
+    constexpr uint8_t aux_table[16] = {0x00, 0x76, 0x87, 0x56, 0x67, 0x78, 0xa9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69, 0, 0};
+    constexpr int     fec_max       = 13;
+
+    uint32_t edges[16][2], fifo[16];
+    std::fill(&edges[0][0], &edges[0][0] + 32, ~0u);
+    std::fill(fifo, fifo + 16, ~0u);
+    size_t     edge_offset = 0, vertex_offset = 0;
+    uint32_t   next = 0, last = 0;
+    auto const push_edge = [&](uint32_t a, uint32_t b)
+    {
+        edges[edge_offset][0] = a;
+        edges[edge_offset][1] = b;
+        edge_offset           = (edge_offset + 1) & 15;
+    };
+    auto const push_vertex = [&](uint32_t v, bool advance = true)
+    {
+        fifo[vertex_offset] = v;
+        vertex_offset       = (vertex_offset + advance) & 15;
+    };
+    auto const find_vertex = [&](uint32_t v)
+    {
+        for (int i = 0; i != 16; ++i)
+            if (fifo[(vertex_offset - 1 - i) & 15] == v) return i;
+        return -1;
+    };
+
+    std::vector<uint8_t> code{0xe1}, data;
+    for (size_t t = 0; t + 3 <= count; t += 3)
+    {
+        uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+        int      edge = -1;
+        for (int i = 0; i != 15 && edge < 0; ++i)
+        {
+            auto const* e = edges[(edge_offset - 1 - i) & 15];
+            if (e[0] == a && e[1] == b)
+                edge = i << 2;
+            else if (e[0] == b && e[1] == c)
+                edge = i << 2 | 1;
+            else if (e[0] == c && e[1] == a)
+                edge = i << 2 | 2;
+        }
+        if (edge >= 0)
+        {
+            if ((edge & 3) == 1) std::tie(a, b, c) = std::tuple(b, c, a);
+            if ((edge & 3) == 2) std::tie(a, b, c) = std::tuple(c, a, b);
+            int const fc  = find_vertex(c);
+            int       fec = fc >= 1 && fc < fec_max ? fc : c == next ? (++next, 0) : 15;
+            if (fec == 15 && c + 1 == last) fec = 13;
+            if (fec == 15 && c == last + 1) fec = 14;
+            code.push_back(static_cast<uint8_t>((edge >> 2) << 4 | fec));
+            if (fec == 15) vbyte(data, zigzag(static_cast<int32_t>(c - last)));
+            if (fec >= fec_max) last = c;
+            if (fec == 0 || fec >= fec_max) push_vertex(c);
+            push_edge(c, b);
+            push_edge(a, c);
+            continue;
+        }
+
+        // start at the next new vertex if there is one
+        if (b == next)
+            std::tie(a, b, c) = std::tuple(b, c, a);
+        else if (c == next)
+            std::tie(a, b, c) = std::tuple(c, a, b);
+        int const fb  = find_vertex(b);
+        int const fc  = find_vertex(c);
+        int const fea = a == next ? (++next, 0) : 15;
+        int const feb = fb >= 0 && fb < 14 ? fb + 1 : b == next ? (++next, 0) : 15;
+        int const fec = fc >= 0 && fc < 14 ? fc + 1 : c == next ? (++next, 0) : 15;
+        auto const aux   = static_cast<uint8_t>(feb << 4 | fec);
+        auto const entry = std::find(aux_table, aux_table + 14, aux) - aux_table;
+        if (fea == 0 && entry < 14)
+            code.push_back(static_cast<uint8_t>(0xf0 | entry));
+        else
+        {
+            code.push_back(fea == 0 ? 0xfe : 0xff);
+            data.push_back(aux);
+        }
+        for (auto [fe, v] : {std::pair{fea, a}, std::pair{feb, b}, std::pair{fec, c}})
+            if (fe == 15)
+            {
+                vbyte(data, zigzag(static_cast<int32_t>(v - last)));
+                last = v;
+            }
+        push_vertex(a);
+        push_vertex(b, feb == 0 || feb == 15);
+        push_vertex(c, fec == 0 || fec == 15);
+        push_edge(b, a);
+        push_edge(c, b);
+        push_edge(a, c);
+    }
+    code.insert(code.end(), data.begin(), data.end());
+    code.insert(code.end(), aux_table, aux_table + 16);
+    return code;
+}
+}  // namespace meshopt_encode
+
+#endif
@@ -0,0 +1,222 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <catch2/catch_test_macros.hpp>
+#include <trivial_gltf/snapshot.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace trivial_gltf;
+
+namespace
+{
+std::pmr::vector<std::byte> bytes(size_t count, unsigned seed)
+{
+    std::pmr::vector<std::byte> out(count);
+    for (size_t i = 0; i != count; ++i) out[i] = static_cast<std::byte>(seed + 7 * i);
+    return out;
+}
+
+bool same(std::span<std::byte const> a, std::span<std::byte const> b) { return std::equal(a.begin(), a.end(), b.begin(), b.end()); }
+
+// a doc that uses every section, with payloads of sizes that do not keep their successors aligned by themselves
+doc sample_doc(std::span<std::byte const> bin)
+{
+    doc d;
+    d.scenes.emplace_back("scene", std::pmr::vector<uint32_t>{0});
+    d.nodes.emplace_back(0, 0, -1, glm::qua<float>(0.5f, 0.5f, 0.5f, 0.5f), glm::vec<3, float>(1, 2, 3), glm::vec<3, float>(4, 5, 6),
+                         std::pmr::vector<uint32_t>{1}, std::pmr::vector<float>{0.25f}, "root");
+    d.nodes.emplace_back();
+    d.nodes.back().name = "child";
+
+    std::pmr::vector<primitive> primitives(1);
+    primitives[0].attributes = {attribute_offset(attribute::position, 0), attribute_offset(attribute::normal, 1)};
+    primitives[0].indices    = 2;
+    primitives[0].material   = 0;
+    primitives[0].mode       = mode_type::triangles_strip;
+    primitives[0].targets.push_back({attribute_offset(attribute::position, 1)});
+    d.meshes.emplace_back("mesh", std::move(primitives), std::pmr::vector<float>{0.25f});
+
+    std::pmr::vector<channel>           channels;
+    std::pmr::vector<animation_sampler> samplers;
+    channels.emplace_back(0, 0, path_type::rotattion);
+    samplers.emplace_back(3, 4, interpolation_type::step);
+    d.animations.emplace_back("animation", std::move(channels), std::move(samplers));
+
+    d.materials.emplace_back("material",
+                             pbr_metallic_roughness{glm::vec<4, float>(1, 0.5f, 0.25f, 1), texture_info{0, 1, "base"}, 0.5f, 0.75f,
+                                                    texture_info{-1, 0, {}}},
+                             normal_texture_info{{0, 0, {}}, 2.0f}, occlusion_texture_info{{-1, 0, {}}, 0.5f}, texture_info{-1, 0, {}},
+                             glm::vec<3, float>(0.1f, 0.2f, 0.3f), alpha_mode_type::mask, 0.4f, true);
+
+    d.accessors.emplace_back(0, 0, 3, component::float_type, attribute_type::vec3, false, std::pmr::vector<float>{1, 1, 1},
+                             std::pmr::vector<float>{0, 0, 0}, sparse_accessor{});
+    d.accessors.emplace_back(0, 12, 2, component::float_type, attribute_type::vec3, false, std::pmr::vector<float>{},
+                             std::pmr::vector<float>{}, sparse_accessor{1, 1, 0, component::unsigned_short_type, 1, 4});
+    d.accessors.emplace_back(1, 0, 3, component::unsigned_short_type, attribute_type::scalar, false, std::pmr::vector<float>{},
+                             std::pmr::vector<float>{}, sparse_accessor{});
+    d.buffer_views.emplace_back(0u, 36u, 0u, 12u, 34962u, meshopt_compression{});
+    d.buffer_views.emplace_back(0u, 6u, 36u, 0u, 34963u, meshopt_compression{2, 0, 5, 2, 3, meshopt_mode::triangles, meshopt_filter::none});
+
+    d.buffers.emplace_back(infile_buffer{bin.size(), bin});
+    d.buffers.emplace_back(embedded_buffer{5, bytes(5, 1)});
+    d.buffers.emplace_back(external_buffer{3, "data.bin", std::span<std::byte const>(bin.first(3))});
+
+    d.skins.emplace_back("skin", 0, -1, std::pmr::vector<uint32_t>{0, 1});
+    d.images.emplace_back(external_image{"external", "image.png"});
+    d.images.emplace_back(infile_image{"infile", "image/png", 1});
+    d.images.emplace_back(embedded_image{"embedded", "image/jpeg", bytes(9, 3)});
+    d.samplers.emplace_back(9729, 9728, 10497, 33071);
+    d.textures.emplace_back(0, 2, "texture");
+    d.extended_attributes.push_back("_CUSTOM");
+    return d;
+}
+}  // namespace
+
+TEST_CASE("snapshots round trip through the view and load_snapshot", "[snapshot]")
+{
+    auto const          bin    = bytes(47, 11);
+    doc const           source = sample_doc(bin);
+    auto const          image  = write_snapshot(source, true);
+    snapshot_view const view(image);
+    REQUIRE(view.valid());
+    REQUIRE(view.buffers().size() == 3);
+    for (auto const& b : view.buffers()) REQUIRE((view.payload(b).data() - image.data()) % 16 == 0);
+    REQUIRE((view.payload(view.images()[2]).data() - image.data()) % 16 == 0);
+
+    doc loaded;
+    REQUIRE(load_snapshot(view, loaded) == parse_state::json_complete);
+
+    REQUIRE(loaded.scenes.size() == 1);
+    REQUIRE(loaded.scenes[0].name == "scene");
+    REQUIRE(loaded.scenes[0].root_nodes == source.scenes[0].root_nodes);
+
+    REQUIRE(loaded.nodes.size() == 2);
+    auto const& n = loaded.nodes[0];
+    REQUIRE(n.mesh == 0);
+    REQUIRE(n.skin == 0);
+    REQUIRE(n.camera == -1);
+    REQUIRE((n.rotaton.x == 0.5f && n.rotaton.y == 0.5f && n.rotaton.z == 0.5f && n.rotaton.w == 0.5f));
+    REQUIRE(n.scale == source.nodes[0].scale);
+    REQUIRE(n.translation == source.nodes[0].translation);
+    REQUIRE(n.children == source.nodes[0].children);
+    REQUIRE(n.weights == source.nodes[0].weights);
+    REQUIRE(n.name == "root");
+    REQUIRE(loaded.nodes[1].name == "child");
+
+    REQUIRE(loaded.meshes.size() == 1);
+    auto const& p = loaded.meshes[0].primitives.at(0);
+    REQUIRE(loaded.meshes[0].name == "mesh");
+    REQUIRE(loaded.meshes[0].weights == source.meshes[0].weights);
+    REQUIRE(p.attributes == source.meshes[0].primitives[0].attributes);
+    REQUIRE(p.indices == 2);
+    REQUIRE(p.material == 0);
+    REQUIRE(p.mode == mode_type::triangles_strip);
+    REQUIRE(p.targets.size() == 1);
+    REQUIRE(p.targets[0] == source.meshes[0].primitives[0].targets[0]);
+
+    REQUIRE(loaded.animations.size() == 1);
+    REQUIRE(loaded.animations[0].name == "animation");
+    REQUIRE(loaded.animations[0].channels.at(0).path == path_type::rotattion);
+    REQUIRE(loaded.animations[0].samplers.at(0).output == 4);
+    REQUIRE(loaded.animations[0].samplers[0].interpolation == interpolation_type::step);
+
+    REQUIRE(loaded.materials.size() == 1);
+    auto const& m = loaded.materials[0];
+    REQUIRE(m.name == "material");
+    REQUIRE(m.data.base_color_factor == source.materials[0].data.base_color_factor);
+    REQUIRE(m.data.base_color_texture.tex_coord == 1);
+    REQUIRE(m.data.base_color_texture.name == "base");
+    REQUIRE(m.data.roughness_factor == 0.75f);
+    REQUIRE(m.normal.scale == 2.0f);
+    REQUIRE(m.occlusion.strength == 0.5f);
+    REQUIRE(m.emssive_factor == source.materials[0].emssive_factor);
+    REQUIRE(m.alpha_mode == alpha_mode_type::mask);
+    REQUIRE(m.alpha_cut_off == 0.4f);
+    REQUIRE(m.double_sided);
+
+    REQUIRE(loaded.accessors.size() == 3);
+    for (size_t i = 0; i != 3; ++i)
+    {
+        auto const &a = loaded.accessors[i], &b = source.accessors[i];
+        REQUIRE((a.view == b.view && a.offset == b.offset && a.count == b.count && a.comp_type == b.comp_type && a.type == b.type));
+        REQUIRE((a.max == b.max && a.min == b.min));
+        REQUIRE((a.sparse.count == b.sparse.count && a.sparse.indices_type == b.sparse.indices_type &&
+                 a.sparse.values_offset == b.sparse.values_offset));
+    }
+    REQUIRE(loaded.buffer_views.size() == 2);
+    REQUIRE(loaded.buffer_views[0].stride == 12);
+    REQUIRE(loaded.buffer_views[1].meshopt.count == 3);
+    REQUIRE(loaded.buffer_views[1].meshopt.mode == meshopt_mode::triangles);
+
+    // the bin chunk is bound into the image, data uris are copied into the doc
+    REQUIRE(loaded.buffers.size() == 3);
+    auto const infile = buffer_data(loaded, 0);
+    REQUIRE(same(infile, bin));
+    REQUIRE(infile.data() >= image.data());
+    REQUIRE(infile.data() < image.data() + image.size());
+    REQUIRE(same(std::get<embedded_buffer>(loaded.buffers[1]).bytes, std::get<embedded_buffer>(source.buffers[1]).bytes));
+    REQUIRE(std::get<external_buffer>(loaded.buffers[2]).uri == "data.bin");
+    REQUIRE(same(buffer_data(loaded, 2), std::span(bin).first(3)));
+
+    REQUIRE(loaded.skins.size() == 1);
+    REQUIRE(loaded.skins[0].joints == source.skins[0].joints);
+    REQUIRE(loaded.images.size() == 3);
+    REQUIRE(std::get<external_image>(loaded.images[0]).uri == "image.png");
+    REQUIRE(std::get<infile_image>(loaded.images[1]).buffer_view == 1);
+    REQUIRE(std::get<embedded_image>(loaded.images[2]).mime == "image/jpeg");
+    REQUIRE(same(std::get<embedded_image>(loaded.images[2]).bytes, std::get<embedded_image>(source.images[2]).bytes));
+    REQUIRE(loaded.samplers.size() == 1);
+    REQUIRE(loaded.samplers[0].wrap_t == 33071);
+    REQUIRE(loaded.textures.size() == 1);
+    REQUIRE(loaded.textures[0].source == 2);
+    REQUIRE(loaded.textures[0].name == "texture");
+    REQUIRE(loaded.extended_attributes == source.extended_attributes);
+}
+
+TEST_CASE("snapshots without embedded buffers keep only the decoded data uris", "[snapshot]")
+{
+    auto const          bin   = bytes(20, 5);
+    auto const          image = write_snapshot(sample_doc(bin), false);
+    snapshot_view const view(image);
+    doc                 loaded;
+    REQUIRE(load_snapshot(view, loaded) == parse_state::json_complete);
+    REQUIRE(buffer_data(loaded, 0).empty());
+    REQUIRE(buffer_data(loaded, 1).size() == 5);
+    REQUIRE(buffer_data(loaded, 2).empty());
+}
+
+TEST_CASE("snapshot views refuse damaged and misaligned images", "[snapshot]")
+{
+    auto const bin   = bytes(47, 11);
+    auto const image = write_snapshot(sample_doc(bin), true);
+    REQUIRE(snapshot_view(image).valid());
+    REQUIRE_FALSE(snapshot_view(std::span(image).first(image.size() - 1)).valid());
+    REQUIRE_FALSE(snapshot_view(std::span(image).first(sizeof(snapshot_header) - 1)).valid());
+
+    auto damaged = [&image](auto&& change)
+    {
+        auto            copy = image;
+        snapshot_header h;
+        std::memcpy(&h, copy.data(), sizeof h);
+        change(h);
+        std::memcpy(copy.data(), &h, sizeof h);
+        return snapshot_view(copy).valid();
+    };
+    REQUIRE_FALSE(damaged([](snapshot_header& h) { h.magic[0] = 'X'; }));
+    REQUIRE_FALSE(damaged([](snapshot_header& h) { h.version -= 1; }));
+    REQUIRE_FALSE(damaged([](snapshot_header& h) { h.sections[0].count = h.size; }));
+    REQUIRE_FALSE(damaged([](snapshot_header& h) { h.sections[static_cast<size_t>(snapshot_section::payload)].offset -= 8; }));
+
+    // an image that does not start at a section aligned address
+    std::vector<std::byte> shifted(image.size() + 4);
+    std::memcpy(shifted.data() + 4, image.data(), image.size());
+    REQUIRE_FALSE(snapshot_view(std::span(shifted).subspan(4)).valid());
+
+    doc loaded;
+    REQUIRE(load_snapshot(snapshot_view{}, loaded) == parse_state::error);
+}
@@ -0,0 +1,213 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#ifndef TRIVIAL_GLTF_SYNTHETIC_GLTF_H_INCLUDED
+#define TRIVIAL_GLTF_SYNTHETIC_GLTF_H_INCLUDED
+
+#include <string>
+
+// Shape of a generated document. Every primitive gets four attribute accessors, an index accessor and two
+// buffer views, every animation channel its own sampler.
+struct synthetic_scene
+{
+    size_t nodes{64};
+    size_t meshes{16};
+    size_t primitives{4};  // per mesh
+    size_t animations{2};
+    size_t channels{16};  // per animation
+    size_t name_length{12};
+    size_t extra_attributes{0};  // per primitive, beyond the four core attributes
+};
+
+// Deterministic gltf json document of the given shape, the same input always gives the same bytes.
+inline std::string synthetic_gltf(synthetic_scene const& shape)
+{
+    std::string out;
+    out.reserve((shape.nodes + shape.meshes * shape.primitives * 4 + shape.animations * shape.channels) * (200 + shape.name_length));
+
+    auto const number = [&](size_t v) { out += std::to_string(v); };
+    auto const name   = [&](char const* prefix, size_t i)
+    {
+        auto const start = out.size();
+        out += "\"name\":\"";
+        out += prefix;
+        number(i);
+        while (out.size() - start - 8 < shape.name_length) out += static_cast<char>('a' + (out.size() + i) % 26);
+        out += "\",";
+    };
+    auto const list = [&](char const* key, size_t count, auto&& element)
+    {
+        out += '"';
+        out += key;
+        out += "\":[";
+        for (size_t i = 0; i != count; ++i)
+        {
+            if (i) out += ',';
+            element(i);
+        }
+        out += "],";
+    };
+
+    size_t const primitive_count = shape.meshes * shape.primitives;
+    size_t const anim_accessor   = primitive_count * 5;  // time, vec3 output, vec4 output
+    size_t const anim_view       = primitive_count * 2;
+    size_t const vertex_bytes    = 24 * 48;
+    size_t const index_bytes     = 36 * 2;
+
+    out += "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"name\":\"scene\",\"nodes\":[0]}],";
+    list("nodes", shape.nodes,
+         [&](size_t i)
+         {
+             out += '{';
+             name("node_", i);
+             if (shape.meshes)
+             {
+                 out += "\"mesh\":";
+                 number(i % shape.meshes);
+                 out += ',';
+             }
+             if (2 * i + 1 < shape.nodes)
+             {
+                 out += "\"children\":[";
+                 number(2 * i + 1);
+                 if (2 * i + 2 < shape.nodes)
+                 {
+                     out += ',';
+                     number(2 * i + 2);
+                 }
+                 out += "],";
+             }
+             out += "\"translation\":[";
+             number(i % 17);
+             out += ",0.5,-2.25],\"rotation\":[0,0.7071068,0,0.7071068],\"scale\":[1,2,1]}";
+         });
+    list("materials", 1,
+         [&](size_t i)
+         {
+             out += '{';
+             name("material_", i);
+             out +=
+                 "\"pbrMetallicRoughness\":{\"baseColorFactor\":[1,0.5,0.25,1],\"baseColorTexture\":{\"index\":0},\"metallicFactor\":0.25,"
+                 "\"roughnessFactor\":0.75},\"normalTexture\":{\"index\":0,\"scale\":1.0},\"alphaMode\":\"MASK\",\"doubleSided\":true}";
+         });
+    list("meshes", shape.meshes,
+         [&](size_t m)
+         {
+             out += '{';
+             name("mesh_", m);
+             list("primitives", shape.primitives,
+                  [&](size_t p)
+                  {
+                      auto const a = (m * shape.primitives + p) * 5;
+                      out += "{\"attributes\":{\"POSITION\":";
+                      number(a);
+                      out += ",\"NORMAL\":";
+                      number(a + 1);
+                      out += ",\"TANGENT\":";
+                      number(a + 2);
+                      out += ",\"TEXCOORD_0\":";
+                      number(a + 3);
+                      for (size_t e = 0; e != shape.extra_attributes; ++e)
+                      {
+                          static char const* const extra[] = {"TEXCOORD_1", "COLOR_0",   "JOINTS_0", "WEIGHTS_0",
+                                                              "TEXCOORD_2", "JOINTS_1",  "WEIGHTS_1", "_BATCHID"};
+                          out += ",\"";
+                          out += e < 8 ? extra[e] : "_CUSTOM_" + std::to_string(e);
+                          out += "\":";
+                          number(a + 3);
+                      }
+                      out += "},\"indices\":";
+                      number(a + 4);
+                      out += ",\"material\":0,\"mode\":4}";
+                  });
+             out.back() = '}';
+         });
+    list("animations", shape.animations,
+         [&](size_t i)
+         {
+             out += '{';
+             name("animation_", i);
+             list("channels", shape.channels,
+                  [&](size_t c)
+                  {
+                      static char const* const paths[] = {"translation", "rotation", "scale"};
+                      out += "{\"sampler\":";
+                      number(c);
+                      out += ",\"target\":{\"node\":";
+                      number(shape.nodes ? (i * shape.channels + c) % shape.nodes : 0);
+                      out += ",\"path\":\"";
+                      out += paths[c % 3];
+                      out += "\"}}";
+                  });
+             list("samplers", shape.channels,
+                  [&](size_t c)
+                  {
+                      out += "{\"input\":";
+                      number(anim_accessor);
+                      out += ",\"output\":";
+                      number(anim_accessor + (c % 3 == 1 ? 2 : 1));
+                      out += ",\"interpolation\":\"LINEAR\"}";
+                  });
+             out.back() = '}';
+         });
+    list("accessors", primitive_count * 5 + 3,
+         [&](size_t a)
+         {
+             static char const* const types[] = {"VEC3", "VEC3", "VEC4", "VEC2"};
+             if (a >= anim_accessor)
+             {
+                 out += "{\"bufferView\":";
+                 number(anim_view);
+                 static char const* const tracks[] = {
+                     ",\"byteOffset\":0,\"componentType\":5126,\"count\":32,\"type\":\"SCALAR\",\"max\":[1],\"min\":[0]}",
+                     ",\"byteOffset\":128,\"componentType\":5126,\"count\":32,\"type\":\"VEC3\"}",
+                     ",\"byteOffset\":512,\"componentType\":5126,\"count\":32,\"type\":\"VEC4\"}"};
+                 out += tracks[a - anim_accessor];
+                 return;
+             }
+             auto const view = a / 5 * 2;
+             out += "{\"bufferView\":";
+             if (a % 5 == 4)
+             {
+                 number(view + 1);
+                 out += ",\"componentType\":5123,\"count\":36,\"type\":\"SCALAR\"}";
+                 return;
+             }
+             number(view);
+             out += ",\"byteOffset\":";
+             number((a % 5) * 12 + (a % 5 == 3 ? 4 : 0));
+             out += ",\"componentType\":5126,\"count\":24,\"type\":\"";
+             out += types[a % 5];
+             out += a % 5 == 0 ? "\",\"max\":[1,1,1],\"min\":[-1,-1,-1]}" : "\"}";
+         });
+    list("bufferViews", primitive_count * 2 + 1,
+         [&](size_t v)
+         {
+             auto const offset = v / 2 * (vertex_bytes + index_bytes);
+             out += "{\"buffer\":0,\"byteOffset\":";
+             if (v == anim_view)
+             {
+                 number(offset);
+                 out += ",\"byteLength\":1024}";
+             }
+             else if (v % 2 == 0)
+             {
+                 number(offset);
+                 out += ",\"byteLength\":1152,\"byteStride\":48,\"target\":34962}";
+             }
+             else
+             {
+                 number(offset + vertex_bytes);
+                 out += ",\"byteLength\":72,\"target\":34963}";
+             }
+         });
+    out += "\"buffers\":[{\"byteLength\":";
+    number(primitive_count * (vertex_bytes + index_bytes) + 1024);
+    out += ",\"uri\":\"data.bin\"}]}";
+    return out;
+}
+
+#endif
@@ -0,0 +1,132 @@
+/* ==========================================================================
+ Copyright (c) 2021 Andreas Pokorny
+ Distributed under the Boost Software License, Version 1.0. (See accompanying
+ file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+========================================================================== */
+
+#include <catch2/catch_test_macros.hpp>
+#include <trivial_gltf/accessor_decode.h>
+#include <trivial_gltf/topology.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace trivial_gltf;
+
+namespace
+{
+constexpr simd_level levels[] = {simd_level::scalar, simd_level::sse2, simd_level::avx2};
+constexpr mode_type  modes[]  = {mode_type::points,    mode_type::lines,           mode_type::line_loop,   mode_type::line_strip,
+                                 mode_type::triangles, mode_type::triangles_strip, mode_type::triangle_fan};
+
+// the expansion written out primitive by primitive, as the gltf spec defines the modes
+std::vector<uint32_t> reference_list(mode_type m, std::vector<uint32_t> const& v)
+{
+    std::vector<uint32_t> out;
+    auto const            n = v.size();
+    switch (m)
+    {
+        case mode_type::points: out = v; break;
+        case mode_type::lines: out.assign(v.begin(), v.begin() + n / 2 * 2); break;
+        case mode_type::triangles: out.assign(v.begin(), v.begin() + n / 3 * 3); break;
+        case mode_type::line_loop:
+        case mode_type::line_strip:
+            for (size_t i = 0; i + 1 < n; ++i) out.insert(out.end(), {v[i], v[i + 1]});
+            if (m == mode_type::line_loop && n >= 2) out.insert(out.end(), {v[n - 1], v[0]});
+            break;
+        case mode_type::triangles_strip:
+            for (size_t i = 0; i + 2 < n; ++i)
+            {
+                auto const a = v[i], b = i % 2 ? v[i + 2] : v[i + 1], c = i % 2 ? v[i + 1] : v[i + 2];
+                if (a != b && b != c && c != a) out.insert(out.end(), {a, b, c});
+            }
+            break;
+        case mode_type::triangle_fan:
+            for (size_t i = 1; i + 1 < n; ++i) out.insert(out.end(), {v[i], v[i + 1], v[0]});
+            break;
+    }
+    return out;
+}
+
+// sequential, random around the restart value, and from a few values only so that strips get degenerate triangles
+std::vector<std::vector<uint32_t>> index_inputs(size_t n, std::mt19937& rng)
+{
+    std::vector<std::vector<uint32_t>> inputs(3, std::vector<uint32_t>(n));
+    for (size_t i = 0; i != n; ++i)
+    {
+        inputs[0][i] = static_cast<uint32_t>(i);
+        inputs[1][i] = 0xfffc + rng() % 6;
+        inputs[2][i] = rng() % 3;
+    }
+    return inputs;
+}
+}  // namespace
+
+TEST_CASE("topology expansion agrees with the reference on every level", "[topology]")
+{
+    std::mt19937 rng(11);
+    for (size_t n = 0; n <= 40; ++n)
+        for (auto const& input : index_inputs(n, rng))
+            for (auto m : modes)
+            {
+                auto const expected = reference_list(m, input);
+                for (auto level : levels)
+                {
+                    INFO("mode " << static_cast<int>(m) << " length " << n << " level " << static_cast<int>(level));
+                    force_simd_level(level);
+                    std::vector<uint32_t> out = {7};  // appended behind what is already there
+                    expand_to_list(m, input, out);
+                    REQUIRE(out.size() == expected.size() + 1);
+                    REQUIRE(std::equal(expected.begin(), expected.end(), out.begin() + 1));
+                }
+            }
+    force_simd_level(simd_level::avx2);
+}
+
+TEST_CASE("narrowing keeps the values below the restart value on every level", "[topology]")
+{
+    std::mt19937 rng(5);
+    for (size_t n = 0; n <= 40; ++n)
+    {
+        std::vector<uint32_t> input(n);
+        for (auto& v : input) v = rng() % 2 ? 0xffff - rng() % 4 : rng() % 0x10000;
+        for (auto level : levels)
+        {
+            force_simd_level(level);
+            std::vector<uint16_t> out(n);
+            narrow_to_uint16(input, out.data());
+            for (size_t i = 0; i != n; ++i) REQUIRE(out[i] == input[i]);
+        }
+    }
+    force_simd_level(simd_level::avx2);
+}
+
+TEST_CASE("normalized indices use 32 bit once they reach the restart value", "[topology]")
+{
+    for (uint32_t top : {0xfffeu, 0xffffu})
+    {
+        std::vector<uint32_t> const indices = {0, 1, top, 2};
+        std::vector<std::byte>      bytes(indices.size() * 4);
+        std::memcpy(bytes.data(), indices.data(), bytes.size());
+
+        doc d;
+        d.buffers.emplace_back(infile_buffer{bytes.size(), std::span<std::byte const>(bytes)});
+        d.buffer_views.emplace_back(0u, static_cast<uint32_t>(bytes.size()), 0u, 0u, 0u, meshopt_compression{});
+        d.accessors.push_back(accessor{0, 0, 4, component::unsigned_int_type, attribute_type::scalar, false, {}, {}, sparse_accessor{}});
+        std::pmr::vector<primitive> primitives(1);
+        primitives[0].indices = 0;
+        primitives[0].mode    = mode_type::triangles_strip;
+        d.meshes.push_back(mesh{"strip", std::move(primitives), {}});
+
+        std::vector<std::byte> arena;
+        REQUIRE(normalize_topology(d, arena) == 1);
+        auto const& p   = d.meshes[0].primitives[0];
+        auto const& acc = d.accessors[p.indices];
+        REQUIRE(p.mode == mode_type::triangles);
+        REQUIRE(acc.comp_type == (top == 0xfffe ? component::unsigned_short_type : component::unsigned_int_type));
+        std::vector<uint32_t> out(acc.count);
+        REQUIRE(widen_indices(d, acc, out) == 6);
+        REQUIRE(out == std::vector<uint32_t>{0, 1, top, 1, 2, top});
+    }
+}